@@ -0,0 +1,816 @@
+/* opra-bench.c
+ *
+ * Throughput benchmark for the OPRA decode core and dissector, built as the opra_bench target.
+ * Generates synthetic blocks, every category and every quote indicator including the CGKO and MNOP appendage
+ * variants, at a given category mix and block fill level, then times each stage of the decode core over them
+ * and reports ns/message and messages/s.  With --tshark the same blocks are written to a capture and tshark is
+ * timed reading it with a tree, without one and with only a tap listening.  Those are end-to-end times of a whole
+ * run, process start, file reading and output included, so they are reported per run and not per message.
+ * With --corpus each block is also written to a file of its own, the seed corpus of opra_fuzz.  With --lines the
+ * blocks are dealt in turn to that many lines, each numbered on its own, with series of its own and sent to the next
+ * destination port up.
+ * Links only the decode core, no epan, so it runs anywhere the core builds.
+ *
+ *   opra_bench [--blocks N] [--mix q=70,k=15,...] [--appendages PCT] [--fill PCT] [--instruments N]
+ *              [--seed N] [--repeat N] [--pcap FILE] [--tshark PATH] [--port N] [--lines N] [--corpus DIR]
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*clock_gettime() and CLOCK_MONOTONIC are POSIX, not C11*/
+#define _POSIX_C_SOURCE 200809L
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "opra-decode.h"
+#include "opra-price.h"
+#include "opra-book.h"
+#include "opra-checksum.h"
+#include "opra-pool.h"
+
+/*the largest block OPRA sends*/
+#define OPRA_BENCH_MAX_BLOCK_SIZE 1000
+#define OPRA_BENCH_MAX_MESSAGES 255
+
+/*--lines at most*/
+#define OPRA_BENCH_MAX_LINES 16
+
+/*longest administrative text the generator writes, see opra_bench_put_message()*/
+#define OPRA_BENCH_MAX_TEXT 64
+
+/*categories in the order --mix lists them, with the default mix: mostly quotes, as on a busy day*/
+static const uint8_t opra_bench_categories[] = { 'q', 'k', 'a', 'Y', 'd', 'f', 'C', 'H' };
+#define OPRA_BENCH_CATEGORIES (sizeof(opra_bench_categories) / sizeof(opra_bench_categories[0]))
+static const unsigned opra_bench_default_mix[OPRA_BENCH_CATEGORIES] = { 70, 15, 8, 3, 1, 1, 1, 1 };
+
+/*message types the generator picks from, per category*/
+static const char *opra_bench_types[256] = {
+    ['q'] = " ABOCXY",
+    ['k'] = " ABOCXY",
+    ['a'] = " ABCDFGHIJKLMNOPQRSTUVWXYZ",
+    ['Y'] = " I",
+    ['d'] = " ",
+    ['f'] = " ",
+    ['C'] = " ",
+    ['H'] = "CEFJLMN",      /*not K, a reset would make every later block the first of its line*/
+};
+
+/*quote indicators with and without appendages*/
+static const char opra_bench_plain_indicators[] = "ABDEFHIJL";
+static const char opra_bench_appendage_indicators[] = "CGKOMNP";
+
+static const char opra_bench_participants[] = "ABCDEHIJMNOPQTWXZ";
+
+typedef struct _opra_bench_config {
+    unsigned blocks;
+    unsigned mix[OPRA_BENCH_CATEGORIES];
+    unsigned appendage_percent;     /*quotes sent with a CGKO or MNOP indicator*/
+    unsigned fill_percent;          /*blocks are filled to this share of the largest block*/
+    unsigned instruments;
+    uint64_t seed;
+    unsigned repeat;                /*each stage is timed this many times, the fastest run counts*/
+    const char *pcap_path;
+    const char *tshark_path;
+    unsigned port;                  /*of the first line*/
+    unsigned lines;
+    const char *corpus_path;
+} opra_bench_config;
+
+/*a series the generator sends, short quote ready: 4 character root and strike in tenths*/
+typedef struct _opra_bench_instrument {
+    uint8_t symbol[OPRA_SECURITY_SYMBOL_SIZE];
+    uint8_t expiration[OPRA_EXPIRATION_BLOCK_SIZE];
+    uint16_t strike;
+} opra_bench_instrument;
+
+typedef struct _opra_bench_traffic {
+    uint8_t *data;                  /*blocks back to back*/
+    size_t length;
+    uint32_t *offsets;              /*of each block in data*/
+    unsigned block_count;
+    uint64_t message_count;
+    uint64_t category_counts[256];
+} opra_bench_traffic;
+
+/*xorshift64*, good enough to spread the traffic and the same on every platform*/
+static uint64_t opra_bench_random_state;
+
+static uint64_t opra_bench_random(void)
+{
+    uint64_t x = opra_bench_random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    opra_bench_random_state = x;
+    return x * UINT64_C(2685821657736338717);
+}
+
+static unsigned opra_bench_random_below(unsigned n)
+{
+    return (unsigned) (opra_bench_random() % n);
+}
+
+static uint8_t opra_bench_pick(const char *choices)
+{
+    return (uint8_t) choices[opra_bench_random_below((unsigned) strlen(choices))];
+}
+
+static uint8_t *opra_bench_put_uint16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t) (value >> 8);
+    p[1] = (uint8_t) value;
+    return p + 2;
+}
+
+static uint8_t *opra_bench_put_uint32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t) (value >> 24);
+    p[1] = (uint8_t) (value >> 16);
+    p[2] = (uint8_t) (value >> 8);
+    p[3] = (uint8_t) value;
+    return p + 4;
+}
+
+static uint8_t *opra_bench_put_bytes(uint8_t *p, const uint8_t *bytes, size_t length)
+{
+    memcpy(p, bytes, length);
+    return p + length;
+}
+
+static opra_bench_instrument *opra_bench_make_instruments(unsigned count)
+{
+    opra_bench_instrument *instruments = (opra_bench_instrument *) calloc(count, sizeof(opra_bench_instrument));
+    if (NULL == instruments)
+        return NULL;
+
+    for (unsigned i = 0; i < count; i++){
+        opra_bench_instrument *instrument = &instruments[i];
+        /*a few hundred roots with many series each, as listed options are*/
+        unsigned root = i % 457;
+        const unsigned root_length = 1 + (root % 4);
+        memset(instrument->symbol, ' ', OPRA_SECURITY_SYMBOL_SIZE);
+        for (unsigned c = 0; c < root_length; c++){
+            instrument->symbol[c] = (uint8_t) ('A' + (root % 26));
+            root = root / 26 + c + 1;
+        }
+        instrument->expiration[0] = (uint8_t) ('A' + opra_bench_random_below(24));
+        instrument->expiration[1] = (uint8_t) (1 + opra_bench_random_below(28));
+        instrument->expiration[2] = (uint8_t) (26 + opra_bench_random_below(3));
+        instrument->strike = (uint16_t) (10 + opra_bench_random_below(20000));
+    }
+    return instruments;
+}
+
+/*A series sent on the line.  The lines share the series out, so each is only ever sent on one, as on OPRA.*/
+static const opra_bench_instrument *opra_bench_pick_instrument(const opra_bench_config *config, const opra_bench_instrument *instruments,
+    unsigned line)
+{
+    const unsigned count = (config->instruments - line + config->lines - 1) / config->lines;
+    return &instruments[opra_bench_random_below(count) * config->lines + line];
+}
+
+/*body size of a message of the category, including its appendages and text*/
+static unsigned opra_bench_message_size(uint8_t message_category, uint8_t message_indicator, unsigned text_length)
+{
+    const opra_category_info *info = opra_category_lookup(message_category);
+    unsigned size = OPRA_MESSAGE_HEADER_SIZE + info->body_size;
+    if (info->flags & OPRA_CATEGORY_QUOTE)
+        size += opra_quote_appendage_count(message_indicator) * OPRA_QUOTE_APPENDAGE_SIZE;
+    if (info->flags & OPRA_CATEGORY_VARIABLE_LENGTH)
+        size += text_length;
+    return size;
+}
+
+static uint8_t *opra_bench_put_series(uint8_t *p, const opra_bench_instrument *instrument)
+{
+    p = opra_bench_put_bytes(p, instrument->symbol, OPRA_SECURITY_SYMBOL_SIZE);
+    *p++ = ' ';
+    p = opra_bench_put_bytes(p, instrument->expiration, OPRA_EXPIRATION_BLOCK_SIZE);
+    *p++ = 'A';     /*strikes in tenths, the same series as a short quote's*/
+    return opra_bench_put_uint32(p, instrument->strike);
+}
+
+static uint8_t *opra_bench_put_appendages(uint8_t *p, uint8_t message_indicator)
+{
+    const uint8_t flags = opra_indicator_table[message_indicator];
+    for (unsigned side = 0; side < 2; side++){
+        if (!(flags & ((0 == side) ? OPRA_INDICATOR_BID_APPENDAGE : OPRA_INDICATOR_OFFER_APPENDAGE)))
+            continue;
+        *p++ = opra_bench_pick(opra_bench_participants);
+        *p++ = 'B';
+        p = opra_bench_put_uint32(p, 5 + opra_bench_random_below(50000));
+        p = opra_bench_put_uint32(p, 1 + opra_bench_random_below(1000));
+    }
+    return p;
+}
+
+/*Write one message at p, which has room for it, and return its end*/
+static uint8_t *opra_bench_put_message(uint8_t *p, uint8_t message_category, uint8_t message_indicator, unsigned text_length,
+    const opra_bench_instrument *instrument)
+{
+    static uint32_t transaction_id;
+    static const char text[] = "SYNTHETIC ADMINISTRATIVE TEXT FOR THE OPRA THROUGHPUT BENCHMARK..";
+
+    *p++ = opra_bench_pick(opra_bench_participants);
+    *p++ = message_category;
+    *p++ = opra_bench_pick(opra_bench_types[message_category]);
+    *p++ = message_indicator;
+    p = opra_bench_put_uint32(p, ++transaction_id);
+    p = opra_bench_put_uint32(p, (uint32_t) opra_bench_random());
+
+    const uint32_t bid = 5 + opra_bench_random_below(50000);
+    switch(message_category)
+    {
+        case 'q':
+            p = opra_bench_put_bytes(p, instrument->symbol, OPRA_SHORT_SECURITY_SYMBOL_SIZE);
+            p = opra_bench_put_bytes(p, instrument->expiration, OPRA_EXPIRATION_BLOCK_SIZE);
+            p = opra_bench_put_uint16(p, instrument->strike);
+            p = opra_bench_put_uint16(p, (uint16_t) (bid % 60000));
+            p = opra_bench_put_uint16(p, (uint16_t) (1 + opra_bench_random_below(500)));
+            p = opra_bench_put_uint16(p, (uint16_t) (bid % 60000 + 1 + opra_bench_random_below(20)));
+            p = opra_bench_put_uint16(p, (uint16_t) (1 + opra_bench_random_below(500)));
+            return opra_bench_put_appendages(p, message_indicator);
+        case 'k':
+            p = opra_bench_put_series(p, instrument);
+            *p++ = 'B';
+            p = opra_bench_put_uint32(p, bid);
+            p = opra_bench_put_uint32(p, 1 + opra_bench_random_below(5000));
+            p = opra_bench_put_uint32(p, bid + 1 + opra_bench_random_below(20));
+            p = opra_bench_put_uint32(p, 1 + opra_bench_random_below(5000));
+            return opra_bench_put_appendages(p, message_indicator);
+        case 'a':
+            p = opra_bench_put_series(p, instrument);
+            p = opra_bench_put_uint32(p, 1 + opra_bench_random_below(1000));
+            *p++ = 'B';
+            p = opra_bench_put_uint32(p, bid);
+            p = opra_bench_put_uint32(p, (uint32_t) opra_bench_random());
+            return opra_bench_put_uint32(p, 0);
+        case 'd':
+            p = opra_bench_put_series(p, instrument);
+            return opra_bench_put_uint32(p, opra_bench_random_below(1000000));
+        case 'f':
+            p = opra_bench_put_series(p, instrument);
+            p = opra_bench_put_uint32(p, opra_bench_random_below(100000));
+            p = opra_bench_put_uint32(p, opra_bench_random_below(1000000));
+            *p++ = 'B';
+            p = opra_bench_put_uint32(p, bid);
+            p = opra_bench_put_uint32(p, bid + 50);
+            p = opra_bench_put_uint32(p, bid > 50 ? bid - 50 : 0);
+            p = opra_bench_put_uint32(p, bid + 10);
+            p = opra_bench_put_uint32(p, 10);
+            *p++ = 'B';
+            p = opra_bench_put_uint32(p, 100000 + opra_bench_random_below(100000));
+            p = opra_bench_put_uint32(p, bid);
+            return opra_bench_put_uint32(p, bid + 5);
+        case 'Y':
+            p = opra_bench_put_bytes(p, instrument->symbol, OPRA_SECURITY_SYMBOL_SIZE);
+            *p++ = ' ';
+            *p++ = 'B';
+            p = opra_bench_put_uint32(p, 100000 + opra_bench_random_below(1000000));
+            return opra_bench_put_uint32(p, 0);
+        case 'C':
+            p = opra_bench_put_uint16(p, (uint16_t) text_length);
+            return opra_bench_put_bytes(p, (const uint8_t *) text, text_length);
+        default:
+            /*'H' has no body*/
+            return p;
+    }
+}
+
+static uint8_t opra_bench_pick_category(const opra_bench_config *config, unsigned mix_total)
+{
+    unsigned pick = opra_bench_random_below(mix_total);
+    for (unsigned i = 0; i < OPRA_BENCH_CATEGORIES; i++){
+        if (pick < config->mix[i])
+            return opra_bench_categories[i];
+        pick -= config->mix[i];
+    }
+    return 'q';
+}
+
+static bool opra_bench_generate(const opra_bench_config *config, opra_bench_traffic *traffic)
+{
+    unsigned mix_total = 0;
+    for (unsigned i = 0; i < OPRA_BENCH_CATEGORIES; i++)
+        mix_total += config->mix[i];
+
+    memset(traffic, 0, sizeof(*traffic));
+    traffic->data = (uint8_t *) malloc((size_t) config->blocks * OPRA_BENCH_MAX_BLOCK_SIZE);
+    traffic->offsets = (uint32_t *) malloc((size_t) config->blocks * sizeof(uint32_t));
+    opra_bench_instrument *instruments = opra_bench_make_instruments(config->instruments);
+    if ((NULL == traffic->data) || (NULL == traffic->offsets) || (NULL == instruments)){
+        free(instruments);
+        return false;
+    }
+
+    const unsigned fill = OPRA_BENCH_MAX_BLOCK_SIZE * config->fill_percent / 100;
+    uint32_t sequence_numbers[OPRA_BENCH_MAX_LINES];
+    for (unsigned l = 0; l < OPRA_BENCH_MAX_LINES; l++)
+        sequence_numbers[l] = 1;
+    uint8_t *p = traffic->data;
+    for (unsigned b = 0; b < config->blocks; b++){
+        const unsigned line = b % config->lines;
+        uint32_t *sequence_number = &sequence_numbers[line];
+        uint8_t *block = p;
+        uint8_t *end = block + OPRA_BLOCK_HEADER_SIZE;
+        unsigned messages = 0;
+
+        /*messages until the next one would take the block past the fill level, at least one*/
+        for (;;){
+            const uint8_t message_category = (0 != mix_total) ? opra_bench_pick_category(config, mix_total) : 'q';
+            uint8_t message_indicator = ' ';
+            if (opra_category_lookup(message_category)->flags & OPRA_CATEGORY_QUOTE){
+                message_indicator = (opra_bench_random_below(100) < config->appendage_percent) ?
+                    opra_bench_pick(opra_bench_appendage_indicators) : opra_bench_pick(opra_bench_plain_indicators);
+            }
+            const unsigned text_length = 1 + opra_bench_random_below(OPRA_BENCH_MAX_TEXT);
+            const unsigned size = opra_bench_message_size(message_category, message_indicator, text_length);
+            if ((0 != messages) && ((unsigned) (end - block) + size > fill))
+                break;
+            if (((unsigned) (end - block) + size + 1 > OPRA_BENCH_MAX_BLOCK_SIZE) || (OPRA_BENCH_MAX_MESSAGES == messages))
+                break;
+
+            end = opra_bench_put_message(end, message_category, message_indicator, text_length,
+                opra_bench_pick_instrument(config, instruments, line));
+            messages++;
+            traffic->category_counts[message_category]++;
+        }
+        if ((end - block) % 2)
+            *end++ = 0;     /*blocks are padded to an even size*/
+
+        const uint32_t nsecs = (uint32_t) (((uint64_t) b * 1000) % 1000000000);
+        uint8_t *h = block;
+        *h++ = OPRA_BLOCK_VERSION;
+        h = opra_bench_put_uint16(h, (uint16_t) (end - block));
+        *h++ = 'O';
+        *h++ = ' ';
+        *h++ = 0;
+        h = opra_bench_put_uint32(h, *sequence_number);
+        *h++ = (uint8_t) messages;
+        h = opra_bench_put_uint32(h, 1700000000 + (uint32_t) (((uint64_t) b * 1000) / 1000000000));
+        h = opra_bench_put_uint32(h, nsecs);
+        opra_bench_put_uint16(h, 0);
+        opra_bench_put_uint16(block + OPRA_BLOCK_CHECKSUM_OFFSET, opra_block_checksum(block, (size_t) (end - block)));
+
+        traffic->offsets[b] = (uint32_t) (block - traffic->data);
+        traffic->message_count += messages;
+        *sequence_number += messages;
+        p = end;
+    }
+    traffic->block_count = config->blocks;
+    traffic->length = (size_t) (p - traffic->data);
+    free(instruments);
+    return true;
+}
+
+static uint64_t opra_bench_now_ns(void)
+{
+    struct timespec ts;
+#ifdef _WIN32
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+/*a stage of the decode core, run once over all the traffic.  Returns a value that depends on the work done,
+  so the compiler can't leave any of it out.*/
+typedef uint64_t (*opra_bench_stage)(const opra_bench_traffic *traffic, void *context);
+
+/*block headers and message boundaries only, as for skipped categories*/
+static uint64_t opra_bench_walk(const opra_bench_traffic *traffic, void *context)
+{
+    (void) context;
+    uint64_t result = 0;
+    opra_block_iter blocks;
+    opra_block block;
+    opra_block_iter_init(&blocks, traffic->data, traffic->length);
+    while (OPRA_DECODE_OK == opra_block_iter_next(&blocks, &block)){
+        opra_message_iter iter;
+        opra_message_iter_init(&iter, &block);
+        while (OPRA_DECODE_OK == opra_message_iter_skip(&iter))
+            result++;
+    }
+    return result;
+}
+
+/*every message decoded*/
+static uint64_t opra_bench_decode(const opra_bench_traffic *traffic, void *context)
+{
+    (void) context;
+    uint64_t result = 0;
+    opra_block_iter blocks;
+    opra_block block;
+    opra_message msg;
+    opra_block_iter_init(&blocks, traffic->data, traffic->length);
+    while (OPRA_DECODE_OK == opra_block_iter_next(&blocks, &block)){
+        opra_message_iter iter;
+        opra_message_iter_init(&iter, &block);
+        while (OPRA_DECODE_OK == opra_message_iter_next(&iter, &msg))
+            result += msg.length + msg.appendage_count;
+    }
+    return result;
+}
+
+/*what the dissector's first pass does per message: decode, intern the series, apply quotes to its top of book*/
+typedef struct _opra_bench_series {
+    opra_instrument_key key;        /*first, opra_table takes a record's key from its start*/
+    opra_book_top top;
+} opra_bench_series;
+
+typedef struct _opra_bench_books {
+    opra_arena arena;
+    opra_table table;
+} opra_bench_books;
+
+static uint64_t opra_bench_book(const opra_bench_traffic *traffic, void *context)
+{
+    opra_bench_books *books = (opra_bench_books *) context;
+    uint64_t result = 0;
+    opra_block_iter blocks;
+    opra_block block;
+    opra_message msg;
+    opra_block_iter_init(&blocks, traffic->data, traffic->length);
+    while (OPRA_DECODE_OK == opra_block_iter_next(&blocks, &block)){
+        opra_message_iter iter;
+        opra_message_iter_init(&iter, &block);
+        while (OPRA_DECODE_OK == opra_message_iter_next(&iter, &msg)){
+            opra_instrument_key key;
+            if (!opra_message_instrument(&msg, &key))
+                continue;
+            const uint32_t hash = opra_table_hash(&key, sizeof(key));
+            opra_bench_series *book = (opra_bench_series *) opra_table_find(&books->table, &key, hash);
+            if (NULL == book){
+                book = (opra_bench_series *) opra_arena_alloc(&books->arena, sizeof(opra_bench_series));
+                if (NULL == book)
+                    continue;
+                book->key = key;
+                opra_book_top_init(&book->top);
+                (void) opra_table_insert(&books->table, book, hash);
+            }
+            if (opra_book_apply(&book->top, &msg, NULL))
+                result++;
+        }
+    }
+    return result;
+}
+
+/*the checksum of every block, as with the check_checksum preference*/
+static uint64_t opra_bench_checksum(const opra_bench_traffic *traffic, void *context)
+{
+    (void) context;
+    uint64_t result = 0;
+    for (unsigned b = 0; b < traffic->block_count; b++){
+        const uint8_t *block = traffic->data + traffic->offsets[b];
+        const size_t block_size = ((size_t) block[OPRA_BLOCK_SIZE_OFFSET] << 8) | block[OPRA_BLOCK_SIZE_OFFSET + 1];
+        result += opra_block_checksum(block, block_size);
+    }
+    return result;
+}
+
+static void opra_bench_report(const char *name, uint64_t messages, uint64_t elapsed_ns)
+{
+    const double ns_per_message = (0 != messages) ? (double) elapsed_ns / (double) messages : 0.0;
+    const double messages_per_second = (0 != elapsed_ns) ? (double) messages * 1e9 / (double) elapsed_ns : 0.0;
+    printf("%-24s %10.1f ns/message %14.0f messages/s\n", name, ns_per_message, messages_per_second);
+}
+
+static void opra_bench_run_stage(const char *name, opra_bench_stage stage, const opra_bench_traffic *traffic, void *context, unsigned repeat)
+{
+    uint64_t best = UINT64_MAX;
+    volatile uint64_t result = 0;
+    for (unsigned r = 0; r < repeat; r++){
+        const uint64_t start = opra_bench_now_ns();
+        result = stage(traffic, context);
+        const uint64_t elapsed = opra_bench_now_ns() - start;
+        if (elapsed < best)
+            best = elapsed;
+    }
+    (void) result;
+    opra_bench_report(name, traffic->message_count, best);
+}
+
+/*Classic pcap of one UDP datagram per block, Ethernet and IPv4 from 10.0.0.1 to the OPRA multicast range*/
+/*block b goes to the line b % lines, on port + b % lines*/
+static bool opra_bench_write_pcap(const char *path, const opra_bench_traffic *traffic, unsigned port, unsigned lines)
+{
+    FILE *fp = fopen(path, "wb");
+    if (NULL == fp)
+        return false;
+
+    /*written big endian, readers take the byte order from the magic number*/
+    uint8_t header[24];
+    uint8_t *h = opra_bench_put_uint32(header, 0xa1b2c3d4);
+    h = opra_bench_put_uint16(h, 2);
+    h = opra_bench_put_uint16(h, 4);
+    h = opra_bench_put_uint32(h, 0);
+    h = opra_bench_put_uint32(h, 0);
+    h = opra_bench_put_uint32(h, 65535);
+    opra_bench_put_uint32(h, 1);    /*Ethernet*/
+    bool ok = (1 == fwrite(header, sizeof(header), 1, fp));
+
+    for (unsigned b = 0; ok && (b < traffic->block_count); b++){
+        const uint8_t *block = traffic->data + traffic->offsets[b];
+        const unsigned block_size = ((unsigned) block[OPRA_BLOCK_SIZE_OFFSET] << 8) | block[OPRA_BLOCK_SIZE_OFFSET + 1];
+        uint8_t frame[14 + 20 + 8];
+        uint8_t *p = frame;
+
+        static const uint8_t ethernet[14] = { 0x01, 0x00, 0x5e, 0x6d, 0x00, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00, 0x01, 0x08, 0x00 };
+        p = opra_bench_put_bytes(p, ethernet, sizeof(ethernet));
+
+        uint8_t *ip = p;
+        *p++ = 0x45;
+        *p++ = 0;
+        p = opra_bench_put_uint16(p, (uint16_t) (20 + 8 + block_size));
+        p = opra_bench_put_uint16(p, (uint16_t) b);
+        p = opra_bench_put_uint16(p, 0x4000);
+        *p++ = 64;
+        *p++ = 17;
+        p = opra_bench_put_uint16(p, 0);
+        p = opra_bench_put_uint32(p, 0x0a000001);
+        p = opra_bench_put_uint32(p, 0xe96d0001);
+        uint32_t sum = 0;
+        for (unsigned i = 0; i < 20; i += 2)
+            sum += ((uint32_t) ip[i] << 8) | ip[i + 1];
+        sum = (sum & 0xffff) + (sum >> 16);
+        sum = (sum & 0xffff) + (sum >> 16);
+        opra_bench_put_uint16(ip + 10, (uint16_t) ~sum);
+
+        p = opra_bench_put_uint16(p, 40000);
+        p = opra_bench_put_uint16(p, (uint16_t) (port + b % lines));
+        p = opra_bench_put_uint16(p, (uint16_t) (8 + block_size));
+        p = opra_bench_put_uint16(p, 0);
+
+        /*a microsecond apart*/
+        uint8_t record[16];
+        uint8_t *r = opra_bench_put_uint32(record, 1700000000 + b / 1000000);
+        r = opra_bench_put_uint32(r, b % 1000000);
+        r = opra_bench_put_uint32(r, (uint32_t) sizeof(frame) + block_size);
+        opra_bench_put_uint32(r, (uint32_t) sizeof(frame) + block_size);
+        ok = (1 == fwrite(record, sizeof(record), 1, fp)) && (1 == fwrite(frame, sizeof(frame), 1, fp)) && (1 == fwrite(block, block_size, 1, fp));
+    }
+    return (0 == fclose(fp)) && ok;
+}
+
+/*One file per block, block-0001.bin and on, in an existing directory*/
+static bool opra_bench_write_corpus(const char *directory, const opra_bench_traffic *traffic)
+{
+    for (unsigned b = 0; b < traffic->block_count; b++){
+        const uint8_t *block = traffic->data + traffic->offsets[b];
+        const unsigned block_size = ((unsigned) block[OPRA_BLOCK_SIZE_OFFSET] << 8) | block[OPRA_BLOCK_SIZE_OFFSET + 1];
+        char path[4096];
+        const int length = snprintf(path, sizeof(path), "%s/block-%04u.bin", directory, b + 1);
+        if ((length < 0) || ((size_t) length >= sizeof(path)))
+            return false;
+
+        FILE *fp = fopen(path, "wb");
+        if (NULL == fp)
+            return false;
+        const bool ok = (1 == fwrite(block, block_size, 1, fp));
+        if ((0 != fclose(fp)) || !ok)
+            return false;
+    }
+    return true;
+}
+
+#ifdef _WIN32
+#define OPRA_BENCH_NULL_DEVICE "NUL"
+#else
+#define OPRA_BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+/*Wall time of one tshark run over the capture, or 0 if it failed*/
+static uint64_t opra_bench_run_tshark(const opra_bench_config *config, const char *options)
+{
+    char command[4096];
+    const int length = snprintf(command, sizeof(command), "\"%s\" -n -r \"%s\" -d udp.port==%u-%u,opra %s > %s 2>&1",
+        config->tshark_path, config->pcap_path, config->port, config->port + config->lines - 1, options, OPRA_BENCH_NULL_DEVICE);
+    if ((length < 0) || ((size_t) length >= sizeof(command)))
+        return 0;
+
+    const uint64_t start = opra_bench_now_ns();
+    if (0 != system(command))
+        return 0;
+    return opra_bench_now_ns() - start;
+}
+
+/*Time tshark end-to-end over the capture.  A run reading one frame is timed alongside for what starting up costs,
+  it isn't taken off: the difference would still hold file reading and, with -V, printing, which is no dissector cost.*/
+static int opra_bench_tshark(const opra_bench_config *config)
+{
+    static const struct {
+        const char *name;
+        const char *options;
+    } modes[] = {
+        { "tshark end-to-end, one frame", "-q -c 1" },
+        { "tshark end-to-end, tree", "-V" },
+        { "tshark end-to-end, no tree", "-q" },
+        { "tshark end-to-end, tap only", "-q -z opra,tree" },
+    };
+
+    printf("tshark runs: whole process times, start up, capture reading and output included, not dissection alone\n");
+    for (unsigned m = 0; m < sizeof(modes) / sizeof(modes[0]); m++){
+        uint64_t best = UINT64_MAX;
+        for (unsigned r = 0; r < config->repeat; r++){
+            const uint64_t elapsed = opra_bench_run_tshark(config, modes[m].options);
+            if (0 == elapsed){
+                fprintf(stderr, "opra_bench: running %s failed\n", config->tshark_path);
+                return 1;
+            }
+            if (elapsed < best)
+                best = elapsed;
+        }
+        printf("%-32s %10.1f ms/run (tshark %s)\n", modes[m].name, (double) best / 1e6, modes[m].options);
+    }
+    return 0;
+}
+
+static bool opra_bench_parse_unsigned(const char *s, unsigned *value)
+{
+    char *end;
+    const unsigned long parsed = strtoul(s, &end, 10);
+    if (('\0' == s[0]) || ('\0' != *end) || (parsed > UINT32_MAX))
+        return false;
+    *value = (unsigned) parsed;
+    return true;
+}
+
+/*"q=70,k=15,a=8", categories left out get 0*/
+static bool opra_bench_parse_mix(const char *s, unsigned mix[OPRA_BENCH_CATEGORIES])
+{
+    memset(mix, 0, OPRA_BENCH_CATEGORIES * sizeof(unsigned));
+    while ('\0' != *s){
+        unsigned i;
+        for (i = 0; i < OPRA_BENCH_CATEGORIES; i++){
+            if ((uint8_t) s[0] == opra_bench_categories[i])
+                break;
+        }
+        if ((OPRA_BENCH_CATEGORIES == i) || ('=' != s[1]))
+            return false;
+
+        char *end;
+        const unsigned long weight = strtoul(s + 2, &end, 10);
+        if ((end == s + 2) || (weight > 1000000) || ((',' != *end) && ('\0' != *end)))
+            return false;
+        mix[i] = (unsigned) weight;
+        s = (',' == *end) ? end + 1 : end;
+    }
+    return true;
+}
+
+static void opra_bench_usage(void)
+{
+    fprintf(stderr,
+        "Usage: opra_bench [options]\n"
+        "  --blocks N          blocks to generate (default 100000)\n"
+        "  --mix LIST          category weights, e.g. q=70,k=15,a=8,Y=3,d=1,f=1,C=1,H=1 (the default)\n"
+        "  --appendages PCT    quotes sent with a CGKO or MNOP appendage indicator (default 20)\n"
+        "  --fill PCT          block fill level, as a share of the largest block (default 90)\n"
+        "  --instruments N     distinct series (default 10000)\n"
+        "  --seed N            generator seed (default 1)\n"
+        "  --repeat N          runs of each stage, the fastest counts (default 5)\n"
+        "  --pcap FILE         also write the blocks as a capture, one UDP datagram each\n"
+        "  --tshark PATH       time whole tshark runs over the capture, needs --pcap.  Start up, capture reading\n"
+        "                      and output are included, these are not times of dissection alone\n"
+        "  --port N            destination UDP port of the capture (default 54321)\n"
+        "  --lines N           deal the blocks to N lines, on --port and the ports after it (default 1, at most 16)\n"
+        "  --corpus DIR        also write each block to a file of its own in DIR, for opra_fuzz\n");
+}
+
+int main(int argc, char *argv[])
+{
+    opra_bench_config config;
+    memset(&config, 0, sizeof(config));
+    config.blocks = 100000;
+    memcpy(config.mix, opra_bench_default_mix, sizeof(config.mix));
+    config.appendage_percent = 20;
+    config.fill_percent = 90;
+    config.instruments = 10000;
+    config.seed = 1;
+    config.repeat = 5;
+    config.port = 54321;
+    config.lines = 1;
+    opra_checksum_init();
+
+    for (int i = 1; i < argc; i++){
+        const char *option = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        unsigned number = 0;
+        bool ok = (NULL != value);
+
+        if (ok && (0 == strcmp(option, "--mix")))
+            ok = opra_bench_parse_mix(value, config.mix);
+        else if (ok && (0 == strcmp(option, "--pcap")))
+            config.pcap_path = value;
+        else if (ok && (0 == strcmp(option, "--tshark")))
+            config.tshark_path = value;
+        else if (ok && (0 == strcmp(option, "--corpus")))
+            config.corpus_path = value;
+        else if (ok && (ok = opra_bench_parse_unsigned(value, &number))){
+            if (0 == strcmp(option, "--blocks"))
+                config.blocks = number;
+            else if (0 == strcmp(option, "--appendages"))
+                config.appendage_percent = number;
+            else if (0 == strcmp(option, "--fill"))
+                config.fill_percent = number;
+            else if (0 == strcmp(option, "--instruments"))
+                config.instruments = number;
+            else if (0 == strcmp(option, "--seed"))
+                config.seed = number;
+            else if (0 == strcmp(option, "--repeat"))
+                config.repeat = number;
+            else if (0 == strcmp(option, "--port"))
+                config.port = number;
+            else if (0 == strcmp(option, "--lines"))
+                config.lines = number;
+            else
+                ok = false;
+        }
+        if (!ok){
+            opra_bench_usage();
+            return 1;
+        }
+        i++;
+    }
+    if ((0 == config.blocks) || (0 == config.instruments) || (0 == config.repeat) || (config.appendage_percent > 100) ||
+        (0 == config.fill_percent) || (config.fill_percent > 100) || (0 == config.port) || (config.port > 65535) ||
+        (0 == config.lines) || (config.lines > OPRA_BENCH_MAX_LINES) || (config.lines > config.instruments) || (config.port + config.lines - 1 > 65535) ||
+        ((NULL != config.tshark_path) && (NULL == config.pcap_path))){
+        opra_bench_usage();
+        return 1;
+    }
+
+    opra_bench_random_state = config.seed * UINT64_C(0x9e3779b97f4a7c15) + 1;
+    opra_bench_traffic traffic;
+    if (!opra_bench_generate(&config, &traffic)){
+        fprintf(stderr, "opra_bench: out of memory\n");
+        return 1;
+    }
+
+    printf("%u blocks, %" PRIu64 " messages, %.1f messages per block, %.1f bytes per block, checksum kernel %s\n",
+        traffic.block_count, traffic.message_count, (double) traffic.message_count / traffic.block_count,
+        (double) traffic.length / traffic.block_count, opra_checksum_kernel());
+    printf("mix");
+    for (unsigned i = 0; i < OPRA_BENCH_CATEGORIES; i++)
+        printf(" %c=%.1f%%", opra_bench_categories[i], 100.0 * (double) traffic.category_counts[opra_bench_categories[i]] / (double) traffic.message_count);
+    printf("\n");
+
+    /*every message has to be found, or the timings are of something else*/
+    if (opra_bench_walk(&traffic, NULL) != traffic.message_count){
+        fprintf(stderr, "opra_bench: the generated blocks don't decode\n");
+        return 1;
+    }
+
+    opra_bench_run_stage("core, walk", opra_bench_walk, &traffic, NULL, config.repeat);
+    opra_bench_run_stage("core, decode", opra_bench_decode, &traffic, NULL, config.repeat);
+    opra_bench_books books;
+    opra_arena_init(&books.arena);
+    if (!opra_table_init(&books.table, sizeof(opra_instrument_key), config.instruments)){
+        fprintf(stderr, "opra_bench: out of memory\n");
+        return 1;
+    }
+    opra_bench_run_stage("core, decode and book", opra_bench_book, &traffic, &books, config.repeat);
+    opra_table_free(&books.table);
+    opra_arena_free_all(&books.arena);
+    opra_bench_run_stage("core, checksum", opra_bench_checksum, &traffic, NULL, config.repeat);
+
+    int status = 0;
+    if ((NULL != config.corpus_path) && !opra_bench_write_corpus(config.corpus_path, &traffic)){
+        fprintf(stderr, "opra_bench: can't write the corpus to %s\n", config.corpus_path);
+        status = 1;
+    }
+    if (NULL != config.pcap_path){
+        if (!opra_bench_write_pcap(config.pcap_path, &traffic, config.port, config.lines)){
+            fprintf(stderr, "opra_bench: can't write %s\n", config.pcap_path);
+            status = 1;
+        } else if (NULL != config.tshark_path){
+            status = opra_bench_tshark(&config);
+        }
+    }
+
+    free(traffic.data);
+    free(traffic.offsets);
+    return status;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
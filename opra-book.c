@@ -0,0 +1,199 @@
+/* opra-book.c
+ *
+ * Top of book for one OPRA instrument, see opra-book.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <stdlib.h>
+
+#include "opra-book.h"
+#include "opra-price.h"
+
+/*short quote prices always have 2 decimal places, denominator code 'B'*/
+#define OPRA_SHORT_QUOTE_PRICE_DENOMINATOR_CODE 'B'
+
+/*false, leaving the side as it was, for an invalid denominator code.  changed is set if the side moved.*/
+static bool opra_book_set(opra_book_side *side, uint8_t participant_id, uint32_t price, uint8_t denominator_code, uint32_t size,
+    bool *changed)
+{
+    opra_book_side updated;
+    if (!opra_price_scaled(price, denominator_code, &updated.price))
+        return false;
+    updated.size = size;
+    updated.participant_id = participant_id;
+
+    if ((updated.price != side->price) || (updated.size != side->size) || (updated.participant_id != side->participant_id)){
+        *side = updated;
+        *changed = true;
+    }
+    return true;
+}
+
+static void opra_book_clear(opra_book_side *side, bool *changed)
+{
+    if (0 == side->participant_id)
+        return;
+    side->price = 0;
+    side->size = 0;
+    side->participant_id = 0;
+    *changed = true;
+}
+
+bool opra_book_apply(opra_book_top *top, const opra_message *msg, unsigned *written)
+{
+    unsigned sides = 0;
+    if (NULL != written)
+        *written = 0;
+
+    uint32_t bid_price, bid_size, offer_price, offer_size;
+    uint8_t denominator_code;
+
+    switch(msg->hdr.message_category)
+    {
+        case 'k':
+            bid_price = msg->body.k.bid_price;
+            bid_size = msg->body.k.bid_size;
+            offer_price = msg->body.k.offer_price;
+            offer_size = msg->body.k.offer_size;
+            denominator_code = msg->body.k.premium_price_denominator_code;
+            break;
+        case 'q':
+            bid_price = msg->body.q.bid_price;
+            bid_size = msg->body.q.bid_size;
+            offer_price = msg->body.q.offer_price;
+            offer_size = msg->body.q.offer_size;
+            denominator_code = OPRA_SHORT_QUOTE_PRICE_DENOMINATOR_CODE;
+            break;
+        default:
+            return false;
+    }
+
+    const uint8_t flags = opra_indicator_table[msg->hdr.message_indicator];
+    bool changed = false;
+
+    if (flags & OPRA_INDICATOR_BID_IN_QUOTE){
+        if (opra_book_set(&top->bid, msg->hdr.participant_id, bid_price, denominator_code, bid_size, &changed))
+            sides |= OPRA_BOOK_BID;
+    } else if (flags & OPRA_INDICATOR_NO_BID){
+        opra_book_clear(&top->bid, &changed);
+        sides |= OPRA_BOOK_BID;
+    }
+
+    if (flags & OPRA_INDICATOR_OFFER_IN_QUOTE){
+        if (opra_book_set(&top->offer, msg->hdr.participant_id, offer_price, denominator_code, offer_size, &changed))
+            sides |= OPRA_BOOK_OFFER;
+    } else if (flags & OPRA_INDICATOR_NO_OFFER){
+        opra_book_clear(&top->offer, &changed);
+        sides |= OPRA_BOOK_OFFER;
+    }
+
+    /*appendages carry the best price of another participant*/
+    opra_appendage_iter iter;
+    opra_quote_appendage appendage;
+    opra_appendage_iter_init(&iter, msg);
+    while (opra_appendage_iter_next(&iter, &appendage)){
+        const bool bid = (OPRA_APPENDAGE_BID == appendage.side);
+        if (opra_book_set(bid ? &top->bid : &top->offer, appendage.participant_id, appendage.price, appendage.denominator_code, appendage.size, &changed))
+            sides |= bid ? OPRA_BOOK_BID : OPRA_BOOK_OFFER;
+    }
+
+    if (NULL != written)
+        *written = sides;
+    return changed;
+}
+
+bool opra_book_history_append(opra_book_history *history, opra_pool *pool, uint64_t position, const opra_book_top *top)
+{
+    if ((0 == history->chunk_count) || (OPRA_BOOK_CHUNK_ROWS == history->last_chunk_rows)){
+        if (history->chunk_count == history->chunk_capacity){
+            const uint32_t capacity = (0 == history->chunk_capacity) ? 1 : history->chunk_capacity * 2;
+            opra_book_chunk **chunks = (opra_book_chunk **) realloc(history->chunks, capacity * sizeof(opra_book_chunk *));
+            if (NULL == chunks)
+                return false;
+            history->chunks = chunks;
+            history->chunk_capacity = capacity;
+        }
+        opra_book_chunk *chunk = (opra_book_chunk *) opra_pool_alloc(pool);
+        if (NULL == chunk)
+            return false;
+        history->chunks[history->chunk_count++] = chunk;
+        history->last_chunk_rows = 0;
+    }
+
+    opra_book_chunk *chunk = history->chunks[history->chunk_count - 1];
+    const uint32_t row = history->last_chunk_rows++;
+    chunk->positions[row] = position;
+    chunk->bid_prices[row] = top->bid.price;
+    chunk->bid_sizes[row] = top->bid.size;
+    chunk->bid_participant_ids[row] = top->bid.participant_id;
+    chunk->offer_prices[row] = top->offer.price;
+    chunk->offer_sizes[row] = top->offer.size;
+    chunk->offer_participant_ids[row] = top->offer.participant_id;
+    return true;
+}
+
+opra_book_lookup opra_book_history_find(const opra_book_history *history, uint64_t position, uint64_t *row_position, opra_book_top *top)
+{
+    /*the last chunk starting at or before position, then the last row in it at or before position*/
+    uint32_t low = 0;
+    uint32_t high = history->chunk_count;
+    while (low < high){
+        const uint32_t mid = low + (high - low) / 2;
+        if (history->chunks[mid]->positions[0] <= position)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (0 == low)
+        return history->released ? OPRA_BOOK_RELEASED : OPRA_BOOK_NOT_SET;
+
+    const opra_book_chunk *chunk = history->chunks[low - 1];
+    uint32_t row_low = 1;
+    uint32_t row_high = (low == history->chunk_count) ? history->last_chunk_rows : OPRA_BOOK_CHUNK_ROWS;
+    while (row_low < row_high){
+        const uint32_t mid = row_low + (row_high - row_low) / 2;
+        if (chunk->positions[mid] <= position)
+            row_low = mid + 1;
+        else
+            row_high = mid;
+    }
+
+    const uint32_t row = row_low - 1;
+    *row_position = chunk->positions[row];
+    top->bid.price = chunk->bid_prices[row];
+    top->bid.size = chunk->bid_sizes[row];
+    top->bid.participant_id = chunk->bid_participant_ids[row];
+    top->offer.price = chunk->offer_prices[row];
+    top->offer.size = chunk->offer_sizes[row];
+    top->offer.participant_id = chunk->offer_participant_ids[row];
+    return OPRA_BOOK_FOUND;
+}
+
+void opra_book_history_release(opra_book_history *history, opra_pool *pool)
+{
+    for (uint32_t i = 0; i < history->chunk_count; i++)
+        opra_pool_free(pool, history->chunks[i]);
+    free(history->chunks);
+
+    const bool released = history->released || (0 != history->chunk_count);
+    opra_book_history_init(history);
+    history->released = released;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
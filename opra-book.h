@@ -0,0 +1,130 @@
+/* opra-book.h
+ *
+ * Top of book for one OPRA instrument, kept from the best bid and offer carried by quotes, and the history of its
+ * changes.  No epan dependency.  The top of book needs no allocation, the history takes fixed size chunks from a
+ * caller supplied pool so it can be given back when memory runs short.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_BOOK_H__
+#define __OPRA_BOOK_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "opra-decode.h"
+#include "opra-pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+typedef struct _opra_book_side {
+    int64_t price;              /*scaled to 8 decimal places, see opra_price_scaled()*/
+    uint32_t size;
+    uint8_t participant_id;     /*0 when this side has no best price*/
+} opra_book_side;
+
+typedef struct _opra_book_top {
+    opra_book_side bid;
+    opra_book_side offer;
+} opra_book_top;
+
+/*an instrument starts with neither side set*/
+static inline void opra_book_top_init(opra_book_top *top)
+{
+    top->bid.price = 0;
+    top->bid.size = 0;
+    top->bid.participant_id = 0;
+    top->offer = top->bid;
+}
+
+/*sides of the book*/
+#define OPRA_BOOK_BID   0x01
+#define OPRA_BOOK_OFFER 0x02
+
+/*Apply a k or q quote following its message indicator, see OPRA_INDICATOR_BID_IN_QUOTE and friends.
+  A side whose price has an invalid denominator code is left as it was.
+  Other categories don't move the book.  Returns true if either side changed.  written, if not NULL, is set to the
+  sides the quote set or cleared, whether or not they changed, which is what the book has from this quote on.*/
+bool opra_book_apply(opra_book_top *top, const opra_message *msg, unsigned *written);
+
+/*rows of history per chunk, small as most series change only a few times a day*/
+#define OPRA_BOOK_CHUNK_ROWS 16
+
+/*history rows kept as columns, so the positions of a chunk share cache lines*/
+typedef struct _opra_book_chunk {
+    uint64_t positions[OPRA_BOOK_CHUNK_ROWS];
+    int64_t bid_prices[OPRA_BOOK_CHUNK_ROWS];
+    int64_t offer_prices[OPRA_BOOK_CHUNK_ROWS];
+    uint32_t bid_sizes[OPRA_BOOK_CHUNK_ROWS];
+    uint32_t offer_sizes[OPRA_BOOK_CHUNK_ROWS];
+    uint8_t bid_participant_ids[OPRA_BOOK_CHUNK_ROWS];
+    uint8_t offer_participant_ids[OPRA_BOOK_CHUNK_ROWS];
+} opra_book_chunk;
+
+/*The top of book after each change, in increasing position order.  Positions are the caller's, e.g. a message's
+  place in the capture, and are binary searched for the row in force at any of them.  The chunk list is malloc'd,
+  the chunks come from an opra_pool of sizeof(opra_book_chunk) objects.*/
+typedef struct _opra_book_history {
+    opra_book_chunk **chunks;
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+    uint32_t last_chunk_rows;           /*rows used in the last chunk*/
+    bool released;                      /*rows were given back, anything before the first kept row is gone*/
+} opra_book_history;
+
+typedef enum _opra_book_lookup {
+    OPRA_BOOK_FOUND,
+    OPRA_BOOK_NOT_SET,                  /*the book hadn't been set at the position*/
+    OPRA_BOOK_RELEASED                  /*the row in force at the position was given back*/
+} opra_book_lookup;
+
+static inline void opra_book_history_init(opra_book_history *history)
+{
+    history->chunks = NULL;
+    history->chunk_count = 0;
+    history->chunk_capacity = 0;
+    history->last_chunk_rows = 0;
+    history->released = false;
+}
+
+/*Add a row for top at position, which must be above every position in the history.
+  Returns false, leaving the history as it was, if memory runs out.*/
+bool opra_book_history_append(opra_book_history *history, opra_pool *pool, uint64_t position, const opra_book_top *top);
+
+/*the row in force at position, the last one at or before it*/
+opra_book_lookup opra_book_history_find(const opra_book_history *history, uint64_t position, uint64_t *row_position, opra_book_top *top);
+
+/*Give every row back to the pool.  Later rows can still be appended.*/
+void opra_book_history_release(opra_book_history *history, opra_pool *pool);
+
+/*bytes of the chunk list and chunks*/
+static inline size_t opra_book_history_bytes(const opra_book_history *history)
+{
+    return history->chunk_capacity * sizeof(opra_book_chunk *) + history->chunk_count * sizeof(opra_book_chunk);
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_BOOK_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
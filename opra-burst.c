@@ -0,0 +1,128 @@
+/* opra-burst.c
+ *
+ * Sliding window microburst detection for OPRA lines, see opra-burst.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <string.h>
+
+#include "opra-burst.h"
+
+void opra_burst_window_init(opra_burst_window *window, uint64_t width_ns)
+{
+    memset(window, 0, sizeof(*window));
+    window->width_ns = width_ns;
+    window->bucket_ns = width_ns / OPRA_BURST_BUCKETS;
+}
+
+/*move the head bucket up to time_ns, emptying the buckets that fall out of the window.
+  At most OPRA_BURST_BUCKETS buckets are touched however far time moves.*/
+static void opra_burst_window_advance(opra_burst_window *window, uint64_t time_ns)
+{
+    if (!window->started){
+        window->head_ns = time_ns - (time_ns % window->bucket_ns);
+        window->started = true;
+        return;
+    }
+    if (time_ns < window->head_ns + window->bucket_ns)
+        return;
+
+    const uint64_t steps = (time_ns - window->head_ns) / window->bucket_ns;
+    window->head_ns += steps * window->bucket_ns;
+
+    if (steps >= OPRA_BURST_BUCKETS){
+        memset(window->counts, 0, sizeof(window->counts));
+        memset(window->first_frames, 0, sizeof(window->first_frames));
+        window->messages = 0;
+        return;
+    }
+
+    for (uint64_t i = 0; i < steps; i++){
+        window->head = (window->head + 1) % OPRA_BURST_BUCKETS;
+        window->messages -= window->counts[window->head];
+        window->counts[window->head] = 0;
+        window->first_frames[window->head] = 0;
+    }
+}
+
+/*the burst the window currently holds, starting at its oldest non empty bucket*/
+static void opra_burst_window_current(const opra_burst_window *window, uint32_t frame, opra_burst *burst)
+{
+    for (unsigned i = 1; i <= OPRA_BURST_BUCKETS; i++){
+        const unsigned age = OPRA_BURST_BUCKETS - i;
+        const unsigned index = (window->head + i) % OPRA_BURST_BUCKETS;
+        if (0 != window->counts[index]){
+            burst->start_ns = window->head_ns - age * window->bucket_ns;
+            burst->first_frame = window->first_frames[index];
+            break;
+        }
+    }
+    burst->messages = window->messages;
+    burst->last_frame = frame;
+}
+
+/*keep the top list sorted, busiest first, after entry i grew*/
+static void opra_burst_window_promote(opra_burst_window *window, unsigned i)
+{
+    while ((i > 0) && (window->top[i].messages > window->top[i - 1].messages)){
+        const opra_burst tmp = window->top[i - 1];
+        window->top[i - 1] = window->top[i];
+        window->top[i] = tmp;
+        i--;
+    }
+}
+
+bool opra_burst_window_add(opra_burst_window *window, uint64_t time_ns, uint32_t messages, uint32_t frame)
+{
+    opra_burst_window_advance(window, time_ns);
+
+    if (0 == window->counts[window->head])
+        window->first_frames[window->head] = frame;
+    window->counts[window->head] += messages;
+    window->messages += messages;
+
+    /*the cheap test first, most blocks don't make the list*/
+    if ((OPRA_BURST_TOP_N == window->top_count) && (window->messages <= window->top[OPRA_BURST_TOP_N - 1].messages))
+        return false;
+
+    opra_burst current;
+    opra_burst_window_current(window, frame, &current);
+
+    /*a window overlapping one already listed is the same burst*/
+    for (unsigned i = 0; i < window->top_count; i++){
+        if (window->top[i].start_ns + window->width_ns > current.start_ns){
+            if (current.messages <= window->top[i].messages)
+                return false;
+            window->top[i] = current;
+            opra_burst_window_promote(window, i);
+            return true;
+        }
+    }
+
+    unsigned i = window->top_count;
+    if (i < OPRA_BURST_TOP_N)
+        window->top_count++;
+    else
+        i = OPRA_BURST_TOP_N - 1;
+    window->top[i] = current;
+    opra_burst_window_promote(window, i);
+    return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,81 @@
+/* opra-burst.h
+ *
+ * Sliding window microburst detection for OPRA lines.
+ * No epan dependency.  Each window is a fixed ring of buckets, so adding a block is constant time.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_BURST_H__
+#define __OPRA_BURST_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*buckets per window, the window slides in steps of width / OPRA_BURST_BUCKETS*/
+#define OPRA_BURST_BUCKETS 10
+
+/*busiest windows kept per line and window width*/
+#define OPRA_BURST_TOP_N 5
+
+typedef struct _opra_burst {
+    uint64_t messages;
+    uint64_t start_ns;          /*start of the window, same clock as the times passed in*/
+    uint32_t first_frame;
+    uint32_t last_frame;
+} opra_burst;
+
+typedef struct _opra_burst_window {
+    uint64_t width_ns;
+    uint64_t bucket_ns;
+    uint64_t head_ns;           /*start time of the newest bucket*/
+    uint64_t messages;          /*messages in the whole window*/
+    unsigned head;              /*ring index of the newest bucket*/
+    bool started;
+    uint32_t counts[OPRA_BURST_BUCKETS];
+    uint32_t first_frames[OPRA_BURST_BUCKETS];
+
+    /*busiest first.  Overlapping windows are the same burst and only the busiest of them is kept.*/
+    opra_burst top[OPRA_BURST_TOP_N];
+    unsigned top_count;
+} opra_burst_window;
+
+/*width_ns must be at least OPRA_BURST_BUCKETS*/
+void opra_burst_window_init(opra_burst_window *window, uint64_t width_ns);
+
+/*Count a block of messages at time_ns.  Times that go backwards are counted in the newest bucket.
+  Returns true if the top list changed.*/
+bool opra_burst_window_add(opra_burst_window *window, uint64_t time_ns, uint32_t messages, uint32_t frame);
+
+/*messages per second for a burst in this window*/
+static inline double opra_burst_rate(const opra_burst_window *window, const opra_burst *burst)
+{
+    return (double) burst->messages * 1e9 / (double) window->width_ns;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_BURST_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
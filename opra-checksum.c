@@ -0,0 +1,157 @@
+/* opra-checksum.c
+ *
+ * OPRA block checksum, see opra-checksum.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "opra-checksum.h"
+#include "opra-decode.h"
+
+/*SSE2 is part of x86-64, AVX2 has to be asked for per function and checked for at run time*/
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define OPRA_CHECKSUM_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define OPRA_CHECKSUM_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+/*NEON is part of AArch64*/
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define OPRA_CHECKSUM_NEON
+#include <arm_neon.h>
+#endif
+
+/*kernels return the plain byte sum, which can't overflow 32 bits for a block of at most 64KiB*/
+typedef uint32_t (*opra_sum_bytes_fn)(const uint8_t *, size_t);
+
+typedef struct _opra_checksum_kernel_info {
+    const char *name;
+    opra_sum_bytes_fn sum_bytes;
+} opra_checksum_kernel_info;
+
+static uint32_t opra_sum_bytes_scalar(const uint8_t *p, size_t n)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum += p[i];
+    return sum;
+}
+
+#ifdef OPRA_CHECKSUM_SSE2
+/*PSADBW against zero sums each 8 byte half into its own 64 bit lane*/
+static uint32_t opra_sum_bytes_sse2(const uint8_t *p, size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i *) (p + i)), zero));
+
+    const uint32_t sum = (uint32_t) _mm_cvtsi128_si32(acc) + (uint32_t) _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+    return sum + opra_sum_bytes_scalar(p + i, n - i);
+}
+#endif
+
+#ifdef OPRA_CHECKSUM_AVX2
+__attribute__((target("avx2")))
+static uint32_t opra_sum_bytes_avx2(const uint8_t *p, size_t n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i *) (p + i)), zero));
+
+    const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    const uint32_t sum = (uint32_t) _mm_cvtsi128_si32(half) + (uint32_t) _mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+    return sum + opra_sum_bytes_sse2(p + i, n - i);
+}
+#endif
+
+#ifdef OPRA_CHECKSUM_NEON
+/*pairwise widening adds, bytes to 16 bit lanes and on into 32 bit accumulators*/
+static uint32_t opra_sum_bytes_neon(const uint8_t *p, size_t n)
+{
+    uint32x4_t acc = vdupq_n_u32(0);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+        acc = vpadalq_u16(acc, vpaddlq_u8(vld1q_u8(p + i)));
+
+    const uint32_t sum = vgetq_lane_u32(acc, 0) + vgetq_lane_u32(acc, 1) + vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+    return sum + opra_sum_bytes_scalar(p + i, n - i);
+}
+#endif
+
+static const opra_checksum_kernel_info opra_checksum_scalar_kernel = { "scalar", opra_sum_bytes_scalar };
+
+static const opra_checksum_kernel_info *opra_checksum_select(void)
+{
+#ifdef OPRA_CHECKSUM_AVX2
+    static const opra_checksum_kernel_info avx2 = { "avx2", opra_sum_bytes_avx2 };
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return &avx2;
+#endif
+#ifdef OPRA_CHECKSUM_SSE2
+    static const opra_checksum_kernel_info sse2 = { "sse2", opra_sum_bytes_sse2 };
+    return &sse2;
+#elif defined(OPRA_CHECKSUM_NEON)
+    static const opra_checksum_kernel_info neon = { "neon", opra_sum_bytes_neon };
+    return &neon;
+#else
+    return &opra_checksum_scalar_kernel;
+#endif
+}
+
+/*Set once by opra_checksum_init() before any dissection, only read after that*/
+static const opra_checksum_kernel_info *opra_checksum_selected = &opra_checksum_scalar_kernel;
+
+void opra_checksum_init(void)
+{
+    opra_checksum_selected = opra_checksum_select();
+}
+
+static inline uint16_t opra_checksum_finish(const uint8_t *data, uint32_t sum)
+{
+    /*the checksum field counts as zero*/
+    sum -= data[OPRA_BLOCK_CHECKSUM_OFFSET] + data[OPRA_BLOCK_CHECKSUM_OFFSET + 1];
+    return (uint16_t) sum;
+}
+
+uint16_t opra_block_checksum(const uint8_t *data, size_t length)
+{
+    return opra_checksum_finish(data, opra_checksum_selected->sum_bytes(data, length));
+}
+
+uint16_t opra_block_checksum_scalar(const uint8_t *data, size_t length)
+{
+    return opra_checksum_finish(data, opra_checksum_scalar_kernel.sum_bytes(data, length));
+}
+
+const char *opra_checksum_kernel(void)
+{
+    return opra_checksum_selected->name;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,56 @@
+/* opra-checksum.h
+ *
+ * OPRA block checksum.  The checksum is the sum of every byte of the block, the checksum field itself
+ * counted as zero, modulo 2^16.
+ * No epan dependency.  The byte sum runs on the widest kernel the CPU supports, AVX2 or SSE2 on x86 and
+ * NEON on ARM, picked on first use, with a portable scalar kernel everywhere else.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_CHECKSUM_H__
+#define __OPRA_CHECKSUM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*Picks the fastest kernel the CPU has.  Call it once before checksumming from more than one thread, until then
+  opra_block_checksum() runs the scalar kernel.*/
+void opra_checksum_init(void);
+
+/*Checksum of the block of length bytes at data, to compare with the block header's checksum field.
+  length is the block size and must be at least OPRA_BLOCK_HEADER_SIZE.*/
+uint16_t opra_block_checksum(const uint8_t *data, size_t length);
+
+/*the same with the scalar kernel, a reference for the vector ones*/
+uint16_t opra_block_checksum_scalar(const uint8_t *data, size_t length);
+
+/*name of the kernel opra_block_checksum() runs on, "avx2", "sse2", "neon" or "scalar"*/
+const char *opra_checksum_kernel(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_CHECKSUM_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,476 @@
+/* opra-decode.c
+ *
+ * Standalone OPRA block decoder, see opra-decode.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <string.h>
+
+#include "opra-decode.h"
+#include "opra-price.h"
+
+/*all multi byte fields are big endian on the wire*/
+static inline uint16_t opra_get_uint16(const uint8_t *p)
+{
+    return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t opra_get_uint32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+const uint8_t opra_indicator_table[256] = {
+    ['A'] = 0,
+    ['B'] = OPRA_INDICATOR_OFFER_IN_QUOTE,
+    ['C'] = OPRA_INDICATOR_OFFER_APPENDAGE,
+    ['D'] = OPRA_INDICATOR_NO_OFFER,
+    ['E'] = OPRA_INDICATOR_BID_IN_QUOTE,
+    ['F'] = OPRA_INDICATOR_BID_IN_QUOTE | OPRA_INDICATOR_OFFER_IN_QUOTE,
+    ['G'] = OPRA_INDICATOR_BID_IN_QUOTE | OPRA_INDICATOR_OFFER_APPENDAGE,
+    ['H'] = OPRA_INDICATOR_BID_IN_QUOTE | OPRA_INDICATOR_NO_OFFER,
+    ['I'] = OPRA_INDICATOR_NO_BID,
+    ['J'] = OPRA_INDICATOR_NO_BID | OPRA_INDICATOR_OFFER_IN_QUOTE,
+    ['K'] = OPRA_INDICATOR_NO_BID | OPRA_INDICATOR_OFFER_APPENDAGE,
+    ['L'] = OPRA_INDICATOR_NO_BID | OPRA_INDICATOR_NO_OFFER,
+    ['M'] = OPRA_INDICATOR_BID_APPENDAGE,
+    ['N'] = OPRA_INDICATOR_BID_APPENDAGE | OPRA_INDICATOR_OFFER_IN_QUOTE,
+    ['O'] = OPRA_INDICATOR_BID_APPENDAGE | OPRA_INDICATOR_OFFER_APPENDAGE,
+    ['P'] = OPRA_INDICATOR_BID_APPENDAGE | OPRA_INDICATOR_NO_OFFER,
+};
+
+opra_decode_status opra_decode_block(const uint8_t *data, int length, opra_block *block)
+{
+    if (length < OPRA_BLOCK_HEADER_SIZE)
+        return OPRA_DECODE_TRUNCATED;
+
+    block->data = data;
+    block->length = length;
+
+    opra_block_header *hdr = &block->hdr;
+    hdr->version = data[0];
+    hdr->block_size = opra_get_uint16(data + OPRA_BLOCK_SIZE_OFFSET);
+    hdr->data_feed_indicator = data[OPRA_BLOCK_DATA_FEED_INDICATOR_OFFSET];
+    hdr->retransmission_indicator = data[OPRA_BLOCK_RETRANSMISSION_INDICATOR_OFFSET];
+    hdr->session_indicator = data[5];
+    hdr->block_sequence_number = opra_get_uint32(data + 6);
+    hdr->messages_in_block = data[OPRA_BLOCK_MESSAGES_IN_BLOCK_OFFSET];
+    hdr->timestamp_secs = opra_get_uint32(data + 11);
+    hdr->timestamp_nsecs = opra_get_uint32(data + 15);
+    hdr->checksum = opra_get_uint16(data + OPRA_BLOCK_CHECKSUM_OFFSET);
+
+    return OPRA_DECODE_OK;
+}
+
+bool opra_block_is_plausible(const uint8_t *data, size_t length, uint8_t version)
+{
+    if ((length < OPRA_BLOCK_HEADER_SIZE) || (version != data[0]))
+        return false;
+    if ('O' != data[OPRA_BLOCK_DATA_FEED_INDICATOR_OFFSET])
+        return false;
+    if ((' ' != data[OPRA_BLOCK_RETRANSMISSION_INDICATOR_OFFSET]) && ('V' != data[OPRA_BLOCK_RETRANSMISSION_INDICATOR_OFFSET]))
+        return false;
+
+    const size_t block_size = opra_get_uint16(data + OPRA_BLOCK_SIZE_OFFSET);
+    if (block_size != length)
+        return false;
+
+    /*every message has at least its header*/
+    const size_t messages_in_block = data[OPRA_BLOCK_MESSAGES_IN_BLOCK_OFFSET];
+    if ((0 == messages_in_block) || (messages_in_block * OPRA_MESSAGE_HEADER_SIZE > block_size - OPRA_BLOCK_HEADER_SIZE))
+        return false;
+
+    return true;
+}
+
+void opra_block_iter_init(opra_block_iter *iter, const uint8_t *data, size_t length)
+{
+    iter->data = data;
+    iter->length = length;
+    iter->offset = 0;
+}
+
+opra_decode_status opra_block_iter_next(opra_block_iter *iter, opra_block *block)
+{
+    if (iter->offset >= iter->length)
+        return OPRA_DECODE_END;
+
+    const size_t remaining = iter->length - iter->offset;
+    if (remaining < OPRA_BLOCK_HEADER_SIZE)
+        return OPRA_DECODE_TRUNCATED;
+
+    const uint8_t *data = iter->data + iter->offset;
+    const size_t block_size = opra_get_uint16(data + OPRA_BLOCK_SIZE_OFFSET);
+    if ((block_size < OPRA_BLOCK_HEADER_SIZE) || (block_size > remaining))
+        return OPRA_DECODE_TRUNCATED;
+
+    iter->offset += block_size;
+    return opra_decode_block(data, (int) block_size, block);
+}
+
+/*categories missing from the table are unknown, their length can't be determined*/
+const opra_category_info opra_category_table[256] = {
+    ['C'] = { OPRA_MSG_CAT_C_DATA_LENGTH_SIZE, OPRA_CATEGORY_KNOWN | OPRA_CATEGORY_VARIABLE_LENGTH },
+    ['H'] = { OPRA_MSG_CAT_H_SIZE, OPRA_CATEGORY_KNOWN },
+    ['Y'] = { OPRA_MSG_CAT_Y_SIZE, OPRA_CATEGORY_KNOWN },
+    ['a'] = { OPRA_MSG_CAT_a_SIZE, OPRA_CATEGORY_KNOWN },
+    ['d'] = { OPRA_MSG_CAT_d_SIZE, OPRA_CATEGORY_KNOWN },
+    ['f'] = { OPRA_MSG_CAT_f_SIZE, OPRA_CATEGORY_KNOWN },
+    ['k'] = { OPRA_MSG_CAT_k_SIZE, OPRA_CATEGORY_KNOWN | OPRA_CATEGORY_QUOTE },
+    ['q'] = { OPRA_MSG_CAT_q_SIZE, OPRA_CATEGORY_KNOWN | OPRA_CATEGORY_QUOTE },
+};
+
+opra_decode_status opra_message_length(const uint8_t *p, int remaining, int *length)
+{
+    if (remaining < OPRA_MESSAGE_HEADER_SIZE)
+        return OPRA_DECODE_TRUNCATED;
+
+    const opra_category_info *info = opra_category_lookup(p[OPRA_MESSAGE_CATEGORY_OFFSET]);
+    if (0 == (info->flags & OPRA_CATEGORY_KNOWN))
+        return OPRA_DECODE_UNKNOWN_CATEGORY;
+
+    int len = OPRA_MESSAGE_HEADER_SIZE + info->body_size;
+
+    if (0 != (info->flags & OPRA_CATEGORY_VARIABLE_LENGTH)){
+        if (remaining < len)
+            return OPRA_DECODE_TRUNCATED;
+        len += opra_get_uint16(p + OPRA_MESSAGE_HEADER_SIZE);
+    }
+
+    if (0 != (info->flags & OPRA_CATEGORY_QUOTE))
+        len += opra_quote_appendage_count(p[OPRA_MESSAGE_INDICATOR_OFFSET]) * OPRA_QUOTE_APPENDAGE_SIZE;
+
+    if (len > remaining)
+        return OPRA_DECODE_TRUNCATED;
+
+    *length = len;
+    return OPRA_DECODE_OK;
+}
+
+opra_decode_status opra_decode_message(const opra_block *block, int offset, opra_message *msg)
+{
+    const int remaining = block->length - offset;
+    if (remaining < OPRA_MESSAGE_HEADER_SIZE)
+        return OPRA_DECODE_TRUNCATED;
+
+    const uint8_t *p = block->data + offset;
+    msg->offset = offset;
+    msg->length = OPRA_MESSAGE_HEADER_SIZE;
+    msg->hdr.participant_id = p[0];
+    msg->hdr.message_category = p[OPRA_MESSAGE_CATEGORY_OFFSET];
+    msg->hdr.message_type = p[2];
+    msg->hdr.message_indicator = p[OPRA_MESSAGE_INDICATOR_OFFSET];
+    msg->hdr.transaction_id = opra_get_uint32(p + 4);
+    msg->hdr.participant_reference_number = opra_get_uint32(p + 8);
+    msg->appendages = NULL;
+    msg->appendage_count = 0;
+
+    const opra_decode_status status = opra_message_length(p, remaining, &msg->length);
+    if (OPRA_DECODE_OK != status)
+        return status;
+
+    p += OPRA_MESSAGE_HEADER_SIZE;
+
+    switch(msg->hdr.message_category)
+    {
+        case 'C':{
+            msg->body.C.data_length = opra_get_uint16(p);
+            msg->body.C.data = p + OPRA_MSG_CAT_C_DATA_LENGTH_SIZE;
+            break;
+        }
+        case 'H':{
+            /*header only*/
+            break;
+        }
+        case 'Y':{
+            msg->body.Y.security_symbol = p;
+            msg->body.Y.index_value_denominator_code = p[6];
+            msg->body.Y.index_value = opra_get_uint32(p + 7);
+            break;
+        }
+        case 'a':{
+            msg->body.a.security_symbol = p;
+            msg->body.a.expiration_block = p + 6;
+            msg->body.a.strike_price_denominator_code = p[9];
+            msg->body.a.strike_price = opra_get_uint32(p + 10);
+            msg->body.a.volume = opra_get_uint32(p + 14);
+            msg->body.a.premium_price_denominator_code = p[18];
+            msg->body.a.premium_price = opra_get_uint32(p + 19);
+            msg->body.a.trade_identifier = opra_get_uint32(p + 23);
+            break;
+        }
+        case 'd':{
+            msg->body.d.security_symbol = p;
+            msg->body.d.expiration_block = p + 6;
+            msg->body.d.strike_price_denominator_code = p[9];
+            msg->body.d.strike_price = opra_get_uint32(p + 10);
+            msg->body.d.volume = opra_get_uint32(p + 14);
+            break;
+        }
+        case 'f':{
+            msg->body.f.security_symbol = p;
+            msg->body.f.expiration_block = p + 6;
+            msg->body.f.strike_price_denominator_code = p[9];
+            msg->body.f.strike_price = opra_get_uint32(p + 10);
+            msg->body.f.volume = opra_get_uint32(p + 14);
+            msg->body.f.open_interest = opra_get_uint32(p + 18);
+            msg->body.f.premium_price_denominator_code = p[22];
+            msg->body.f.open_price = opra_get_uint32(p + 23);
+            msg->body.f.high_price = opra_get_uint32(p + 27);
+            msg->body.f.low_price = opra_get_uint32(p + 31);
+            msg->body.f.last_price = opra_get_uint32(p + 35);
+            msg->body.f.net_change = (int32_t) opra_get_uint32(p + 39);
+            msg->body.f.underlying_price_denominator_code = p[43];
+            msg->body.f.underlying_price = opra_get_uint32(p + 44);
+            msg->body.f.bid_price = opra_get_uint32(p + 48);
+            msg->body.f.offer_price = opra_get_uint32(p + 52);
+            break;
+        }
+        case 'k':{
+            msg->body.k.security_symbol = p;
+            msg->body.k.expiration_block = p + 6;
+            msg->body.k.strike_price_denominator_code = p[9];
+            msg->body.k.strike_price = opra_get_uint32(p + 10);
+            msg->body.k.premium_price_denominator_code = p[14];
+            msg->body.k.bid_price = opra_get_uint32(p + 15);
+            msg->body.k.bid_size = opra_get_uint32(p + 19);
+            msg->body.k.offer_price = opra_get_uint32(p + 23);
+            msg->body.k.offer_size = opra_get_uint32(p + 27);
+            msg->appendages = p + OPRA_MSG_CAT_k_SIZE;
+            msg->appendage_count = opra_quote_appendage_count(msg->hdr.message_indicator);
+            break;
+        }
+        case 'q':{
+            msg->body.q.security_symbol = p;
+            msg->body.q.expiration_block = p + 4;
+            msg->body.q.strike_price = opra_get_uint16(p + 7);
+            msg->body.q.bid_price = opra_get_uint16(p + 9);
+            msg->body.q.bid_size = opra_get_uint16(p + 11);
+            msg->body.q.offer_price = opra_get_uint16(p + 13);
+            msg->body.q.offer_size = opra_get_uint16(p + 15);
+            msg->appendages = p + OPRA_MSG_CAT_q_SIZE;
+            msg->appendage_count = opra_quote_appendage_count(msg->hdr.message_indicator);
+            break;
+        }
+    }
+
+    return OPRA_DECODE_OK;
+}
+
+void opra_message_iter_init(opra_message_iter *iter, const opra_block *block)
+{
+    iter->block = block;
+    iter->offset = OPRA_BLOCK_HEADER_SIZE;
+    iter->index = 0;
+}
+
+opra_decode_status opra_message_iter_next(opra_message_iter *iter, opra_message *msg)
+{
+    if (iter->index >= iter->block->hdr.messages_in_block)
+        return OPRA_DECODE_END;
+
+    const opra_decode_status status = opra_decode_message(iter->block, iter->offset, msg);
+    if (OPRA_DECODE_OK != status)
+        return status;
+
+    iter->offset += msg->length;
+    iter->index++;
+    return OPRA_DECODE_OK;
+}
+
+opra_decode_status opra_message_iter_skip(opra_message_iter *iter)
+{
+    if (iter->index >= iter->block->hdr.messages_in_block)
+        return OPRA_DECODE_END;
+
+    int len;
+    const opra_decode_status status = opra_message_length(iter->block->data + iter->offset, iter->block->length - iter->offset, &len);
+    if (OPRA_DECODE_OK != status)
+        return status;
+
+    iter->offset += len;
+    iter->index++;
+    return OPRA_DECODE_OK;
+}
+
+/*true if count messages starting at offset end exactly at the end of the block, allowing for the pad byte*/
+static bool opra_messages_fill_block(const opra_block *block, int offset, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++){
+        int len;
+        if (OPRA_DECODE_OK != opra_message_length(block->data + offset, block->length - offset, &len))
+            return false;
+        offset += len;
+    }
+    return (offset == block->length) || ((offset + 1 == block->length) && (0 != offset % 2));
+}
+
+opra_decode_status opra_message_iter_resync(opra_message_iter *iter, int *length)
+{
+    const opra_block *block = iter->block;
+    if ((iter->index >= block->hdr.messages_in_block) || (iter->offset + OPRA_MESSAGE_HEADER_SIZE > block->length))
+        return OPRA_DECODE_UNKNOWN_CATEGORY;
+
+    /*the last message runs to the end of the block, the pad byte can't be told from its data*/
+    const unsigned following = block->hdr.messages_in_block - iter->index - 1;
+    if (0 == following){
+        *length = block->length - iter->offset;
+        iter->offset = block->length;
+        iter->index++;
+        return OPRA_DECODE_OK;
+    }
+
+    /*a message longer than any of the spec's isn't looked for, which bounds the candidates to a few dozen*/
+    int last = iter->offset + OPRA_MESSAGE_MAX_FIXED_SIZE;
+    if (last > block->length)
+        last = block->length;
+    for (int next = iter->offset + OPRA_MESSAGE_HEADER_SIZE; next <= last; next++){
+        if (opra_messages_fill_block(block, next, following)){
+            *length = next - iter->offset;
+            iter->offset = next;
+            iter->index++;
+            return OPRA_DECODE_OK;
+        }
+    }
+    return OPRA_DECODE_UNKNOWN_CATEGORY;
+}
+
+bool opra_block_has_message(const opra_block *block, uint8_t message_category, uint8_t message_type)
+{
+    opra_message_iter iter;
+    opra_message_iter_init(&iter, block);
+
+    while (iter.index < block->hdr.messages_in_block){
+        const uint8_t *p = block->data + iter.offset;
+        if ((block->length - iter.offset) < OPRA_MESSAGE_HEADER_SIZE)
+            return false;
+        if ((message_category == p[OPRA_MESSAGE_CATEGORY_OFFSET]) && (message_type == p[OPRA_MESSAGE_TYPE_OFFSET]))
+            return true;
+        int len;
+        const opra_decode_status status = opra_message_iter_skip(&iter);
+        if ((OPRA_DECODE_UNKNOWN_CATEGORY == status) && (OPRA_DECODE_OK == opra_message_iter_resync(&iter, &len)))
+            continue;
+        if (OPRA_DECODE_OK != status)
+            return false;
+    }
+    return false;
+}
+
+void opra_appendage_iter_init(opra_appendage_iter *iter, const opra_message *msg)
+{
+    iter->msg = msg;
+    iter->index = 0;
+}
+
+bool opra_appendage_iter_next(opra_appendage_iter *iter, opra_quote_appendage *appendage)
+{
+    const opra_message *msg = iter->msg;
+    if (iter->index >= msg->appendage_count)
+        return false;
+
+    const uint8_t *p = msg->appendages + iter->index * OPRA_QUOTE_APPENDAGE_SIZE;
+
+    /*a bid appendage always comes first*/
+    if ((0 == iter->index) && (0 != (opra_indicator_table[msg->hdr.message_indicator] & OPRA_INDICATOR_BID_APPENDAGE)))
+        appendage->side = OPRA_APPENDAGE_BID;
+    else
+        appendage->side = OPRA_APPENDAGE_OFFER;
+
+    appendage->participant_id = p[0];
+    appendage->denominator_code = p[1];
+    appendage->price = opra_get_uint32(p + 2);
+    appendage->size = opra_get_uint32(p + 6);
+
+    iter->index++;
+    return true;
+}
+
+static void opra_instrument_key_set(opra_instrument_key *key, const uint8_t *symbol, unsigned symbol_length, const uint8_t *expiration_block)
+{
+    memset(key, 0, sizeof(*key));
+    memset(key->security_symbol, ' ', OPRA_SECURITY_SYMBOL_SIZE);
+    memcpy(key->security_symbol, symbol, symbol_length);
+    memcpy(key->expiration_block, expiration_block, OPRA_EXPIRATION_BLOCK_SIZE);
+}
+
+bool opra_message_instrument(const opra_message *msg, opra_instrument_key *key)
+{
+    switch(msg->hdr.message_category)
+    {
+        case 'a':
+            opra_instrument_key_set(key, msg->body.a.security_symbol, OPRA_SECURITY_SYMBOL_SIZE, msg->body.a.expiration_block);
+            return opra_price_scaled(msg->body.a.strike_price, msg->body.a.strike_price_denominator_code, &key->strike_price);
+        case 'd':
+            opra_instrument_key_set(key, msg->body.d.security_symbol, OPRA_SECURITY_SYMBOL_SIZE, msg->body.d.expiration_block);
+            return opra_price_scaled(msg->body.d.strike_price, msg->body.d.strike_price_denominator_code, &key->strike_price);
+        case 'f':
+            opra_instrument_key_set(key, msg->body.f.security_symbol, OPRA_SECURITY_SYMBOL_SIZE, msg->body.f.expiration_block);
+            return opra_price_scaled(msg->body.f.strike_price, msg->body.f.strike_price_denominator_code, &key->strike_price);
+        case 'k':
+            opra_instrument_key_set(key, msg->body.k.security_symbol, OPRA_SECURITY_SYMBOL_SIZE, msg->body.k.expiration_block);
+            return opra_price_scaled(msg->body.k.strike_price, msg->body.k.strike_price_denominator_code, &key->strike_price);
+        case 'q':
+            /*short quote strikes always have 1 decimal place, denominator code 'A'*/
+            opra_instrument_key_set(key, msg->body.q.security_symbol, OPRA_SHORT_SECURITY_SYMBOL_SIZE, msg->body.q.expiration_block);
+            return opra_price_scaled(msg->body.q.strike_price, 'A', &key->strike_price);
+        default:
+            return false;
+    }
+}
+
+const opra_expiration_month opra_expiration_month_table[256] = {
+    ['A'] = { 1, 'C' }, ['B'] = { 2, 'C' }, ['C'] = { 3, 'C' }, ['D'] = { 4, 'C' },
+    ['E'] = { 5, 'C' }, ['F'] = { 6, 'C' }, ['G'] = { 7, 'C' }, ['H'] = { 8, 'C' },
+    ['I'] = { 9, 'C' }, ['J'] = { 10, 'C' }, ['K'] = { 11, 'C' }, ['L'] = { 12, 'C' },
+    ['M'] = { 1, 'P' }, ['N'] = { 2, 'P' }, ['O'] = { 3, 'P' }, ['P'] = { 4, 'P' },
+    ['Q'] = { 5, 'P' }, ['R'] = { 6, 'P' }, ['S'] = { 7, 'P' }, ['T'] = { 8, 'P' },
+    ['U'] = { 9, 'P' }, ['V'] = { 10, 'P' }, ['W'] = { 11, 'P' }, ['X'] = { 12, 'P' },
+};
+
+static const uint8_t opra_days_in_month[13] = { 0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+/*days from 1970-01-01 to a date of the proleptic Gregorian calendar, shifted to start the year in March
+  so the leap day comes last*/
+static int32_t opra_epoch_day(unsigned year, unsigned month, unsigned day)
+{
+    if (month <= 2)
+        year--;
+    const unsigned era_year = year % 400;
+    const int32_t era = (int32_t) (year / 400);
+    const unsigned year_day = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned era_day = era_year * 365 + era_year / 4 - era_year / 100 + year_day;
+    return era * 146097 + (int32_t) era_day - 719468;
+}
+
+bool opra_expiration_decode(const uint8_t *expiration_block, opra_expiration *expiration)
+{
+    const opra_expiration_month *month = &opra_expiration_month_table[expiration_block[0]];
+    expiration->year = (uint16_t) (2000 + expiration_block[2]);
+    expiration->month = month->month;
+    expiration->put_call = month->put_call;
+    expiration->day = expiration_block[1];
+
+    const bool leap = (0 == expiration->year % 4) && ((0 != expiration->year % 100) || (0 == expiration->year % 400));
+    expiration->valid = (0 != month->month) && (expiration->day >= 1) && (expiration->day <= opra_days_in_month[month->month])
+        && ((2 != month->month) || (expiration->day <= 28) || leap);
+    expiration->epoch_day = expiration->valid ? opra_epoch_day(expiration->year, expiration->month, expiration->day) : 0;
+    return expiration->valid;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
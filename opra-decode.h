@@ -0,0 +1,363 @@
+/* opra-decode.h
+ *
+ * Standalone OPRA block decoder.
+ * Has no epan dependency, so it can be linked into feed handlers and replay tools as well as the dissector.
+ * All functions work over a caller supplied buffer, never allocate and keep no state between calls,
+ * so they are safe to use from any number of threads.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_DECODE_H__
+#define __OPRA_DECODE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*block header size and message header size are fixed. Message sizes vary.*/
+#define OPRA_BLOCK_HEADER_SIZE 21
+#define OPRA_MESSAGE_HEADER_SIZE 12
+
+/*block format version this decoder was written against*/
+#define OPRA_BLOCK_VERSION 6
+
+/*offsets of the header bytes needed to walk a block without decoding it*/
+#define OPRA_BLOCK_SIZE_OFFSET 1
+#define OPRA_BLOCK_DATA_FEED_INDICATOR_OFFSET 3
+#define OPRA_BLOCK_RETRANSMISSION_INDICATOR_OFFSET 4
+#define OPRA_BLOCK_MESSAGES_IN_BLOCK_OFFSET 10
+#define OPRA_BLOCK_CHECKSUM_OFFSET 19
+#define OPRA_MESSAGE_CATEGORY_OFFSET 1
+#define OPRA_MESSAGE_TYPE_OFFSET 2
+#define OPRA_MESSAGE_INDICATOR_OFFSET 3
+
+/*message body sizes, excluding the message header.  Administrative messages are variable length.*/
+#define OPRA_MSG_CAT_C_DATA_LENGTH_SIZE 2
+#define OPRA_MSG_CAT_H_SIZE 0
+#define OPRA_MSG_CAT_Y_SIZE 15
+#define OPRA_MSG_CAT_a_SIZE 31
+#define OPRA_MSG_CAT_d_SIZE 18
+#define OPRA_MSG_CAT_f_SIZE 56
+#define OPRA_MSG_CAT_k_SIZE 31
+#define OPRA_MSG_CAT_q_SIZE 17
+#define OPRA_QUOTE_APPENDAGE_SIZE 10
+
+/*control message type for Reset Block Sequence Number, see OPRA_MSG_CAT_H_TYPES in packet-opra.c*/
+#define OPRA_MSG_CAT_H_RESET_BLOCK_SEQUENCE_NUMBER 'K'
+
+/*longest message of a fixed length category, an end of day summary.  Quotes with both appendages are shorter.*/
+#define OPRA_MESSAGE_MAX_FIXED_SIZE (OPRA_MESSAGE_HEADER_SIZE + OPRA_MSG_CAT_f_SIZE)
+
+/*instrument fields.  Short quotes carry a 4 character symbol, everything else 5.*/
+#define OPRA_SECURITY_SYMBOL_SIZE 5
+#define OPRA_SHORT_SECURITY_SYMBOL_SIZE 4
+#define OPRA_EXPIRATION_BLOCK_SIZE 3
+
+/*Message Indicator properties, indexed directly by the indicator byte.
+  Best offer appendages follow indicators CGKO, best bid appendages follow MNOP.
+  Each side of the best bid and offer is either unchanged, the quote's own, an appendage's or gone.*/
+#define OPRA_INDICATOR_BID_APPENDAGE    0x01
+#define OPRA_INDICATOR_OFFER_APPENDAGE  0x02
+#define OPRA_INDICATOR_BID_IN_QUOTE     0x04    /*the quote's bid is the best bid*/
+#define OPRA_INDICATOR_OFFER_IN_QUOTE   0x08
+#define OPRA_INDICATOR_NO_BID           0x10    /*there is no best bid*/
+#define OPRA_INDICATOR_NO_OFFER         0x20
+
+extern const uint8_t opra_indicator_table[256];
+
+/*per category properties, indexed directly by the category byte*/
+#define OPRA_CATEGORY_KNOWN             0x01
+#define OPRA_CATEGORY_VARIABLE_LENGTH   0x02    /*body_size is the data length field, the data follows it*/
+#define OPRA_CATEGORY_QUOTE             0x04    /*may be followed by bid and offer appendages*/
+
+typedef struct _opra_category_info {
+    uint8_t body_size;  /*fixed body size, excluding the message header and any appendages*/
+    uint8_t flags;
+} opra_category_info;
+
+extern const opra_category_info opra_category_table[256];
+
+static inline const opra_category_info *opra_category_lookup(uint8_t message_category)
+{
+    return &opra_category_table[message_category];
+}
+
+typedef enum _opra_decode_status {
+    OPRA_DECODE_OK,
+    OPRA_DECODE_END,                /*no more blocks or messages*/
+    OPRA_DECODE_TRUNCATED,
+    OPRA_DECODE_UNKNOWN_CATEGORY
+} opra_decode_status;
+
+typedef struct _opra_block_header {
+    uint8_t version;
+    uint16_t block_size;
+    uint8_t data_feed_indicator;
+    uint8_t retransmission_indicator;
+    uint8_t session_indicator;
+    uint32_t block_sequence_number;
+    uint8_t messages_in_block;
+    uint32_t timestamp_secs;
+    uint32_t timestamp_nsecs;
+    uint16_t checksum;
+} opra_block_header;
+
+typedef struct _opra_message_header {
+    uint8_t participant_id;
+    uint8_t message_category;
+    uint8_t message_type;
+    uint8_t message_indicator;
+    uint32_t transaction_id;
+    uint32_t participant_reference_number;
+} opra_message_header;
+
+/*symbols and expiration blocks point into the block, they are not copied*/
+typedef struct _opra_msg_cat_C {
+    uint16_t data_length;
+    const uint8_t *data;
+} opra_msg_cat_C;
+
+typedef struct _opra_msg_cat_Y {
+    const uint8_t *security_symbol;
+    uint8_t index_value_denominator_code;
+    uint32_t index_value;
+} opra_msg_cat_Y;
+
+typedef struct _opra_msg_cat_a {
+    const uint8_t *security_symbol;
+    const uint8_t *expiration_block;
+    uint8_t strike_price_denominator_code;
+    uint32_t strike_price;
+    uint32_t volume;
+    uint8_t premium_price_denominator_code;
+    uint32_t premium_price;
+    uint32_t trade_identifier;
+} opra_msg_cat_a;
+
+typedef struct _opra_msg_cat_d {
+    const uint8_t *security_symbol;
+    const uint8_t *expiration_block;
+    uint8_t strike_price_denominator_code;
+    uint32_t strike_price;
+    uint32_t volume;
+} opra_msg_cat_d;
+
+/*prices are in the premium price denominator code, the underlying price has its own*/
+typedef struct _opra_msg_cat_f {
+    const uint8_t *security_symbol;
+    const uint8_t *expiration_block;
+    uint8_t strike_price_denominator_code;
+    uint32_t strike_price;
+    uint32_t volume;
+    uint32_t open_interest;
+    uint8_t premium_price_denominator_code;
+    uint32_t open_price;
+    uint32_t high_price;
+    uint32_t low_price;
+    uint32_t last_price;
+    int32_t net_change;
+    uint8_t underlying_price_denominator_code;
+    uint32_t underlying_price;
+    uint32_t bid_price;
+    uint32_t offer_price;
+} opra_msg_cat_f;
+
+typedef struct _opra_msg_cat_k {
+    const uint8_t *security_symbol;
+    const uint8_t *expiration_block;
+    uint8_t strike_price_denominator_code;
+    uint32_t strike_price;
+    uint8_t premium_price_denominator_code;
+    uint32_t bid_price;
+    uint32_t bid_size;
+    uint32_t offer_price;
+    uint32_t offer_size;
+} opra_msg_cat_k;
+
+typedef struct _opra_msg_cat_q {
+    const uint8_t *security_symbol;
+    const uint8_t *expiration_block;
+    uint16_t strike_price;
+    uint16_t bid_price;
+    uint16_t bid_size;
+    uint16_t offer_price;
+    uint16_t offer_size;
+} opra_msg_cat_q;
+
+typedef enum _opra_appendage_side {
+    OPRA_APPENDAGE_BID,
+    OPRA_APPENDAGE_OFFER
+} opra_appendage_side;
+
+typedef struct _opra_quote_appendage {
+    opra_appendage_side side;
+    uint8_t participant_id;
+    uint8_t denominator_code;
+    uint32_t price;
+    uint32_t size;
+} opra_quote_appendage;
+
+typedef struct _opra_message {
+    int offset;     /*offset of the message header within the block*/
+    int length;     /*header, body and any appendages*/
+    opra_message_header hdr;
+    union {
+        opra_msg_cat_C C;
+        opra_msg_cat_Y Y;
+        opra_msg_cat_a a;
+        opra_msg_cat_d d;
+        opra_msg_cat_f f;
+        opra_msg_cat_k k;
+        opra_msg_cat_q q;
+    } body;
+    const uint8_t *appendages;      /*first appendage, if any*/
+    unsigned appendage_count;
+} opra_message;
+
+/*a block within a caller supplied buffer*/
+typedef struct _opra_block {
+    const uint8_t *data;
+    int length;     /*bytes available to the message walk*/
+    opra_block_header hdr;
+} opra_block;
+
+/*walks back to back blocks in a buffer, each delimited by its block size*/
+typedef struct _opra_block_iter {
+    const uint8_t *data;
+    size_t length;
+    size_t offset;
+} opra_block_iter;
+
+/*walks the messages of one block*/
+typedef struct _opra_message_iter {
+    const opra_block *block;
+    int offset;     /*offset of the next message, or of the end of the last one*/
+    unsigned index;
+} opra_message_iter;
+
+/*walks the quote appendages of one message, bid before offer*/
+typedef struct _opra_appendage_iter {
+    const opra_message *msg;
+    unsigned index;
+} opra_appendage_iter;
+
+/*Decode the block header at data.  length is the number of bytes the message walk may use,
+  normally the captured length of a datagram.  Returns OPRA_DECODE_TRUNCATED if the header isn't complete.*/
+opra_decode_status opra_decode_block(const uint8_t *data, int length, opra_block *block);
+
+/*Cheap check that data looks like the start of an OPRA block of exactly length bytes, for heuristic dissection.
+  Only reads the fixed header bytes and runs in constant time.  data must hold OPRA_BLOCK_HEADER_SIZE bytes.*/
+bool opra_block_is_plausible(const uint8_t *data, size_t length, uint8_t version);
+
+void opra_block_iter_init(opra_block_iter *iter, const uint8_t *data, size_t length);
+opra_decode_status opra_block_iter_next(opra_block_iter *iter, opra_block *block);
+
+/*Length of the message starting at p, including header and appendages.
+  Only the category, indicator and (for administrative messages) data length bytes are read.*/
+opra_decode_status opra_message_length(const uint8_t *p, int remaining, int *length);
+
+/*Decode the message at offset within the block.  The message length is validated before any body field is read.
+  The header is decoded even for unrecognized categories so it can still be displayed.*/
+opra_decode_status opra_decode_message(const opra_block *block, int offset, opra_message *msg);
+
+void opra_message_iter_init(opra_message_iter *iter, const opra_block *block);
+opra_decode_status opra_message_iter_next(opra_message_iter *iter, opra_message *msg);
+
+/*Advance past the next message without decoding it*/
+opra_decode_status opra_message_iter_skip(opra_message_iter *iter);
+
+/*Advance past a next message of unknown category, which carries no length of its own.  The messages after it
+  have to end exactly at the end of the block, less any pad byte, so its length is taken to be the shortest that
+  lets them, no longer than OPRA_MESSAGE_MAX_FIXED_SIZE.  The last message in a block takes the rest of it.
+  Either way the length is a guess, a different one may fit as well.
+  length is set to the message length including the header.  Returns OPRA_DECODE_UNKNOWN_CATEGORY, leaving
+  the iterator where it was, if no length fits, e.g. because a later message is of unknown category too.*/
+opra_decode_status opra_message_iter_resync(opra_message_iter *iter, int *length);
+
+/*Category of the next message, for deciding whether to decode or skip it.
+  Returns false at the end of the block or if the next message header isn't complete.*/
+static inline bool opra_message_iter_peek_category(const opra_message_iter *iter, uint8_t *message_category)
+{
+    if ((iter->index >= iter->block->hdr.messages_in_block) || (iter->offset + OPRA_MESSAGE_HEADER_SIZE > iter->block->length))
+        return false;
+
+    *message_category = iter->block->data[iter->offset + OPRA_MESSAGE_CATEGORY_OFFSET];
+    return true;
+}
+
+/*true if the block holds a message of this category and type, e.g. a control message.
+  Only message headers are read.  Messages of unknown category are stepped over as opra_message_iter_resync() does,
+  the walk stops quietly at the first message it can't find the length of.*/
+bool opra_block_has_message(const opra_block *block, uint8_t message_category, uint8_t message_type);
+
+void opra_appendage_iter_init(opra_appendage_iter *iter, const opra_message *msg);
+bool opra_appendage_iter_next(opra_appendage_iter *iter, opra_quote_appendage *appendage);
+
+/*An option series.  Put or call is carried by the expiration month code, so the expiration block covers it.
+  Keys are zero filled and have no padding, so they can be hashed and compared as bytes.*/
+typedef struct _opra_instrument_key {
+    uint8_t security_symbol[OPRA_SECURITY_SYMBOL_SIZE];    /*space padded, short quote symbols are padded to 5*/
+    uint8_t expiration_block[OPRA_EXPIRATION_BLOCK_SIZE];
+    int64_t strike_price;                                   /*scaled to 8 decimal places, see opra_price_scaled()*/
+} opra_instrument_key;
+
+/*Fill key from the instrument fields of a decoded a, d, f, k or q message.  Returns false for other categories
+  and for strikes with an invalid denominator code.*/
+bool opra_message_instrument(const opra_message *msg, opra_instrument_key *key);
+
+/*Expiration month codes, indexed directly by the code byte.  'A' to 'L' are calls for January to December,
+  'M' to 'X' the puts.  month is 0 for bytes that aren't a month code.*/
+typedef struct _opra_expiration_month {
+    uint8_t month;      /*1 to 12*/
+    uint8_t put_call;   /*'C' or 'P'*/
+} opra_expiration_month;
+
+extern const opra_expiration_month opra_expiration_month_table[256];
+
+/*An expiration block of month code, day and two digit year*/
+typedef struct _opra_expiration {
+    uint16_t year;      /*2000 on*/
+    uint8_t month;      /*0 for an invalid month code*/
+    uint8_t put_call;
+    uint8_t day;
+    bool valid;         /*month and day make a date*/
+    int32_t epoch_day;  /*days from 1970-01-01 to the expiration date, if valid*/
+} opra_expiration;
+
+/*Decode the 3 byte expiration block.  Returns false, leaving the fields that could be read, if it isn't a date.*/
+bool opra_expiration_decode(const uint8_t *expiration_block, opra_expiration *expiration);
+
+/*number of appendages that follow a quote with this message indicator*/
+static inline unsigned opra_quote_appendage_count(uint8_t message_indicator)
+{
+    const uint8_t flags = opra_indicator_table[message_indicator];
+    return (flags & OPRA_INDICATOR_BID_APPENDAGE) + ((flags & OPRA_INDICATOR_OFFER_APPENDAGE) >> 1);
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_DECODE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,486 @@
+/* opra-dump.c
+ *
+ * Prints the "opra" tap record of every message in a capture, built as the opra_dump target.
+ * The records come from the decode core alone, walking each block with a full decode and stepping over messages of
+ * unknown category as the dissector does, so they are what every one of the dissector's paths has to tap.
+ * The lines are those of tshark -z opra,records,<file>, see opra_tap_format(), which makes the output the golden
+ * records the regression tests compare tshark's against:
+ *
+ *   opra_dump [--port N[-M]] [--frames FIRST-LAST] [--summary OUT] FILE
+ *   opra_dump --summary OUT --merge SUMMARY...
+ *
+ * Reads classic pcap files of either byte order, Ethernet with an optional VLAN tag, IPv4 and UDP to the ports,
+ * 54321 by default.  Other frames, and with --frames those outside the range, are counted but not printed.
+ * --summary also writes the mergeable summary of what was read, the same as the first pass of the dissector would
+ * with the opra.summary_file preference, see opra-summary.h.  With --merge the summaries of the pieces of a split
+ * capture, given in capture order, are merged into OUT instead, and its lines and their sequence number gaps are
+ * printed.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opra-decode.h"
+#include "opra-summary.h"
+#include "opra-tap.h"
+
+#define OPRA_DUMP_MAX_RECORD 65535
+
+#define OPRA_DUMP_LINKTYPE_ETHERNET 1
+#define OPRA_DUMP_ETHERTYPE_IPV4 0x0800
+#define OPRA_DUMP_ETHERTYPE_VLAN 0x8100
+#define OPRA_DUMP_IP_PROTO_UDP 17
+
+#define OPRA_DUMP_USAGE "Usage: opra_dump [--port N[-M]] [--frames FIRST-LAST] [--summary OUT] FILE\n" \
+    "       opra_dump --summary OUT --merge SUMMARY...\n"
+
+typedef struct _opra_dump_options {
+    unsigned first_port;
+    unsigned last_port;
+    unsigned first_frame;
+    unsigned last_frame;
+    const char *summary_path;   /*NULL for no summary*/
+} opra_dump_options;
+
+static uint32_t opra_dump_get_uint32(const uint8_t *p, bool swapped)
+{
+    if (swapped)
+        return ((uint32_t) p[3] << 24) | ((uint32_t) p[2] << 16) | ((uint32_t) p[1] << 8) | p[0];
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static unsigned opra_dump_get_uint16(const uint8_t *p)
+{
+    return ((unsigned) p[0] << 8) | p[1];
+}
+
+/*Print the block's records.  summary, if not NULL, is fed as the dissector's first pass feeds it: every block
+  under its line, and the quotes and last sales of those that aren't retransmissions.  Returns false if memory runs out.*/
+static bool opra_dump_block(unsigned frame, const opra_block *block, opra_summary *summary, const opra_summary_line_key *key)
+{
+    bool ok = true;
+    if (NULL != summary){
+        opra_summary_line_key line_key = *key;
+        line_key.session_indicator = block->hdr.session_indicator;
+        ok = opra_summary_add_block(summary, &line_key, block, opra_block_has_message(block, 'H', OPRA_MSG_CAT_H_RESET_BLOCK_SEQUENCE_NUMBER));
+    }
+    const bool moves_book = (NULL != summary) && ('V' != block->hdr.retransmission_indicator);
+
+    opra_message_iter iter;
+    opra_message_iter_init(&iter, block);
+
+    for (;;){
+        opra_message msg;
+        opra_decode_status status = opra_message_iter_next(&iter, &msg);
+        if (OPRA_DECODE_OK == status){
+            opra_tap_info info;
+            char line[OPRA_TAP_FORMAT_SIZE];
+            opra_tap_fill(&info, block, &msg, iter.index - 1);
+            printf("frame=%u %s\n", frame, opra_tap_format(line, sizeof(line), &info));
+            if (moves_book && !opra_summary_add_message(summary, &msg))
+                ok = false;
+            continue;
+        }
+
+        /*nothing is tapped for a message of unknown category, the walk goes on past it if a length fits*/
+        int length;
+        if ((OPRA_DECODE_UNKNOWN_CATEGORY != status) || (OPRA_DECODE_OK != opra_message_iter_resync(&iter, &length)))
+            break;
+    }
+    return ok;
+}
+
+/*the blocks of one UDP payload, split as dissect_opra() splits them*/
+static bool opra_dump_datagram(unsigned frame, const uint8_t *data, int length, opra_summary *summary, const opra_summary_line_key *key)
+{
+    bool ok = true;
+    int offset = 0;
+    while (length - offset >= OPRA_BLOCK_HEADER_SIZE){
+        const int remaining = length - offset;
+        int block_size = (int) opra_dump_get_uint16(data + offset + OPRA_BLOCK_SIZE_OFFSET);
+        if ((block_size < OPRA_BLOCK_HEADER_SIZE) || (block_size > remaining))
+            block_size = remaining;
+
+        opra_block block;
+        if ((OPRA_DECODE_OK == opra_decode_block(data + offset, block_size, &block)) && !opra_dump_block(frame, &block, summary, key))
+            ok = false;
+        offset += block_size;
+    }
+    return ok;
+}
+
+/*The UDP payload of an Ethernet frame to one of the ports, or NULL.  key is set to the payload's line, less the
+  session indicator of each block.*/
+static const uint8_t *opra_dump_udp_payload(const uint8_t *frame, unsigned length, const opra_dump_options *options, int *payload_length,
+    opra_summary_line_key *key)
+{
+    unsigned offset = 12;
+    if (length < offset + 2)
+        return NULL;
+    unsigned ethertype = opra_dump_get_uint16(frame + offset);
+    offset += 2;
+    if (OPRA_DUMP_ETHERTYPE_VLAN == ethertype){
+        if (length < offset + 4)
+            return NULL;
+        ethertype = opra_dump_get_uint16(frame + offset + 2);
+        offset += 4;
+    }
+    if ((OPRA_DUMP_ETHERTYPE_IPV4 != ethertype) || (length < offset + 20))
+        return NULL;
+
+    const uint8_t *ip = frame + offset;
+    const unsigned header_length = (ip[0] & 0x0f) * 4u;
+    if ((4 != (ip[0] >> 4)) || (header_length < 20) || (OPRA_DUMP_IP_PROTO_UDP != ip[9]) || (length < offset + header_length + 8))
+        return NULL;
+    /*later fragments carry no UDP header*/
+    if (0 != (opra_dump_get_uint16(ip + 6) & 0x1fff))
+        return NULL;
+    offset += header_length;
+
+    const uint8_t *udp = frame + offset;
+    const unsigned port = opra_dump_get_uint16(udp + 2);
+    if ((port < options->first_port) || (port > options->last_port))
+        return NULL;
+    const unsigned udp_length = opra_dump_get_uint16(udp + 4);
+    if (udp_length < 8)
+        return NULL;
+    offset += 8;
+
+    /*the dissector walks what was captured of the datagram*/
+    unsigned available = length - offset;
+    if (udp_length - 8 < available)
+        available = udp_length - 8;
+    *payload_length = (int) available;
+
+    memset(key, 0, sizeof(*key));
+    memcpy(key->src, ip + 12, 4);
+    key->address_length = 4;
+    key->dst_port = (uint16_t) port;
+    return frame + offset;
+}
+
+/*write the summary to path, false with a message if it can't be*/
+static bool opra_dump_write_summary(const char *path, const opra_summary *summary)
+{
+    size_t size;
+    uint8_t *buf = opra_summary_write(summary, &size);
+    if (NULL == buf){
+        fprintf(stderr, "opra_dump: out of memory\n");
+        return false;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    const bool ok = (NULL != fp) && (1 == fwrite(buf, size, 1, fp));
+    if ((NULL == fp) || (0 != fclose(fp)) || !ok){
+        fprintf(stderr, "opra_dump: can't write %s\n", path);
+        free(buf);
+        return false;
+    }
+    free(buf);
+    return true;
+}
+
+static int opra_dump_capture(const char *path, const opra_dump_options *options)
+{
+    FILE *fp = fopen(path, "rb");
+    if (NULL == fp){
+        fprintf(stderr, "opra_dump: can't open %s\n", path);
+        return 1;
+    }
+
+    uint8_t header[24];
+    bool swapped = false;
+    if (1 != fread(header, sizeof(header), 1, fp)){
+        fprintf(stderr, "opra_dump: %s is not a pcap file\n", path);
+        fclose(fp);
+        return 1;
+    }
+    const uint32_t magic = opra_dump_get_uint32(header, false);
+    if ((0xd4c3b2a1 == magic) || (0x4d3cb2a1 == magic))
+        swapped = true;
+    else if ((0xa1b2c3d4 != magic) && (0xa1b23c4d != magic)){
+        fprintf(stderr, "opra_dump: %s is not a pcap file\n", path);
+        fclose(fp);
+        return 1;
+    }
+    if (OPRA_DUMP_LINKTYPE_ETHERNET != opra_dump_get_uint32(header + 20, swapped)){
+        fprintf(stderr, "opra_dump: %s is not an Ethernet capture\n", path);
+        fclose(fp);
+        return 1;
+    }
+
+    uint8_t *frame = (uint8_t *) malloc(OPRA_DUMP_MAX_RECORD);
+    opra_summary summary;
+    const bool summarizing = (NULL != options->summary_path);
+    if ((NULL == frame) || (summarizing && !opra_summary_init(&summary))){
+        fprintf(stderr, "opra_dump: out of memory\n");
+        if (summarizing)
+            opra_summary_free(&summary);
+        free(frame);
+        fclose(fp);
+        return 1;
+    }
+
+    int status = 0;
+    unsigned frames = 0;
+    uint8_t record[16];
+    while (1 == fread(record, sizeof(record), 1, fp)){
+        const uint32_t captured = opra_dump_get_uint32(record + 8, swapped);
+        if ((captured > OPRA_DUMP_MAX_RECORD) || ((0 != captured) && (1 != fread(frame, captured, 1, fp)))){
+            fprintf(stderr, "opra_dump: %s is cut short in frame %u\n", path, frames + 1);
+            status = 1;
+            break;
+        }
+        frames++;
+        if ((frames < options->first_frame) || (frames > options->last_frame))
+            continue;
+
+        int payload_length;
+        opra_summary_line_key key;
+        const uint8_t *payload = opra_dump_udp_payload(frame, captured, options, &payload_length, &key);
+        if ((NULL != payload) && !opra_dump_datagram(frames, payload, payload_length, summarizing ? &summary : NULL, &key)){
+            fprintf(stderr, "opra_dump: out of memory\n");
+            status = 1;
+            break;
+        }
+    }
+
+    if (summarizing){
+        if ((0 == status) && !opra_dump_write_summary(options->summary_path, &summary))
+            status = 1;
+        opra_summary_free(&summary);
+    }
+    free(frame);
+    fclose(fp);
+    return status;
+}
+
+/*the whole file in a malloc'd buffer, NULL if it can't be read*/
+static uint8_t *opra_dump_read_file(const char *path, size_t *size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (NULL == fp)
+        return NULL;
+
+    size_t allocated = 4096;
+    uint8_t *data = (uint8_t *) malloc(allocated);
+    size_t read;
+    *size = 0;
+    while ((NULL != data) && (0 != (read = fread(data + *size, 1, allocated - *size, fp)))){
+        *size += read;
+        if (*size == allocated){
+            uint8_t *grown = (uint8_t *) realloc(data, allocated * 2);
+            if (NULL == grown){
+                free(data);
+                data = NULL;
+                break;
+            }
+            data = grown;
+            allocated *= 2;
+        }
+    }
+    if ((NULL != data) && ferror(fp)){
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    return data;
+}
+
+static void opra_dump_print_gap(const opra_summary_range *gap, void *user_data)
+{
+    (void) user_data;
+    printf("  gap epoch=%u first=%u last=%u\n", gap->epoch, gap->first, gap->last);
+}
+
+/*lines in the order the summary file lists them*/
+static int opra_dump_line_order(const void *a, const void *b)
+{
+    const opra_summary_line *la = *(const opra_summary_line * const *) a;
+    const opra_summary_line *lb = *(const opra_summary_line * const *) b;
+    int order = memcmp(la->key.src, lb->key.src, OPRA_SUMMARY_MAX_ADDRESS_SIZE);
+    if (0 == order)
+        order = (int) la->key.address_length - (int) lb->key.address_length;
+    if (0 == order)
+        order = (int) la->key.dst_port - (int) lb->key.dst_port;
+    if (0 == order)
+        order = (int) la->key.session_indicator - (int) lb->key.session_indicator;
+    return order;
+}
+
+typedef struct _opra_dump_lines {
+    const opra_summary_line **lines;
+    uint32_t count;
+} opra_dump_lines;
+
+static void opra_dump_collect_line(void *record, void *user_data)
+{
+    opra_dump_lines *lines = (opra_dump_lines *) user_data;
+    lines->lines[lines->count++] = (const opra_summary_line *) record;
+}
+
+static bool opra_dump_print_summary(const opra_summary *summary)
+{
+    opra_dump_lines lines = { NULL, 0 };
+    lines.lines = (const opra_summary_line **) malloc(((size_t) summary->lines.count + 1) * sizeof(opra_summary_line *));
+    if (NULL == lines.lines)
+        return false;
+    opra_table_foreach(&summary->lines, opra_dump_collect_line, &lines);
+    qsort(lines.lines, lines.count, sizeof(opra_summary_line *), opra_dump_line_order);
+
+    printf("blocks=%llu msgs=%llu lines=%u instruments=%u\n", (unsigned long long) summary->blocks,
+        (unsigned long long) summary->messages, summary->lines.count, summary->instruments.count);
+    for (uint32_t i = 0; i < lines.count; i++){
+        const opra_summary_line *line = lines.lines[i];
+        const uint8_t *src = line->key.src;
+        if (4 == line->key.address_length){
+            printf("line src=%u.%u.%u.%u", src[0], src[1], src[2], src[3]);
+        } else {
+            printf("line src=");
+            for (unsigned b = 0; b < line->key.address_length; b++)
+                printf("%02x", src[b]);
+        }
+        printf(" port=%u session=%u blocks=%llu msgs=%llu retransmitted=%llu resets=%u covered=%llu missing=%llu\n",
+            line->key.dst_port, line->key.session_indicator, (unsigned long long) line->blocks, (unsigned long long) line->messages,
+            (unsigned long long) line->retransmitted_blocks, line->resets, (unsigned long long) opra_summary_line_covered(line),
+            (unsigned long long) opra_summary_line_gaps(line, NULL, NULL));
+        (void) opra_summary_line_gaps(line, opra_dump_print_gap, NULL);
+    }
+    free(lines.lines);
+    return true;
+}
+
+/*merge the summaries of the pieces, in capture order, into the one at path*/
+static int opra_dump_merge(const char *path, char *inputs[], int count)
+{
+    opra_summary merged;
+    if (!opra_summary_init(&merged)){
+        fprintf(stderr, "opra_dump: out of memory\n");
+        opra_summary_free(&merged);
+        return 1;
+    }
+
+    int status = 0;
+    for (int i = 0; (i < count) && (0 == status); i++){
+        size_t size;
+        uint8_t *data = opra_dump_read_file(inputs[i], &size);
+        if (NULL == data){
+            fprintf(stderr, "opra_dump: can't read %s\n", inputs[i]);
+            status = 1;
+            break;
+        }
+
+        opra_summary piece;
+        if (!opra_summary_init(&piece) || !opra_summary_read(&piece, data, size)){
+            fprintf(stderr, "opra_dump: %s is not an OPRA summary\n", inputs[i]);
+            status = 1;
+        } else if (!opra_summary_merge(&merged, &piece)){
+            fprintf(stderr, "opra_dump: out of memory\n");
+            status = 1;
+        }
+        opra_summary_free(&piece);
+        free(data);
+    }
+
+    if ((0 == status) && !opra_dump_write_summary(path, &merged))
+        status = 1;
+    if ((0 == status) && !opra_dump_print_summary(&merged)){
+        fprintf(stderr, "opra_dump: out of memory\n");
+        status = 1;
+    }
+    opra_summary_free(&merged);
+    return status;
+}
+
+/*N or N-M, each from 1 to max*/
+static bool opra_dump_parse_range(const char *s, unsigned max, unsigned *first, unsigned *last)
+{
+    char *end;
+    const unsigned long low = strtoul(s, &end, 10);
+    unsigned long high = low;
+    if ('-' == *end){
+        const char *high_start = end + 1;
+        high = strtoul(high_start, &end, 10);
+        if ('\0' == *high_start)
+            return false;
+    }
+    if ((s == end) || ('\0' != *end) || (0 == low) || (low > high) || (high > max))
+        return false;
+    *first = (unsigned) low;
+    *last = (unsigned) high;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    opra_dump_options options;
+    options.first_port = 54321;
+    options.last_port = 54321;
+    options.first_frame = 1;
+    options.last_frame = UINT32_MAX;
+    options.summary_path = NULL;
+    bool merge = false;
+    bool selected = false;
+    int i = 1;
+
+    for (; (i < argc) && !merge && (0 == strncmp(argv[i], "--", 2)); i++){
+        const char *option = argv[i];
+        if (0 == strcmp(option, "--merge")){
+            merge = true;
+            continue;
+        }
+        if (i + 1 == argc){
+            fprintf(stderr, OPRA_DUMP_USAGE);
+            return 1;
+        }
+        const char *value = argv[++i];
+        bool ok = true;
+        if (0 == strcmp(option, "--port"))
+            ok = opra_dump_parse_range(value, 65535, &options.first_port, &options.last_port);
+        else if (0 == strcmp(option, "--frames"))
+            ok = opra_dump_parse_range(value, UINT32_MAX, &options.first_frame, &options.last_frame);
+        else if (0 == strcmp(option, "--summary"))
+            options.summary_path = value;
+        else
+            ok = false;
+        if (!ok){
+            fprintf(stderr, OPRA_DUMP_USAGE);
+            return 1;
+        }
+        if (0 != strcmp(option, "--summary"))
+            selected = true;
+    }
+
+    if (merge){
+        if ((NULL == options.summary_path) || selected || (i == argc)){
+            fprintf(stderr, OPRA_DUMP_USAGE);
+            return 1;
+        }
+        return opra_dump_merge(options.summary_path, argv + i, argc - i);
+    }
+    if (i + 1 != argc){
+        fprintf(stderr, OPRA_DUMP_USAGE);
+        return 1;
+    }
+    return opra_dump_capture(argv[i], &options);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
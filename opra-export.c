@@ -0,0 +1,711 @@
+/* opra-export.c
+ *
+ * Arrow IPC stream writer for decoded OPRA messages, see opra-export.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opra-export.h"
+
+/*Arrow IPC constants, from Schema.fbs and Message.fbs*/
+#define ARROW_METADATA_V5 4
+#define ARROW_HEADER_SCHEMA 1
+#define ARROW_HEADER_DICTIONARY_BATCH 2
+#define ARROW_HEADER_RECORD_BATCH 3
+#define ARROW_TYPE_INT 2
+#define ARROW_TYPE_UTF8 5
+#define ARROW_TYPE_TIMESTAMP 10
+#define ARROW_TIME_UNIT_NANOSECOND 3
+#define ARROW_CONTINUATION 0xFFFFFFFFU
+
+/*every message and every body buffer starts on this boundary*/
+#define ARROW_ALIGNMENT 8
+
+/*stdio buffer of each stream*/
+#define OPRA_EXPORT_FILE_BUFFER_SIZE (1024 * 1024)
+
+/*A growing byte buffer.  After a failed allocation it stays as it is and every later write is dropped, the
+  failure is reported once the message is complete.*/
+typedef struct _opra_export_buffer {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    bool failed;
+} opra_export_buffer;
+
+static size_t opra_export_buffer_append(opra_export_buffer *buf, size_t n)
+{
+    const size_t pos = buf->length;
+    if (buf->failed)
+        return pos;
+
+    if (buf->length + n > buf->capacity){
+        size_t capacity = (0 != buf->capacity) ? buf->capacity : 1024;
+        while (capacity < buf->length + n)
+            capacity *= 2;
+        uint8_t *data = (uint8_t *) realloc(buf->data, capacity);
+        if (NULL == data){
+            buf->failed = true;
+            return pos;
+        }
+        buf->data = data;
+        buf->capacity = capacity;
+    }
+    memset(buf->data + pos, 0, n);
+    buf->length += n;
+    return pos;
+}
+
+static void opra_export_buffer_align(opra_export_buffer *buf, size_t alignment)
+{
+    if (0 != (buf->length % alignment))
+        opra_export_buffer_append(buf, alignment - (buf->length % alignment));
+}
+
+static inline void opra_export_put_uint(opra_export_buffer *buf, size_t pos, uint64_t value, unsigned size)
+{
+    if (buf->failed || (pos + size > buf->length))
+        return;
+    for (unsigned i = 0; i < size; i++)
+        buf->data[pos + i] = (uint8_t) (value >> (8 * i));
+}
+
+/*Flatbuffers, written front to back.  Tables are laid down before what they point at, so every offset points
+  forward as flatbuffers needs, and each vtable goes just ahead of its table.*/
+
+/*Add a table with one slot per field, sizes[i] is the field's size in bytes or 0 to leave it out.  Fields are
+  placed largest first and naturally aligned, and pos[i] is set to where each goes.*/
+static size_t opra_fb_table(opra_export_buffer *buf, unsigned num_slots, const uint8_t *sizes, size_t *pos)
+{
+    opra_export_buffer_align(buf, 2);
+    const size_t vtable = opra_export_buffer_append(buf, 4 + 2 * (size_t) num_slots);
+    opra_export_buffer_align(buf, ARROW_ALIGNMENT);
+    const size_t table = buf->length;
+
+    size_t end = 4;
+    for (unsigned i = 0; i < num_slots; i++)
+        pos[i] = 0;
+    for (unsigned size = 8; size > 0; size /= 2){
+        for (unsigned i = 0; i < num_slots; i++){
+            if (sizes[i] != size)
+                continue;
+            end = (end + size - 1) & ~((size_t) size - 1);
+            pos[i] = table + end;
+            end += size;
+        }
+    }
+    opra_export_buffer_append(buf, end);
+
+    opra_export_put_uint(buf, vtable, 4 + 2 * (uint64_t) num_slots, 2);
+    opra_export_put_uint(buf, vtable + 2, end, 2);
+    for (unsigned i = 0; i < num_slots; i++)
+        opra_export_put_uint(buf, vtable + 4 + 2 * (size_t) i, (0 != sizes[i]) ? pos[i] - table : 0, 2);
+    opra_export_put_uint(buf, table, table - vtable, 4);
+    return table;
+}
+
+/*point the offset at field to target, which must come after it*/
+static void opra_fb_link(opra_export_buffer *buf, size_t field, size_t target)
+{
+    opra_export_put_uint(buf, field, target - field, 4);
+}
+
+static size_t opra_fb_string(opra_export_buffer *buf, const char *str)
+{
+    const size_t length = strlen(str);
+    opra_export_buffer_align(buf, 4);
+    const size_t pos = opra_export_buffer_append(buf, 4 + length + 1);
+    opra_export_put_uint(buf, pos, length, 4);
+    if (!buf->failed)
+        memcpy(buf->data + pos + 4, str, length);
+    return pos;
+}
+
+/*Add a vector of count elements and return where the first element goes.  The length goes just ahead of it.*/
+static size_t opra_fb_vector(opra_export_buffer *buf, uint32_t count, size_t element_size, size_t alignment)
+{
+    opra_export_buffer_align(buf, 4);
+    if (0 != ((buf->length + 4) % alignment))
+        opra_export_buffer_append(buf, 4);
+    const size_t pos = opra_export_buffer_append(buf, 4 + count * element_size);
+    opra_export_put_uint(buf, pos, count, 4);
+    return pos + 4;
+}
+
+/*Start a Message: the root offset and the Message table.  Returns the slot of the header offset.*/
+static size_t opra_fb_message(opra_export_buffer *buf, uint8_t header_type, uint64_t body_length)
+{
+    static const uint8_t sizes[] = { 2, 1, 4, 8 };  /*version, header_type, header, bodyLength*/
+    size_t pos[4];
+
+    buf->length = 0;
+    buf->failed = false;
+    const size_t root = opra_export_buffer_append(buf, 4);
+    const size_t table = opra_fb_table(buf, 4, sizes, pos);
+    opra_fb_link(buf, root, table);
+    opra_export_put_uint(buf, pos[0], ARROW_METADATA_V5, 2);
+    opra_export_put_uint(buf, pos[1], header_type, 1);
+    opra_export_put_uint(buf, pos[3], body_length, 8);
+    return pos[2];
+}
+
+static size_t opra_fb_int_type(opra_export_buffer *buf, unsigned bit_width, bool is_signed)
+{
+    static const uint8_t sizes[] = { 4, 1 };        /*bitWidth, is_signed*/
+    size_t pos[2];
+
+    const size_t table = opra_fb_table(buf, 2, sizes, pos);
+    opra_export_put_uint(buf, pos[0], bit_width, 4);
+    opra_export_put_uint(buf, pos[1], is_signed ? 1 : 0, 1);
+    return table;
+}
+
+/*one buffer of a record batch body, padded out in the file*/
+typedef struct _opra_export_body_buffer {
+    const uint8_t *data;
+    uint64_t length;
+} opra_export_body_buffer;
+
+/*Add a RecordBatch table of length rows.  Each column is a node of node_lengths[i] values and null_counts[i]
+  nulls, and the buffers are laid end to end in the body, each padded out to ARROW_ALIGNMENT.*/
+static size_t opra_fb_record_batch(opra_export_buffer *buf, uint64_t length, unsigned num_nodes, const uint64_t *node_lengths,
+    const uint64_t *null_counts, unsigned num_buffers, const opra_export_body_buffer *buffers)
+{
+    static const uint8_t sizes[] = { 8, 4, 4 };     /*length, nodes, buffers*/
+    size_t pos[3];
+
+    const size_t table = opra_fb_table(buf, 3, sizes, pos);
+    opra_export_put_uint(buf, pos[0], length, 8);
+
+    size_t vector = opra_fb_vector(buf, num_nodes, 16, 8);
+    opra_fb_link(buf, pos[1], vector - 4);
+    for (unsigned i = 0; i < num_nodes; i++){
+        opra_export_put_uint(buf, vector + 16 * (size_t) i, node_lengths[i], 8);
+        opra_export_put_uint(buf, vector + 16 * (size_t) i + 8, null_counts[i], 8);
+    }
+
+    vector = opra_fb_vector(buf, num_buffers, 16, 8);
+    opra_fb_link(buf, pos[2], vector - 4);
+    uint64_t offset = 0;
+    for (unsigned i = 0; i < num_buffers; i++){
+        opra_export_put_uint(buf, vector + 16 * (size_t) i, offset, 8);
+        opra_export_put_uint(buf, vector + 16 * (size_t) i + 8, buffers[i].length, 8);
+        offset += (buffers[i].length + ARROW_ALIGNMENT - 1) & ~(uint64_t) (ARROW_ALIGNMENT - 1);
+    }
+    return table;
+}
+
+static uint64_t opra_export_body_length(unsigned num_buffers, const opra_export_body_buffer *buffers)
+{
+    uint64_t length = 0;
+    for (unsigned i = 0; i < num_buffers; i++)
+        length += (buffers[i].length + ARROW_ALIGNMENT - 1) & ~(uint64_t) (ARROW_ALIGNMENT - 1);
+    return length;
+}
+
+/*Symbol dictionary of one column.  Symbols are packed with their length into a 64 bit key, looked up in an
+  open addressed table and kept in first seen order.*/
+typedef struct _opra_export_dictionary {
+    uint64_t *slots;                /*key, 0 for an empty slot*/
+    int32_t *slot_indices;
+    uint32_t mask;
+    uint64_t *values;               /*keys in index order*/
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t written;               /*values already sent in dictionary batches*/
+    bool sent;                      /*the first dictionary batch is out, later ones are deltas*/
+    int64_t id;
+} opra_export_dictionary;
+
+static inline uint64_t opra_export_symbol_key(const char *symbol)
+{
+    uint64_t key = 0;
+    unsigned length = 0;
+    while ((length < OPRA_EXPORT_MAX_SYMBOL_SIZE) && ('\0' != symbol[length])){
+        key |= (uint64_t) (uint8_t) symbol[length] << (8 * length);
+        length++;
+    }
+    /*the length byte also keeps the empty symbol's key off 0*/
+    return key | ((uint64_t) (length + 1) << 56);
+}
+
+static inline unsigned opra_export_symbol_unpack(uint64_t key, uint8_t *symbol)
+{
+    const unsigned length = (unsigned) (key >> 56) - 1;
+    for (unsigned i = 0; i < length; i++)
+        symbol[i] = (uint8_t) (key >> (8 * i));
+    return length;
+}
+
+static inline unsigned opra_export_symbol_hash(uint64_t key)
+{
+    return (unsigned) ((key * UINT64_C(0x9E3779B97F4A7C15)) >> 32);
+}
+
+static bool opra_export_dictionary_grow(opra_export_dictionary *dict)
+{
+    const uint32_t slots = (0 != dict->mask) ? 2 * (dict->mask + 1) : 1024;
+    uint64_t *keys = (uint64_t *) calloc(slots, sizeof(uint64_t));
+    int32_t *indices = (int32_t *) calloc(slots, sizeof(int32_t));
+    if ((NULL == keys) || (NULL == indices)){
+        free(keys);
+        free(indices);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < dict->count; i++){
+        unsigned slot = opra_export_symbol_hash(dict->values[i]) & (slots - 1);
+        while (0 != keys[slot])
+            slot = (slot + 1) & (slots - 1);
+        keys[slot] = dict->values[i];
+        indices[slot] = (int32_t) i;
+    }
+    free(dict->slots);
+    free(dict->slot_indices);
+    dict->slots = keys;
+    dict->slot_indices = indices;
+    dict->mask = slots - 1;
+
+    uint64_t *values = (uint64_t *) realloc(dict->values, (slots / 2) * sizeof(uint64_t));
+    if (NULL == values)
+        return false;
+    dict->values = values;
+    dict->capacity = slots / 2;
+    return true;
+}
+
+/*index of the symbol, added if new.  -1 if the dictionary can't grow.*/
+static int32_t opra_export_dictionary_index(opra_export_dictionary *dict, const char *symbol)
+{
+    const uint64_t key = opra_export_symbol_key(symbol);
+    if (0 != dict->mask){
+        unsigned slot = opra_export_symbol_hash(key) & dict->mask;
+        while (0 != dict->slots[slot]){
+            if (key == dict->slots[slot])
+                return dict->slot_indices[slot];
+            slot = (slot + 1) & dict->mask;
+        }
+    }
+
+    /*kept at most half full*/
+    if ((dict->count >= dict->capacity) && !opra_export_dictionary_grow(dict))
+        return -1;
+
+    unsigned slot = opra_export_symbol_hash(key) & dict->mask;
+    while (0 != dict->slots[slot])
+        slot = (slot + 1) & dict->mask;
+    dict->slots[slot] = key;
+    dict->slot_indices[slot] = (int32_t) dict->count;
+    dict->values[dict->count] = key;
+    return (int32_t) dict->count++;
+}
+
+typedef struct _opra_export_column_data {
+    const opra_export_column *column;
+    unsigned width;                 /*bytes per value*/
+    uint8_t *values;                /*OPRA_EXPORT_BATCH_ROWS values, little endian*/
+    uint8_t *validity;              /*one bit per row, set for a value, only for nullable columns*/
+    uint32_t null_count;
+    opra_export_dictionary *dictionary;
+} opra_export_column_data;
+
+struct _opra_export_stream {
+    FILE *file;
+    char *file_buffer;
+    bool failed;
+    unsigned num_columns;
+    opra_export_column_data *columns;
+    uint32_t rows;                  /*rows in the current batch*/
+    uint64_t rows_written;
+    opra_export_buffer metadata;
+};
+
+static unsigned opra_export_type_width(opra_export_type type)
+{
+    switch(type)
+    {
+        case OPRA_EXPORT_UINT8:
+            return 1;
+        case OPRA_EXPORT_UINT16:
+            return 2;
+        case OPRA_EXPORT_UINT32:
+        case OPRA_EXPORT_SYMBOL:
+            return 4;
+        case OPRA_EXPORT_INT64:
+        case OPRA_EXPORT_TIMESTAMP_NS:
+        default:
+            return 8;
+    }
+}
+
+static void opra_export_write(opra_export_stream *stream, const void *data, size_t length)
+{
+    if (!stream->failed && (length > 0) && (fwrite(data, 1, length, stream->file) != length))
+        stream->failed = true;
+}
+
+static void opra_export_write_padding(opra_export_stream *stream, uint64_t length)
+{
+    static const uint8_t zeros[ARROW_ALIGNMENT] = { 0 };
+    const size_t padding = (size_t) ((ARROW_ALIGNMENT - (length % ARROW_ALIGNMENT)) % ARROW_ALIGNMENT);
+    opra_export_write(stream, zeros, padding);
+}
+
+/*write the message in stream->metadata and its body as one encapsulated message*/
+static void opra_export_write_message(opra_export_stream *stream, unsigned num_buffers, const opra_export_body_buffer *buffers)
+{
+    opra_export_buffer *metadata = &stream->metadata;
+    opra_export_buffer_align(metadata, ARROW_ALIGNMENT);
+    if (metadata->failed){
+        stream->failed = true;
+        return;
+    }
+
+    uint8_t prefix[8];
+    const uint32_t metadata_length = (uint32_t) metadata->length;
+    for (unsigned i = 0; i < 4; i++){
+        prefix[i] = (uint8_t) (ARROW_CONTINUATION >> (8 * i));
+        prefix[4 + i] = (uint8_t) (metadata_length >> (8 * i));
+    }
+    opra_export_write(stream, prefix, sizeof(prefix));
+    opra_export_write(stream, metadata->data, metadata->length);
+    for (unsigned i = 0; i < num_buffers; i++){
+        opra_export_write(stream, buffers[i].data, (size_t) buffers[i].length);
+        opra_export_write_padding(stream, buffers[i].length);
+    }
+}
+
+static void opra_export_write_schema(opra_export_stream *stream)
+{
+    static const uint8_t schema_sizes[] = { 2, 4 };                 /*endianness, fields*/
+    static const uint8_t field_sizes[] = { 4, 1, 1, 4, 4, 4 };      /*name, nullable, type_type, type, dictionary, children*/
+    static const uint8_t timestamp_sizes[] = { 2, 4 };              /*unit, timezone*/
+    static const uint8_t dictionary_sizes[] = { 8, 4, 1 };          /*id, indexType, isOrdered*/
+    opra_export_buffer *buf = &stream->metadata;
+    size_t pos[6];
+
+    const size_t header = opra_fb_message(buf, ARROW_HEADER_SCHEMA, 0);
+    const size_t schema = opra_fb_table(buf, 2, schema_sizes, pos);
+    opra_fb_link(buf, header, schema);
+    opra_export_put_uint(buf, pos[0], 0, 2);
+    const size_t fields_slot = pos[1];
+
+    const size_t fields = opra_fb_vector(buf, stream->num_columns, 4, 4);
+    opra_fb_link(buf, fields_slot, fields - 4);
+
+    for (unsigned i = 0; i < stream->num_columns; i++){
+        const opra_export_column_data *data = &stream->columns[i];
+        const opra_export_column *column = data->column;
+        uint8_t sizes[6];
+        memcpy(sizes, field_sizes, sizeof(sizes));
+        if (NULL == data->dictionary)
+            sizes[4] = 0;
+
+        const size_t field = opra_fb_table(buf, 6, sizes, pos);
+        opra_fb_link(buf, fields + 4 * (size_t) i, field);
+        const size_t name_slot = pos[0];
+        const size_t type_slot = pos[3];
+        const size_t dictionary_slot = pos[4];
+        const size_t children_slot = pos[5];
+        opra_export_put_uint(buf, pos[1], column->nullable ? 1 : 0, 1);
+
+        opra_fb_link(buf, name_slot, opra_fb_string(buf, column->name));
+
+        switch(column->type)
+        {
+            case OPRA_EXPORT_UINT8:
+            case OPRA_EXPORT_UINT16:
+            case OPRA_EXPORT_UINT32:
+                opra_export_put_uint(buf, pos[2], ARROW_TYPE_INT, 1);
+                opra_fb_link(buf, type_slot, opra_fb_int_type(buf, 8 * data->width, false));
+                break;
+            case OPRA_EXPORT_INT64:
+                opra_export_put_uint(buf, pos[2], ARROW_TYPE_INT, 1);
+                opra_fb_link(buf, type_slot, opra_fb_int_type(buf, 64, true));
+                break;
+            case OPRA_EXPORT_TIMESTAMP_NS:{
+                size_t timestamp_pos[2];
+                opra_export_put_uint(buf, pos[2], ARROW_TYPE_TIMESTAMP, 1);
+                const size_t timestamp = opra_fb_table(buf, 2, timestamp_sizes, timestamp_pos);
+                opra_fb_link(buf, type_slot, timestamp);
+                opra_export_put_uint(buf, timestamp_pos[0], ARROW_TIME_UNIT_NANOSECOND, 2);
+                opra_fb_link(buf, timestamp_pos[1], opra_fb_string(buf, "UTC"));
+                break;
+            }
+            case OPRA_EXPORT_SYMBOL:{
+                /*the field's type is the value type, the dictionary has the index type*/
+                size_t dictionary_pos[3];
+                opra_export_put_uint(buf, pos[2], ARROW_TYPE_UTF8, 1);
+                opra_fb_link(buf, type_slot, opra_fb_table(buf, 0, NULL, NULL));
+                const size_t dictionary = opra_fb_table(buf, 3, dictionary_sizes, dictionary_pos);
+                opra_fb_link(buf, dictionary_slot, dictionary);
+                opra_export_put_uint(buf, dictionary_pos[0], (uint64_t) data->dictionary->id, 8);
+                opra_export_put_uint(buf, dictionary_pos[2], 0, 1);
+                opra_fb_link(buf, dictionary_pos[1], opra_fb_int_type(buf, 32, true));
+                break;
+            }
+        }
+
+        /*readers insist on a children vector, even an empty one*/
+        opra_fb_link(buf, children_slot, opra_fb_vector(buf, 0, 4, 4) - 4);
+    }
+
+    opra_export_write_message(stream, 0, NULL);
+}
+
+/*Send the symbols added since the last dictionary batch.  The first batch of each dictionary isn't a delta.*/
+static void opra_export_write_dictionary(opra_export_stream *stream, opra_export_dictionary *dict)
+{
+    static const uint8_t sizes[] = { 8, 4, 1 };     /*id, data, isDelta*/
+    opra_export_buffer *buf = &stream->metadata;
+    size_t pos[3];
+
+    const uint32_t count = dict->count - dict->written;
+    int32_t *offsets = (int32_t *) malloc(((size_t) count + 1) * sizeof(int32_t));
+    uint8_t *chars = (uint8_t *) malloc((size_t) count * OPRA_EXPORT_MAX_SYMBOL_SIZE + 1);
+    if ((NULL == offsets) || (NULL == chars)){
+        free(offsets);
+        free(chars);
+        stream->failed = true;
+        return;
+    }
+
+    uint32_t length = 0;
+    for (uint32_t i = 0; i < count; i++){
+        uint8_t *p = (uint8_t *) &offsets[i];
+        for (unsigned b = 0; b < 4; b++)
+            p[b] = (uint8_t) (length >> (8 * b));
+        length += opra_export_symbol_unpack(dict->values[dict->written + i], chars + length);
+    }
+    uint8_t *p = (uint8_t *) &offsets[count];
+    for (unsigned b = 0; b < 4; b++)
+        p[b] = (uint8_t) (length >> (8 * b));
+
+    const opra_export_body_buffer buffers[3] = {
+        { NULL, 0 },
+        { (const uint8_t *) offsets, ((uint64_t) count + 1) * sizeof(int32_t) },
+        { chars, length }
+    };
+    const uint64_t node_length = count;
+    const uint64_t null_count = 0;
+
+    const size_t header = opra_fb_message(buf, ARROW_HEADER_DICTIONARY_BATCH, opra_export_body_length(3, buffers));
+    const size_t batch = opra_fb_table(buf, 3, sizes, pos);
+    opra_fb_link(buf, header, batch);
+    opra_export_put_uint(buf, pos[0], (uint64_t) dict->id, 8);
+    opra_export_put_uint(buf, pos[2], dict->sent ? 1 : 0, 1);
+    opra_fb_link(buf, pos[1], opra_fb_record_batch(buf, count, 1, &node_length, &null_count, 3, buffers));
+    opra_export_write_message(stream, 3, buffers);
+
+    free(offsets);
+    free(chars);
+    dict->written = dict->count;
+    dict->sent = true;
+}
+
+/*write the rows of the current batch, new symbols first*/
+static void opra_export_write_batch(opra_export_stream *stream)
+{
+    if (0 == stream->rows)
+        return;
+
+    for (unsigned i = 0; i < stream->num_columns; i++){
+        opra_export_dictionary *dict = stream->columns[i].dictionary;
+        if ((NULL != dict) && ((dict->count > dict->written) || !dict->sent))
+            opra_export_write_dictionary(stream, dict);
+    }
+
+    const unsigned num_columns = stream->num_columns;
+    uint64_t *node_lengths = (uint64_t *) malloc(num_columns * sizeof(uint64_t));
+    uint64_t *null_counts = (uint64_t *) malloc(num_columns * sizeof(uint64_t));
+    opra_export_body_buffer *buffers = (opra_export_body_buffer *) malloc(2 * num_columns * sizeof(opra_export_body_buffer));
+    if ((NULL == node_lengths) || (NULL == null_counts) || (NULL == buffers)){
+        stream->failed = true;
+    } else {
+        for (unsigned i = 0; i < num_columns; i++){
+            const opra_export_column_data *data = &stream->columns[i];
+            node_lengths[i] = stream->rows;
+            null_counts[i] = data->null_count;
+            /*no bitmap is needed without nulls*/
+            buffers[2 * i].data = data->validity;
+            buffers[2 * i].length = (0 != data->null_count) ? ((uint64_t) stream->rows + 7) / 8 : 0;
+            buffers[2 * i + 1].data = data->values;
+            buffers[2 * i + 1].length = (uint64_t) stream->rows * data->width;
+        }
+
+        opra_export_buffer *buf = &stream->metadata;
+        const size_t header = opra_fb_message(buf, ARROW_HEADER_RECORD_BATCH, opra_export_body_length(2 * num_columns, buffers));
+        opra_fb_link(buf, header, opra_fb_record_batch(buf, stream->rows, num_columns, node_lengths, null_counts, 2 * num_columns, buffers));
+        opra_export_write_message(stream, 2 * num_columns, buffers);
+    }
+    free(node_lengths);
+    free(null_counts);
+    free(buffers);
+
+    stream->rows_written += stream->rows;
+    stream->rows = 0;
+    for (unsigned i = 0; i < num_columns; i++){
+        opra_export_column_data *data = &stream->columns[i];
+        data->null_count = 0;
+        if (NULL != data->validity)
+            memset(data->validity, 0, OPRA_EXPORT_BATCH_ROWS / 8);
+    }
+}
+
+static void opra_export_stream_free(opra_export_stream *stream)
+{
+    if (NULL != stream->columns){
+        for (unsigned i = 0; i < stream->num_columns; i++){
+            opra_export_column_data *data = &stream->columns[i];
+            free(data->values);
+            free(data->validity);
+            if (NULL != data->dictionary){
+                free(data->dictionary->slots);
+                free(data->dictionary->slot_indices);
+                free(data->dictionary->values);
+                free(data->dictionary);
+            }
+        }
+        free(stream->columns);
+    }
+    free(stream->metadata.data);
+    free(stream->file_buffer);
+    free(stream);
+}
+
+opra_export_stream *opra_export_stream_open(const char *path, const opra_export_column *columns, unsigned num_columns)
+{
+    opra_export_stream *stream = (opra_export_stream *) calloc(1, sizeof(opra_export_stream));
+    if (NULL == stream)
+        return NULL;
+
+    stream->num_columns = num_columns;
+    stream->columns = (opra_export_column_data *) calloc(num_columns, sizeof(opra_export_column_data));
+    bool allocated = (NULL != stream->columns);
+    for (unsigned i = 0; allocated && (i < num_columns); i++){
+        opra_export_column_data *data = &stream->columns[i];
+        data->column = &columns[i];
+        data->width = opra_export_type_width(columns[i].type);
+        data->values = (uint8_t *) malloc((size_t) OPRA_EXPORT_BATCH_ROWS * data->width);
+        allocated = (NULL != data->values);
+        if (allocated && columns[i].nullable){
+            data->validity = (uint8_t *) calloc(OPRA_EXPORT_BATCH_ROWS / 8, 1);
+            allocated = (NULL != data->validity);
+        }
+        if (allocated && (OPRA_EXPORT_SYMBOL == columns[i].type)){
+            data->dictionary = (opra_export_dictionary *) calloc(1, sizeof(opra_export_dictionary));
+            allocated = (NULL != data->dictionary) && opra_export_dictionary_grow(data->dictionary);
+            if (NULL != data->dictionary)
+                data->dictionary->id = i;
+        }
+    }
+    stream->file_buffer = allocated ? (char *) malloc(OPRA_EXPORT_FILE_BUFFER_SIZE) : NULL;
+    if (NULL == stream->file_buffer){
+        opra_export_stream_free(stream);
+        return NULL;
+    }
+
+    stream->file = fopen(path, "wb");
+    if (NULL == stream->file){
+        opra_export_stream_free(stream);
+        return NULL;
+    }
+    setvbuf(stream->file, stream->file_buffer, _IOFBF, OPRA_EXPORT_FILE_BUFFER_SIZE);
+
+    opra_export_write_schema(stream);
+    return stream;
+}
+
+static inline void opra_export_set_value(opra_export_column_data *data, uint32_t row, uint64_t value)
+{
+    uint8_t *p = data->values + (size_t) row * data->width;
+    for (unsigned i = 0; i < data->width; i++)
+        p[i] = (uint8_t) (value >> (8 * i));
+    if (NULL != data->validity)
+        data->validity[row / 8] |= (uint8_t) (1U << (row % 8));
+}
+
+void opra_export_set_uint(opra_export_stream *stream, unsigned column, uint64_t value)
+{
+    opra_export_set_value(&stream->columns[column], stream->rows, value);
+}
+
+void opra_export_set_int(opra_export_stream *stream, unsigned column, int64_t value)
+{
+    opra_export_set_value(&stream->columns[column], stream->rows, (uint64_t) value);
+}
+
+void opra_export_set_symbol(opra_export_stream *stream, unsigned column, const char *symbol)
+{
+    opra_export_column_data *data = &stream->columns[column];
+    const int32_t index = opra_export_dictionary_index(data->dictionary, symbol);
+    if (index < 0){
+        stream->failed = true;
+        opra_export_set_null(stream, column);
+        return;
+    }
+    opra_export_set_value(data, stream->rows, (uint32_t) index);
+}
+
+void opra_export_set_null(opra_export_stream *stream, unsigned column)
+{
+    opra_export_column_data *data = &stream->columns[column];
+    memset(data->values + (size_t) stream->rows * data->width, 0, data->width);
+    /*the validity bit stays clear, a column that can't be null gets a zero*/
+    if (NULL != data->validity)
+        data->null_count++;
+}
+
+bool opra_export_end_row(opra_export_stream *stream)
+{
+    if (++stream->rows == OPRA_EXPORT_BATCH_ROWS)
+        opra_export_write_batch(stream);
+    return !stream->failed;
+}
+
+bool opra_export_stream_flush(opra_export_stream *stream)
+{
+    opra_export_write_batch(stream);
+    if (!stream->failed && (0 != fflush(stream->file)))
+        stream->failed = true;
+    return !stream->failed;
+}
+
+bool opra_export_stream_close(opra_export_stream *stream)
+{
+    static const uint8_t end_of_stream[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0 };
+
+    opra_export_write_batch(stream);
+    opra_export_write(stream, end_of_stream, sizeof(end_of_stream));
+    bool ok = !stream->failed;
+    if (0 != fclose(stream->file))
+        ok = false;
+    opra_export_stream_free(stream);
+    return ok;
+}
+
+uint64_t opra_export_stream_rows(const opra_export_stream *stream)
+{
+    return stream->rows_written + stream->rows;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
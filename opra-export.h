@@ -0,0 +1,89 @@
+/* opra-export.h
+ *
+ * Columnar export of decoded OPRA messages as Arrow IPC streams, one stream per message category.
+ * No epan dependency.  Rows are gathered a column at a time into fixed size batches, and each full batch goes out
+ * as one record batch through a buffered file, so a message costs a few stores.  Symbol columns are dictionary
+ * encoded, new symbols going out as delta dictionary batches ahead of the record batch that first uses them.
+ * Column buffers are allocated with malloc when the stream is opened.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_EXPORT_H__
+#define __OPRA_EXPORT_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*rows per record batch*/
+#define OPRA_EXPORT_BATCH_ROWS 65536
+
+/*longest value of a symbol column*/
+#define OPRA_EXPORT_MAX_SYMBOL_SIZE 7
+
+typedef enum _opra_export_type {
+    OPRA_EXPORT_UINT8,
+    OPRA_EXPORT_UINT16,
+    OPRA_EXPORT_UINT32,
+    OPRA_EXPORT_INT64,
+    OPRA_EXPORT_TIMESTAMP_NS,       /*int64 nanoseconds since the epoch, UTC*/
+    OPRA_EXPORT_SYMBOL              /*string dictionary encoded with int32 indices*/
+} opra_export_type;
+
+typedef struct _opra_export_column {
+    const char *name;
+    opra_export_type type;
+    bool nullable;
+} opra_export_column;
+
+typedef struct _opra_export_stream opra_export_stream;
+
+/*Create the file at path and write the schema.  The columns must outlive the stream.  NULL if the file can't
+  be created or the buffers can't be allocated.*/
+opra_export_stream *opra_export_stream_open(const char *path, const opra_export_column *columns, unsigned num_columns);
+
+/*Set a column of the current row.  Every column is set once per row, in any order.*/
+void opra_export_set_uint(opra_export_stream *stream, unsigned column, uint64_t value);
+void opra_export_set_int(opra_export_stream *stream, unsigned column, int64_t value);
+void opra_export_set_symbol(opra_export_stream *stream, unsigned column, const char *symbol);
+void opra_export_set_null(opra_export_stream *stream, unsigned column);
+
+/*Finish the current row, writing out the batch once it is full.  Returns false once a write has failed.*/
+bool opra_export_end_row(opra_export_stream *stream);
+
+/*Write out the rows of a partial batch and flush the file, which then holds a complete stream less the
+  end of stream marker*/
+bool opra_export_stream_flush(opra_export_stream *stream);
+
+/*Flush, end the stream and close the file.  Returns false if any write failed.*/
+bool opra_export_stream_close(opra_export_stream *stream);
+
+/*rows written so far, including any in the current batch*/
+uint64_t opra_export_stream_rows(const opra_export_stream *stream);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_EXPORT_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
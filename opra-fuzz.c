@@ -0,0 +1,210 @@
+/* opra-fuzz.c
+ *
+ * libFuzzer harness for the OPRA decode core, built as the opra_fuzz target.
+ * Each input is one UDP payload, split into blocks the way dissect_opra() splits a datagram.  Every block is walked
+ * by length alone as the tree-less and skip paths do, by a full decode as the tree path does and by a walk mixing
+ * the two as skip categories and the watchlist do, and all three must find the same messages at the same offsets.
+ * Message lengths, appendage counts, the control message scan and the vector checksum kernel are checked against
+ * the decode as well, and every decoded message goes through the book and the tap record formatting.
+ * A disagreement aborts, so the fuzzer keeps the input.
+ *
+ * With ENABLE_FUZZER or under OSS-Fuzz the engine provides main().  Otherwise a main() is built in that runs each
+ * file given on the command line once, which is how the checked-in corpus is replayed as a test:
+ *
+ *   opra_fuzz test/corpus/block-0001.bin ...
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opra-decode.h"
+#include "opra-book.h"
+#include "opra-checksum.h"
+#include "opra-tap.h"
+
+int LLVMFuzzerInitialize(int *argc, char ***argv);
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+#define OPRA_FUZZ_CHECK(condition) \
+    do { \
+        if (!(condition)){ \
+            fprintf(stderr, "opra_fuzz: %s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            abort(); \
+        } \
+    } while (0)
+
+/*the values the tree path would show, the tap would record and the book would apply*/
+static void opra_fuzz_message(const opra_block *block, const opra_message *msg, unsigned index, opra_book_top *top)
+{
+    opra_instrument_key key;
+    opra_tap_info info;
+    char line[OPRA_TAP_FORMAT_SIZE];
+    unsigned written;
+
+    (void) opra_message_instrument(msg, &key);
+    (void) opra_book_apply(top, msg, &written);
+    opra_tap_fill(&info, block, msg, index);
+    OPRA_FUZZ_CHECK((info.message_offset == msg->offset) && (info.message_length == msg->length));
+    OPRA_FUZZ_CHECK(strlen(opra_tap_format(line, sizeof(line), &info)) + 1 < sizeof(line));
+}
+
+/*Walk the block by skipping, by decoding and by both turn about, as opra_crosscheck_block() does in the dissector*/
+static void opra_fuzz_block(const opra_block *block)
+{
+    opra_message_iter skip_iter, decode_iter, mixed_iter;
+    opra_message msg;
+    opra_book_top top;
+    bool reset = false;
+    opra_message_iter_init(&skip_iter, block);
+    opra_message_iter_init(&decode_iter, block);
+    opra_message_iter_init(&mixed_iter, block);
+    opra_book_top_init(&top);
+
+    for (;;){
+        const int offset = decode_iter.offset;
+        opra_message mixed_msg;
+        opra_decode_status skip_status = opra_message_iter_skip(&skip_iter);
+        opra_decode_status decode_status = opra_message_iter_next(&decode_iter, &msg);
+        opra_decode_status mixed_status = (mixed_iter.index % 2) ?
+            opra_message_iter_skip(&mixed_iter) : opra_message_iter_next(&mixed_iter, &mixed_msg);
+        OPRA_FUZZ_CHECK((skip_status == decode_status) && (mixed_status == decode_status));
+
+        if (OPRA_DECODE_UNKNOWN_CATEGORY == decode_status){
+            int skip_len, decode_len, mixed_len;
+            skip_status = opra_message_iter_resync(&skip_iter, &skip_len);
+            decode_status = opra_message_iter_resync(&decode_iter, &decode_len);
+            mixed_status = opra_message_iter_resync(&mixed_iter, &mixed_len);
+            OPRA_FUZZ_CHECK((skip_status == decode_status) && (mixed_status == decode_status));
+            OPRA_FUZZ_CHECK((OPRA_DECODE_OK != decode_status) || ((skip_len == decode_len) && (mixed_len == decode_len)));
+            /*only the last message may be longer than any the spec has*/
+            OPRA_FUZZ_CHECK((OPRA_DECODE_OK != decode_status) || (decode_len <= OPRA_MESSAGE_MAX_FIXED_SIZE) ||
+                (decode_iter.offset == block->length));
+        } else if (OPRA_DECODE_OK == decode_status){
+            int length;
+            OPRA_FUZZ_CHECK(msg.offset == offset);
+            OPRA_FUZZ_CHECK(OPRA_DECODE_OK == opra_message_length(block->data + offset, block->length - offset, &length));
+            OPRA_FUZZ_CHECK((length == msg.length) && (offset + msg.length == decode_iter.offset));
+            if (opra_category_lookup(msg.hdr.message_category)->flags & OPRA_CATEGORY_QUOTE)
+                OPRA_FUZZ_CHECK(msg.appendage_count == opra_quote_appendage_count(msg.hdr.message_indicator));
+            if (('H' == msg.hdr.message_category) && (OPRA_MSG_CAT_H_RESET_BLOCK_SEQUENCE_NUMBER == msg.hdr.message_type))
+                reset = true;
+            opra_fuzz_message(block, &msg, decode_iter.index - 1, &top);
+        }
+        OPRA_FUZZ_CHECK((skip_iter.offset == decode_iter.offset) && (skip_iter.index == decode_iter.index));
+        OPRA_FUZZ_CHECK((mixed_iter.offset == decode_iter.offset) && (mixed_iter.index == decode_iter.index));
+        if (OPRA_DECODE_OK != decode_status)
+            break;
+    }
+    OPRA_FUZZ_CHECK(reset == opra_block_has_message(block, 'H', OPRA_MSG_CAT_H_RESET_BLOCK_SEQUENCE_NUMBER));
+
+    const int block_size = block->hdr.block_size;
+    if ((block_size >= OPRA_BLOCK_HEADER_SIZE) && (block_size <= block->length))
+        OPRA_FUZZ_CHECK(opra_block_checksum(block->data, (size_t) block_size) == opra_block_checksum_scalar(block->data, (size_t) block_size));
+}
+
+int LLVMFuzzerInitialize(int *argc, char ***argv)
+{
+    (void) argc;
+    (void) argv;
+    opra_checksum_init();
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    /*the heuristic's check, it must not read past the header*/
+    if (size >= OPRA_BLOCK_HEADER_SIZE)
+        (void) opra_block_is_plausible(data, size, OPRA_BLOCK_VERSION);
+
+    opra_block_iter iter;
+    opra_block_iter_init(&iter, data, size);
+    for (;;){
+        opra_block block;
+        const size_t offset = iter.offset;
+        const opra_decode_status status = opra_block_iter_next(&iter, &block);
+        if (OPRA_DECODE_END == status)
+            break;
+
+        if (OPRA_DECODE_OK == status){
+            opra_fuzz_block(&block);
+            continue;
+        }
+
+        /*a block size that can't be right leaves the rest to the block, as in dissect_opra()*/
+        if ((OPRA_DECODE_TRUNCATED == status) && (size - offset >= OPRA_BLOCK_HEADER_SIZE)){
+            OPRA_FUZZ_CHECK(OPRA_DECODE_OK == opra_decode_block(data + offset, (int) (size - offset), &block));
+            opra_fuzz_block(&block);
+        }
+        break;
+    }
+    return 0;
+}
+
+#ifdef OPRA_FUZZ_MAIN
+int main(int argc, char *argv[])
+{
+    if (argc < 2){
+        fprintf(stderr, "Usage: opra_fuzz FILE...\n");
+        return 1;
+    }
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    for (int i = 1; i < argc; i++){
+        FILE *fp = fopen(argv[i], "rb");
+        if (NULL == fp){
+            fprintf(stderr, "opra_fuzz: can't open %s\n", argv[i]);
+            return 1;
+        }
+
+        size_t size = 0;
+        size_t allocated = 4096;
+        uint8_t *data = (uint8_t *) malloc(allocated);
+        size_t read;
+        while ((NULL != data) && (0 != (read = fread(data + size, 1, allocated - size, fp)))){
+            size += read;
+            if (size == allocated){
+                uint8_t *grown = (uint8_t *) realloc(data, allocated * 2);
+                if (NULL == grown){
+                    free(data);
+                    data = NULL;
+                    break;
+                }
+                data = grown;
+                allocated *= 2;
+            }
+        }
+        const bool failed = (NULL == data) || ferror(fp);
+        fclose(fp);
+        if (failed){
+            fprintf(stderr, "opra_fuzz: can't read %s\n", argv[i]);
+            free(data);
+            return 1;
+        }
+
+        LLVMFuzzerTestOneInput(data, size);
+        free(data);
+    }
+    printf("opra_fuzz: %d inputs\n", argc - 1);
+    return 0;
+}
+#endif
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,333 @@
+/* opra-index.c
+ *
+ * Sidecar index of an OPRA capture, see opra-index.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <string.h>
+
+#include "opra-index.h"
+
+/*header field offsets*/
+#define OPRA_INDEX_VERSION_OFFSET 8
+#define OPRA_INDEX_FIRST_FRAME_OFFSET 12
+#define OPRA_INDEX_LAST_FRAME_OFFSET 16
+#define OPRA_INDEX_FIRST_FRAME_NSECS_OFFSET 20
+#define OPRA_INDEX_FIRST_FRAME_SECS_OFFSET 24
+#define OPRA_INDEX_INSTRUMENT_COUNT_OFFSET 32
+#define OPRA_INDEX_RANGE_COUNT_OFFSET 36
+#define OPRA_INDEX_LINE_COUNT_OFFSET 40
+#define OPRA_INDEX_CHECKPOINT_COUNT_OFFSET 44
+
+static inline void opra_index_put_uint16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+}
+
+static inline void opra_index_put_uint32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) (value >> 16);
+    p[3] = (uint8_t) (value >> 24);
+}
+
+static inline void opra_index_put_uint64(uint8_t *p, uint64_t value)
+{
+    opra_index_put_uint32(p, (uint32_t) value);
+    opra_index_put_uint32(p + 4, (uint32_t) (value >> 32));
+}
+
+static inline uint16_t opra_index_get_uint16(const uint8_t *p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static inline uint32_t opra_index_get_uint32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline uint64_t opra_index_get_uint64(const uint8_t *p)
+{
+    return (uint64_t) opra_index_get_uint32(p) | ((uint64_t) opra_index_get_uint32(p + 4) << 32);
+}
+
+/*section offsets, in 64 bits so a corrupt header can't wrap them.  Instruments follow the header.*/
+#define OPRA_INDEX_INSTRUMENTS_OFFSET OPRA_INDEX_HEADER_SIZE
+
+static uint64_t opra_index_ranges_offset(const opra_index_header *hdr)
+{
+    return OPRA_INDEX_INSTRUMENTS_OFFSET + (uint64_t) hdr->instrument_count * OPRA_INDEX_INSTRUMENT_SIZE;
+}
+
+static uint64_t opra_index_lines_offset(const opra_index_header *hdr)
+{
+    return opra_index_ranges_offset(hdr) + (uint64_t) hdr->range_count * OPRA_INDEX_RANGE_SIZE;
+}
+
+static uint64_t opra_index_checkpoints_offset(const opra_index_header *hdr)
+{
+    return opra_index_lines_offset(hdr) + (uint64_t) hdr->line_count * OPRA_INDEX_LINE_SIZE;
+}
+
+static uint64_t opra_index_end_offset(const opra_index_header *hdr)
+{
+    return opra_index_checkpoints_offset(hdr) + (uint64_t) hdr->checkpoint_count * OPRA_INDEX_CHECKPOINT_SIZE;
+}
+
+size_t opra_index_size(const opra_index_header *hdr)
+{
+    return (size_t) opra_index_end_offset(hdr);
+}
+
+void opra_index_put_header(uint8_t *buf, const opra_index_header *hdr)
+{
+    memset(buf, 0, OPRA_INDEX_HEADER_SIZE);
+    memcpy(buf, OPRA_INDEX_MAGIC, OPRA_INDEX_MAGIC_SIZE);
+    opra_index_put_uint32(buf + OPRA_INDEX_VERSION_OFFSET, OPRA_INDEX_VERSION);
+    opra_index_put_uint32(buf + OPRA_INDEX_FIRST_FRAME_OFFSET, hdr->first_frame);
+    opra_index_put_uint32(buf + OPRA_INDEX_LAST_FRAME_OFFSET, hdr->last_frame);
+    opra_index_put_uint32(buf + OPRA_INDEX_FIRST_FRAME_NSECS_OFFSET, hdr->first_frame_nsecs);
+    opra_index_put_uint64(buf + OPRA_INDEX_FIRST_FRAME_SECS_OFFSET, hdr->first_frame_secs);
+    opra_index_put_uint32(buf + OPRA_INDEX_INSTRUMENT_COUNT_OFFSET, hdr->instrument_count);
+    opra_index_put_uint32(buf + OPRA_INDEX_RANGE_COUNT_OFFSET, hdr->range_count);
+    opra_index_put_uint32(buf + OPRA_INDEX_LINE_COUNT_OFFSET, hdr->line_count);
+    opra_index_put_uint32(buf + OPRA_INDEX_CHECKPOINT_COUNT_OFFSET, hdr->checkpoint_count);
+}
+
+void opra_index_put_instrument(uint8_t *buf, uint32_t i, const opra_index_instrument *instrument)
+{
+    uint8_t *p = buf + OPRA_INDEX_INSTRUMENTS_OFFSET + (size_t) i * OPRA_INDEX_INSTRUMENT_SIZE;
+    memcpy(p, instrument->key.security_symbol, OPRA_SECURITY_SYMBOL_SIZE);
+    memcpy(p + 5, instrument->key.expiration_block, OPRA_EXPIRATION_BLOCK_SIZE);
+    opra_index_put_uint64(p + 8, (uint64_t) instrument->key.strike_price);
+    opra_index_put_uint32(p + 16, instrument->instrument_id);
+    opra_index_put_uint32(p + 20, instrument->message_count);
+    opra_index_put_uint32(p + 24, instrument->first_range);
+    opra_index_put_uint32(p + 28, instrument->range_count);
+}
+
+void opra_index_put_range(uint8_t *buf, const opra_index_header *hdr, uint32_t i, const opra_index_range *range)
+{
+    uint8_t *p = buf + opra_index_ranges_offset(hdr) + (size_t) i * OPRA_INDEX_RANGE_SIZE;
+    opra_index_put_uint32(p, range->first_frame);
+    opra_index_put_uint32(p + 4, range->last_frame);
+}
+
+void opra_index_put_line(uint8_t *buf, const opra_index_header *hdr, uint32_t i, const opra_index_line *line)
+{
+    uint8_t *p = buf + opra_index_lines_offset(hdr) + (size_t) i * OPRA_INDEX_LINE_SIZE;
+    p[0] = line->address_length;
+    p[1] = line->session_indicator;
+    opra_index_put_uint16(p + 2, line->dst_port);
+    memcpy(p + 4, line->src, OPRA_INDEX_MAX_ADDRESS_SIZE);
+    opra_index_put_uint32(p + 20, line->first_sequence);
+    opra_index_put_uint32(p + 24, line->last_sequence);
+    opra_index_put_uint32(p + 28, line->first_frame);
+    opra_index_put_uint32(p + 32, line->last_frame);
+    opra_index_put_uint32(p + 36, line->block_count);
+    opra_index_put_uint32(p + 40, line->first_checkpoint);
+    opra_index_put_uint32(p + 44, line->checkpoint_count);
+}
+
+void opra_index_put_checkpoint(uint8_t *buf, const opra_index_header *hdr, uint32_t i, const opra_index_checkpoint *checkpoint)
+{
+    uint8_t *p = buf + opra_index_checkpoints_offset(hdr) + (size_t) i * OPRA_INDEX_CHECKPOINT_SIZE;
+    opra_index_put_uint32(p, checkpoint->sequence);
+    opra_index_put_uint32(p + 4, checkpoint->frame);
+}
+
+int opra_index_compare_keys(const opra_instrument_key *a, const opra_instrument_key *b)
+{
+    int order = memcmp(a->security_symbol, b->security_symbol, OPRA_SECURITY_SYMBOL_SIZE);
+    if (0 == order)
+        order = memcmp(a->expiration_block, b->expiration_block, OPRA_EXPIRATION_BLOCK_SIZE);
+    if (0 == order)
+        order = (a->strike_price > b->strike_price) - (a->strike_price < b->strike_price);
+    return order;
+}
+
+bool opra_index_open(opra_index *idx, const uint8_t *data, size_t length)
+{
+    if ((length < OPRA_INDEX_HEADER_SIZE) || (0 != memcmp(data, OPRA_INDEX_MAGIC, OPRA_INDEX_MAGIC_SIZE)))
+        return false;
+
+    opra_index_header *hdr = &idx->hdr;
+    hdr->version = opra_index_get_uint32(data + OPRA_INDEX_VERSION_OFFSET);
+    if (OPRA_INDEX_VERSION != hdr->version)
+        return false;
+
+    hdr->first_frame = opra_index_get_uint32(data + OPRA_INDEX_FIRST_FRAME_OFFSET);
+    hdr->last_frame = opra_index_get_uint32(data + OPRA_INDEX_LAST_FRAME_OFFSET);
+    hdr->first_frame_nsecs = opra_index_get_uint32(data + OPRA_INDEX_FIRST_FRAME_NSECS_OFFSET);
+    hdr->first_frame_secs = opra_index_get_uint64(data + OPRA_INDEX_FIRST_FRAME_SECS_OFFSET);
+    hdr->instrument_count = opra_index_get_uint32(data + OPRA_INDEX_INSTRUMENT_COUNT_OFFSET);
+    hdr->range_count = opra_index_get_uint32(data + OPRA_INDEX_RANGE_COUNT_OFFSET);
+    hdr->line_count = opra_index_get_uint32(data + OPRA_INDEX_LINE_COUNT_OFFSET);
+    hdr->checkpoint_count = opra_index_get_uint32(data + OPRA_INDEX_CHECKPOINT_COUNT_OFFSET);
+    if (opra_index_end_offset(hdr) > length)
+        return false;
+
+    idx->data = data;
+    idx->length = length;
+    return true;
+}
+
+void opra_index_get_instrument(const opra_index *idx, uint32_t i, opra_index_instrument *instrument)
+{
+    const uint8_t *p = idx->data + OPRA_INDEX_INSTRUMENTS_OFFSET + (size_t) i * OPRA_INDEX_INSTRUMENT_SIZE;
+    memset(&instrument->key, 0, sizeof(instrument->key));
+    memcpy(instrument->key.security_symbol, p, OPRA_SECURITY_SYMBOL_SIZE);
+    memcpy(instrument->key.expiration_block, p + 5, OPRA_EXPIRATION_BLOCK_SIZE);
+    instrument->key.strike_price = (int64_t) opra_index_get_uint64(p + 8);
+    instrument->instrument_id = opra_index_get_uint32(p + 16);
+    instrument->message_count = opra_index_get_uint32(p + 20);
+    instrument->first_range = opra_index_get_uint32(p + 24);
+    instrument->range_count = opra_index_get_uint32(p + 28);
+
+    /*a corrupt file can't send the range lookups outside the file*/
+    if ((instrument->first_range > idx->hdr.range_count) || (instrument->range_count > idx->hdr.range_count - instrument->first_range))
+        instrument->range_count = 0;
+}
+
+void opra_index_get_range(const opra_index *idx, uint32_t i, opra_index_range *range)
+{
+    const uint8_t *p = idx->data + opra_index_ranges_offset(&idx->hdr) + (size_t) i * OPRA_INDEX_RANGE_SIZE;
+    range->first_frame = opra_index_get_uint32(p);
+    range->last_frame = opra_index_get_uint32(p + 4);
+}
+
+void opra_index_get_line(const opra_index *idx, uint32_t i, opra_index_line *line)
+{
+    const uint8_t *p = idx->data + opra_index_lines_offset(&idx->hdr) + (size_t) i * OPRA_INDEX_LINE_SIZE;
+    line->address_length = p[0];
+    line->session_indicator = p[1];
+    line->dst_port = opra_index_get_uint16(p + 2);
+    memcpy(line->src, p + 4, OPRA_INDEX_MAX_ADDRESS_SIZE);
+    line->first_sequence = opra_index_get_uint32(p + 20);
+    line->last_sequence = opra_index_get_uint32(p + 24);
+    line->first_frame = opra_index_get_uint32(p + 28);
+    line->last_frame = opra_index_get_uint32(p + 32);
+    line->block_count = opra_index_get_uint32(p + 36);
+    line->first_checkpoint = opra_index_get_uint32(p + 40);
+    line->checkpoint_count = opra_index_get_uint32(p + 44);
+
+    if (line->address_length > OPRA_INDEX_MAX_ADDRESS_SIZE)
+        line->address_length = 0;
+    if ((line->first_checkpoint > idx->hdr.checkpoint_count) || (line->checkpoint_count > idx->hdr.checkpoint_count - line->first_checkpoint))
+        line->checkpoint_count = 0;
+}
+
+void opra_index_get_checkpoint(const opra_index *idx, uint32_t i, opra_index_checkpoint *checkpoint)
+{
+    const uint8_t *p = idx->data + opra_index_checkpoints_offset(&idx->hdr) + (size_t) i * OPRA_INDEX_CHECKPOINT_SIZE;
+    checkpoint->sequence = opra_index_get_uint32(p);
+    checkpoint->frame = opra_index_get_uint32(p + 4);
+}
+
+bool opra_index_find_instrument(const opra_index *idx, const opra_instrument_key *key, opra_index_instrument *instrument)
+{
+    uint32_t low = 0;
+    uint32_t high = idx->hdr.instrument_count;
+
+    while (low < high){
+        const uint32_t mid = low + (high - low) / 2;
+        opra_index_get_instrument(idx, mid, instrument);
+        const int order = opra_index_compare_keys(key, &instrument->key);
+        if (0 == order)
+            return true;
+        if (order < 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return false;
+}
+
+void opra_index_adjacent_frames(const opra_index *idx, const opra_index_instrument *instrument, uint32_t frame,
+    uint32_t *prev_frame, uint32_t *next_frame)
+{
+    opra_index_range range;
+
+    /*first range that ends at or after frame*/
+    uint32_t low = 0;
+    uint32_t high = instrument->range_count;
+    while (low < high){
+        const uint32_t mid = low + (high - low) / 2;
+        opra_index_get_range(idx, instrument->first_range + mid, &range);
+        if (range.last_frame < frame)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    *prev_frame = 0;
+    *next_frame = 0;
+    if (low > 0){
+        opra_index_get_range(idx, instrument->first_range + low - 1, &range);
+        *prev_frame = range.last_frame;
+    }
+    if (low == instrument->range_count)
+        return;
+
+    opra_index_get_range(idx, instrument->first_range + low, &range);
+    if (frame < range.first_frame){
+        *next_frame = range.first_frame;
+        return;
+    }
+
+    /*frame is inside the range*/
+    if (frame > range.first_frame)
+        *prev_frame = frame - 1;
+    if (frame < range.last_frame){
+        *next_frame = frame + 1;
+    } else if (low + 1 < instrument->range_count){
+        opra_index_get_range(idx, instrument->first_range + low + 1, &range);
+        *next_frame = range.first_frame;
+    }
+}
+
+bool opra_index_find_sequence(const opra_index *idx, const opra_index_line *line, uint32_t sequence, uint32_t *frame)
+{
+    if ((0 == line->checkpoint_count) || (sequence < line->first_sequence) || (sequence > line->last_sequence))
+        return false;
+
+    /*last checkpoint at or before sequence*/
+    opra_index_checkpoint checkpoint;
+    uint32_t low = 0;
+    uint32_t high = line->checkpoint_count;
+    while (low < high){
+        const uint32_t mid = low + (high - low) / 2;
+        opra_index_get_checkpoint(idx, line->first_checkpoint + mid, &checkpoint);
+        if (checkpoint.sequence <= sequence)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (0 == low)
+        return false;
+
+    opra_index_get_checkpoint(idx, line->first_checkpoint + low - 1, &checkpoint);
+    *frame = checkpoint.frame;
+    return true;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,156 @@
+/* opra-index.h
+ *
+ * Sidecar index of an OPRA capture: which frames carry each instrument's messages, and where each line's
+ * block sequence numbers are.  Written at the end of the first pass and memory mapped when the capture is reopened,
+ * so finding an instrument or a sequence number is a binary search instead of a pass over the capture.
+ * No epan dependency and no allocation.  The file is built and read through caller supplied buffers.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_INDEX_H__
+#define __OPRA_INDEX_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opra-decode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*File layout, every field little endian and every record fixed size so records are found by position:
+    header
+    instruments, sorted by key
+    frame ranges, each instrument's together and in frame order
+    lines, in the order they were first seen
+    sequence checkpoints, each line's together and in frame order*/
+#define OPRA_INDEX_MAGIC "OPRAIDX1"
+#define OPRA_INDEX_MAGIC_SIZE 8
+#define OPRA_INDEX_VERSION 1
+
+#define OPRA_INDEX_HEADER_SIZE 64
+#define OPRA_INDEX_INSTRUMENT_SIZE 32
+#define OPRA_INDEX_RANGE_SIZE 8
+#define OPRA_INDEX_LINE_SIZE 48
+#define OPRA_INDEX_CHECKPOINT_SIZE 8
+
+/*A line gets a sequence checkpoint at its first block, after every gap and every this many blocks in between,
+  so a sequence number lookup lands at most this many blocks early*/
+#define OPRA_INDEX_CHECKPOINT_INTERVAL 1024
+
+/*source address lengths an index line can hold*/
+#define OPRA_INDEX_MAX_ADDRESS_SIZE 16
+
+typedef struct _opra_index_header {
+    uint32_t version;
+    uint32_t first_frame;               /*first frame holding an OPRA block, with its capture time*/
+    uint32_t last_frame;                /*last frame holding an OPRA block*/
+    uint64_t first_frame_secs;          /*the first frame and its time are checked on reopening, to catch a stale index*/
+    uint32_t first_frame_nsecs;
+    uint32_t instrument_count;
+    uint32_t range_count;
+    uint32_t line_count;
+    uint32_t checkpoint_count;
+} opra_index_header;
+
+/*an instrument's messages are in frames first_frame to last_frame of each of its ranges*/
+typedef struct _opra_index_range {
+    uint32_t first_frame;
+    uint32_t last_frame;
+} opra_index_range;
+
+typedef struct _opra_index_instrument {
+    opra_instrument_key key;
+    uint32_t instrument_id;             /*opra.instrument_id when the index was written*/
+    uint32_t message_count;
+    uint32_t first_range;
+    uint32_t range_count;
+} opra_index_instrument;
+
+/*One run of a line's block sequence numbers.  A sequence number reset starts another run of the same line,
+  so sequence numbers only go up between a run's checkpoints.*/
+typedef struct _opra_index_line {
+    uint8_t address_length;             /*4 for IPv4, 16 for IPv6, 0 for anything else*/
+    uint8_t session_indicator;
+    uint16_t dst_port;
+    uint8_t src[OPRA_INDEX_MAX_ADDRESS_SIZE];
+    uint32_t first_sequence;
+    uint32_t last_sequence;             /*highest message sequence number*/
+    uint32_t first_frame;
+    uint32_t last_frame;
+    uint32_t block_count;
+    uint32_t first_checkpoint;
+    uint32_t checkpoint_count;
+} opra_index_line;
+
+typedef struct _opra_index_checkpoint {
+    uint32_t sequence;
+    uint32_t frame;
+} opra_index_checkpoint;
+
+/*an index file in memory, usually mapped*/
+typedef struct _opra_index {
+    const uint8_t *data;
+    size_t length;
+    opra_index_header hdr;
+} opra_index;
+
+/*bytes needed for an index of these counts*/
+size_t opra_index_size(const opra_index_header *hdr);
+
+/*Writers, each record into a buffer of opra_index_size() bytes.  Records may be written in any order.*/
+void opra_index_put_header(uint8_t *buf, const opra_index_header *hdr);
+void opra_index_put_instrument(uint8_t *buf, uint32_t i, const opra_index_instrument *instrument);
+void opra_index_put_range(uint8_t *buf, const opra_index_header *hdr, uint32_t i, const opra_index_range *range);
+void opra_index_put_line(uint8_t *buf, const opra_index_header *hdr, uint32_t i, const opra_index_line *line);
+void opra_index_put_checkpoint(uint8_t *buf, const opra_index_header *hdr, uint32_t i, const opra_index_checkpoint *checkpoint);
+
+/*Instruments in key order, as the file needs them.  Negative, zero or positive like memcmp().*/
+int opra_index_compare_keys(const opra_instrument_key *a, const opra_instrument_key *b);
+
+/*Check the header and that every section fits in length bytes.  The data must stay valid while idx is used.*/
+bool opra_index_open(opra_index *idx, const uint8_t *data, size_t length);
+
+/*Readers, i must be below the matching count in the header*/
+void opra_index_get_instrument(const opra_index *idx, uint32_t i, opra_index_instrument *instrument);
+void opra_index_get_range(const opra_index *idx, uint32_t i, opra_index_range *range);
+void opra_index_get_line(const opra_index *idx, uint32_t i, opra_index_line *line);
+void opra_index_get_checkpoint(const opra_index *idx, uint32_t i, opra_index_checkpoint *checkpoint);
+
+/*binary search for an instrument by key*/
+bool opra_index_find_instrument(const opra_index *idx, const opra_instrument_key *key, opra_index_instrument *instrument);
+
+/*The frames either side of frame that hold messages of the instrument, 0 if there are none.
+  frame itself needn't hold any.*/
+void opra_index_adjacent_frames(const opra_index *idx, const opra_index_instrument *instrument, uint32_t frame,
+    uint32_t *prev_frame, uint32_t *next_frame);
+
+/*The frame to start from to find block sequence number sequence on a run of a line, within
+  OPRA_INDEX_CHECKPOINT_INTERVAL blocks.  Returns false if the run doesn't cover the sequence number.*/
+bool opra_index_find_sequence(const opra_index *idx, const opra_index_line *line, uint32_t sequence, uint32_t *frame);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_INDEX_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,269 @@
+/* opra-pool.c
+ *
+ * Bounded memory building blocks for the OPRA dissector, see opra-pool.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "opra-pool.h"
+
+#define OPRA_ARENA_ALIGNMENT 8
+
+struct _opra_arena_chunk {
+    opra_arena_chunk *next;
+    size_t size;                    /*bytes after the header*/
+    size_t used;
+};
+
+/*the header is a multiple of the alignment, so allocations after it stay aligned*/
+#define OPRA_ARENA_HEADER_SIZE ((sizeof(opra_arena_chunk) + OPRA_ARENA_ALIGNMENT - 1) & ~(size_t) (OPRA_ARENA_ALIGNMENT - 1))
+
+void opra_arena_init(opra_arena *arena)
+{
+    arena->chunks = NULL;
+    arena->used = 0;
+    arena->reserved = 0;
+}
+
+void *opra_arena_alloc(opra_arena *arena, size_t size)
+{
+    size = (size + OPRA_ARENA_ALIGNMENT - 1) & ~(size_t) (OPRA_ARENA_ALIGNMENT - 1);
+
+    opra_arena_chunk *chunk = arena->chunks;
+    if ((NULL == chunk) || (chunk->size - chunk->used < size)){
+        const size_t chunk_size = (size > OPRA_ARENA_CHUNK_SIZE - OPRA_ARENA_HEADER_SIZE) ? size : OPRA_ARENA_CHUNK_SIZE - OPRA_ARENA_HEADER_SIZE;
+        opra_arena_chunk *added = (opra_arena_chunk *) malloc(OPRA_ARENA_HEADER_SIZE + chunk_size);
+        if (NULL == added)
+            return NULL;
+        added->size = chunk_size;
+        added->used = 0;
+        arena->reserved += OPRA_ARENA_HEADER_SIZE + chunk_size;
+
+        /*an oversized request leaves the newest chunk in front, it still has room*/
+        if ((NULL != chunk) && (chunk_size == size)){
+            added->next = chunk->next;
+            chunk->next = added;
+        } else {
+            added->next = chunk;
+            arena->chunks = added;
+        }
+        chunk = added;
+    }
+
+    uint8_t *p = (uint8_t *) chunk + OPRA_ARENA_HEADER_SIZE + chunk->used;
+    chunk->used += size;
+    arena->used += size;
+    memset(p, 0, size);
+    return p;
+}
+
+void opra_arena_free_all(opra_arena *arena)
+{
+    opra_arena_chunk *chunk = arena->chunks;
+    while (NULL != chunk){
+        opra_arena_chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    opra_arena_init(arena);
+}
+
+void opra_pool_init(opra_pool *pool, opra_arena *arena, size_t object_size)
+{
+    pool->arena = arena;
+    /*a free object holds the next free one*/
+    pool->object_size = (object_size < sizeof(void *)) ? sizeof(void *) : object_size;
+    pool->free_list = NULL;
+    pool->in_use = 0;
+    pool->free_count = 0;
+}
+
+void *opra_pool_alloc(opra_pool *pool)
+{
+    void *object = pool->free_list;
+    if (NULL != object){
+        memcpy(&pool->free_list, object, sizeof(void *));
+        pool->free_count--;
+        memset(object, 0, pool->object_size);
+    } else {
+        object = opra_arena_alloc(pool->arena, pool->object_size);
+        if (NULL == object)
+            return NULL;
+    }
+    pool->in_use++;
+    return object;
+}
+
+void opra_pool_free(opra_pool *pool, void *object)
+{
+    memcpy(object, &pool->free_list, sizeof(void *));
+    pool->free_list = object;
+    pool->in_use--;
+    pool->free_count++;
+}
+
+struct _opra_table_slot {
+    void *record;                   /*NULL for an empty slot*/
+    uint32_t hash;
+};
+
+static uint32_t opra_table_round_up(uint32_t n)
+{
+    uint32_t slots = 16;
+    while ((slots < n) && (slots < (UINT32_C(1) << 31)))
+        slots <<= 1;
+    return slots;
+}
+
+bool opra_table_init(opra_table *table, size_t key_size, uint32_t initial_slots)
+{
+    const uint32_t slots = opra_table_round_up(initial_slots);
+    table->slots = (opra_table_slot *) calloc(slots, sizeof(opra_table_slot));
+    table->mask = (NULL != table->slots) ? slots - 1 : 0;
+    table->count = 0;
+    table->key_size = key_size;
+    return NULL != table->slots;
+}
+
+void opra_table_free(opra_table *table)
+{
+    free(table->slots);
+    table->slots = NULL;
+    table->mask = 0;
+    table->count = 0;
+}
+
+uint32_t opra_table_hash(const void *key, size_t key_size)
+{
+    const uint8_t *p = (const uint8_t *) key;
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < key_size; i++)
+        hash = (hash ^ p[i]) * 16777619U;
+    return hash;
+}
+
+static inline bool opra_table_slot_matches(const opra_table *table, const opra_table_slot *slot, const void *key, uint32_t hash)
+{
+    return (slot->hash == hash) && (0 == memcmp(slot->record, key, table->key_size));
+}
+
+void *opra_table_find(const opra_table *table, const void *key, uint32_t hash)
+{
+    if (NULL == table->slots)
+        return NULL;
+
+    for (uint32_t i = hash & table->mask; NULL != table->slots[i].record; i = (i + 1) & table->mask){
+        if (opra_table_slot_matches(table, &table->slots[i], key, hash))
+            return table->slots[i].record;
+    }
+    return NULL;
+}
+
+static void opra_table_place(opra_table_slot *slots, uint32_t mask, void *record, uint32_t hash)
+{
+    uint32_t i = hash & mask;
+    while (NULL != slots[i].record)
+        i = (i + 1) & mask;
+    slots[i].record = record;
+    slots[i].hash = hash;
+}
+
+static bool opra_table_grow(opra_table *table)
+{
+    const uint32_t slots = (table->mask + 1) * 2;
+    if (0 == slots)
+        return false;
+    opra_table_slot *grown = (opra_table_slot *) calloc(slots, sizeof(opra_table_slot));
+    if (NULL == grown)
+        return false;
+
+    for (uint32_t i = 0; i <= table->mask; i++){
+        if (NULL != table->slots[i].record)
+            opra_table_place(grown, slots - 1, table->slots[i].record, table->slots[i].hash);
+    }
+    free(table->slots);
+    table->slots = grown;
+    table->mask = slots - 1;
+    return true;
+}
+
+bool opra_table_insert(opra_table *table, void *record, uint32_t hash)
+{
+    if (NULL == table->slots)
+        return false;
+    if ((table->count + 1) > (table->mask + 1) / 4 * 3){
+        if (!opra_table_grow(table))
+            return false;
+    }
+    opra_table_place(table->slots, table->mask, record, hash);
+    table->count++;
+    return true;
+}
+
+void *opra_table_remove(opra_table *table, const void *key, uint32_t hash)
+{
+    if (NULL == table->slots)
+        return NULL;
+
+    /*an empty slot ends the probe run before its key is looked at, as in opra_table_find()*/
+    uint32_t i = hash & table->mask;
+    for (;;){
+        if (NULL == table->slots[i].record)
+            return NULL;
+        if (opra_table_slot_matches(table, &table->slots[i], key, hash))
+            break;
+        i = (i + 1) & table->mask;
+    }
+    void *record = table->slots[i].record;
+
+    /*Move later records of the probe run back into the hole, unless that would put one before its home slot*/
+    uint32_t hole = i;
+    for (uint32_t j = (i + 1) & table->mask; NULL != table->slots[j].record; j = (j + 1) & table->mask){
+        const uint32_t home = table->slots[j].hash & table->mask;
+        /*j's record may fill the hole if its home isn't in the cyclic range (hole, j]*/
+        if (((j - home) & table->mask) >= ((j - hole) & table->mask)){
+            table->slots[hole] = table->slots[j];
+            hole = j;
+        }
+    }
+    table->slots[hole].record = NULL;
+    table->slots[hole].hash = 0;
+    table->count--;
+    return record;
+}
+
+void opra_table_foreach(const opra_table *table, void (*func)(void *record, void *user_data), void *user_data)
+{
+    if (NULL == table->slots)
+        return;
+
+    for (uint32_t i = 0; i <= table->mask; i++){
+        if (NULL != table->slots[i].record)
+            func(table->slots[i].record, user_data);
+    }
+}
+
+size_t opra_table_bytes(const opra_table *table)
+{
+    return (NULL != table->slots) ? ((size_t) table->mask + 1) * sizeof(opra_table_slot) : 0;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
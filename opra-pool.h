@@ -0,0 +1,167 @@
+/* opra-pool.h
+ *
+ * Bounded memory building blocks for the per capture state of the OPRA dissector: an arena, a pool of fixed size
+ * objects over it, an open addressed hash table and an LRU list.  No epan dependency.  Everything comes from malloc
+ * and is given back at once when the capture is closed, and each keeps count of the bytes it holds so the
+ * dissector can report and cap its memory use.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_POOL_H__
+#define __OPRA_POOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*bytes the arena takes from malloc at a time, larger requests get a chunk of their own*/
+#define OPRA_ARENA_CHUNK_SIZE (1024 * 1024)
+
+typedef struct _opra_arena_chunk opra_arena_chunk;
+
+/*Bump allocation from large chunks, none of it freed before opra_arena_free_all()*/
+typedef struct _opra_arena {
+    opra_arena_chunk *chunks;       /*newest first, allocations come from the newest*/
+    size_t used;                    /*bytes handed out*/
+    size_t reserved;                /*bytes taken from malloc*/
+} opra_arena;
+
+void opra_arena_init(opra_arena *arena);
+
+/*size bytes, 8 byte aligned and zero filled.  NULL if malloc fails.*/
+void *opra_arena_alloc(opra_arena *arena, size_t size);
+
+void opra_arena_free_all(opra_arena *arena);
+
+/*Objects of one size carved from an arena.  Freed objects go on a free list and are handed out again first,
+  so a pool whose objects come and go doesn't grow past its high water mark.*/
+typedef struct _opra_pool {
+    opra_arena *arena;
+    size_t object_size;
+    void *free_list;
+    size_t in_use;                  /*objects handed out and not freed*/
+    size_t free_count;              /*objects on the free list*/
+} opra_pool;
+
+void opra_pool_init(opra_pool *pool, opra_arena *arena, size_t object_size);
+
+/*an object of the pool's size, zero filled.  NULL if the arena can't grow.*/
+void *opra_pool_alloc(opra_pool *pool);
+void opra_pool_free(opra_pool *pool, void *object);
+
+/*bytes of the objects handed out and on the free list*/
+static inline size_t opra_pool_bytes(const opra_pool *pool)
+{
+    return (pool->in_use + pool->free_count) * pool->object_size;
+}
+
+typedef struct _opra_table_slot opra_table_slot;
+
+/*Open addressed hash table of records whose first key_size bytes are their key, compared as bytes, so keys must
+  be zero filled.  Linear probing, removal shifts the probe run back instead of leaving tombstones.  Each slot keeps
+  the record's hash, so a probe only reads a record whose hash matches.  The table doubles at 3/4 full.*/
+typedef struct _opra_table {
+    opra_table_slot *slots;
+    uint32_t mask;                  /*slots - 1, the slot count is a power of two*/
+    uint32_t count;
+    size_t key_size;
+} opra_table;
+
+/*initial_slots is rounded up to a power of two.  Returns false if the slots can't be allocated.*/
+bool opra_table_init(opra_table *table, size_t key_size, uint32_t initial_slots);
+void opra_table_free(opra_table *table);
+
+/*FNV-1a over the key bytes, the hash the table expects*/
+uint32_t opra_table_hash(const void *key, size_t key_size);
+
+void *opra_table_find(const opra_table *table, const void *key, uint32_t hash);
+
+/*Add a record whose key isn't in the table yet.  Returns false if the table had to grow and couldn't.*/
+bool opra_table_insert(opra_table *table, void *record, uint32_t hash);
+
+/*Take the record with this key out of the table, returning it or NULL if there was none*/
+void *opra_table_remove(opra_table *table, const void *key, uint32_t hash);
+
+/*every record, in no particular order.  The table mustn't change during the walk.*/
+void opra_table_foreach(const opra_table *table, void (*func)(void *record, void *user_data), void *user_data);
+
+size_t opra_table_bytes(const opra_table *table);
+
+/*Intrusive least recently used list.  The link goes in the records, the list is circular around a sentinel
+  with the most recently used record next to it.*/
+typedef struct _opra_lru_link {
+    struct _opra_lru_link *prev;
+    struct _opra_lru_link *next;
+} opra_lru_link;
+
+typedef struct _opra_lru {
+    opra_lru_link sentinel;
+} opra_lru;
+
+static inline void opra_lru_init(opra_lru *lru)
+{
+    lru->sentinel.prev = &lru->sentinel;
+    lru->sentinel.next = &lru->sentinel;
+}
+
+/*links start zero filled, which means not in any list*/
+static inline bool opra_lru_linked(const opra_lru_link *link)
+{
+    return NULL != link->next;
+}
+
+static inline void opra_lru_remove(opra_lru_link *link)
+{
+    if (!opra_lru_linked(link))
+        return;
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+    link->prev = NULL;
+    link->next = NULL;
+}
+
+/*make link the most recently used, adding it if it wasn't in the list*/
+static inline void opra_lru_touch(opra_lru *lru, opra_lru_link *link)
+{
+    if (lru->sentinel.next == link)
+        return;
+    opra_lru_remove(link);
+    link->prev = &lru->sentinel;
+    link->next = lru->sentinel.next;
+    lru->sentinel.next->prev = link;
+    lru->sentinel.next = link;
+}
+
+/*the least recently used link, NULL if the list is empty*/
+static inline opra_lru_link *opra_lru_oldest(const opra_lru *lru)
+{
+    return (lru->sentinel.prev == &lru->sentinel) ? NULL : lru->sentinel.prev;
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_POOL_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,123 @@
+/* opra-price.c
+ *
+ * Fixed point price handling for the OPRA decode core, see opra-price.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <string.h>
+
+#include "opra-price.h"
+
+const uint32_t opra_price_powers_of_ten[OPRA_PRICE_MAX_DECIMAL_PLACES + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+const uint8_t opra_price_denominator_table[256] = {
+    ['A'] = 1 + 1,
+    ['B'] = 2 + 1,
+    ['C'] = 3 + 1,
+    ['D'] = 4 + 1,
+    ['E'] = 5 + 1,
+    ['F'] = 6 + 1,
+    ['G'] = 7 + 1,
+    ['H'] = 8 + 1,
+    ['I'] = 0 + 1,
+};
+
+/*two digits at a time, so the formatter does half the divisions*/
+static const char opra_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/*write value backwards ending just before end, zero padded to at least width digits*/
+static char *opra_format_digits_reverse(char *end, uint32_t value, int width)
+{
+    char *p = end;
+
+    while (value >= 100){
+        const unsigned i = (value % 100) * 2;
+        value /= 100;
+        *--p = opra_digit_pairs[i + 1];
+        *--p = opra_digit_pairs[i];
+    }
+    if (value >= 10){
+        *--p = opra_digit_pairs[value * 2 + 1];
+        *--p = opra_digit_pairs[value * 2];
+    } else {
+        *--p = (char) ('0' + value);
+    }
+
+    while (end - p < width)
+        *--p = '0';
+
+    return p;
+}
+
+char *opra_format_uint32(char *buf, uint32_t value)
+{
+    char tmp[10];
+    const char *start = opra_format_digits_reverse(tmp + sizeof(tmp), value, 1);
+    const size_t len = (size_t) (tmp + sizeof(tmp) - start);
+
+    memcpy(buf, start, len);
+    return buf + len;
+}
+
+size_t opra_price_format(char *buf, size_t size, uint32_t value, uint8_t denominator_code)
+{
+    if (0 == size)
+        return 0;
+    buf[0] = '\0';
+
+    const int decimal_places = opra_price_decimal_places(denominator_code);
+    if (decimal_places < 0)
+        return 0;
+
+    /*build the price backwards from the end of a scratch buffer, fraction first*/
+    char tmp[OPRA_PRICE_BUFFER_SIZE];
+    char *end = tmp + sizeof(tmp);
+    char *p;
+
+    if (0 == decimal_places){
+        p = opra_format_digits_reverse(end, value, 1);
+    } else {
+        const uint32_t divisor = opra_price_powers_of_ten[decimal_places];
+        p = opra_format_digits_reverse(end, value % divisor, decimal_places);
+        *--p = '.';
+        p = opra_format_digits_reverse(p, value / divisor, 1);
+    }
+
+    const size_t len = (size_t) (end - p);
+    if (len >= size)
+        return 0;
+
+    memcpy(buf, p, len);
+    buf[len] = '\0';
+    return len;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,91 @@
+/* opra-price.h
+ *
+ * Fixed point price handling for the OPRA decode core.
+ * No epan dependency.  Nothing here allocates or keeps state, output goes to caller owned buffers.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_PRICE_H__
+#define __OPRA_PRICE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*The spec's denominator codes 'A' to 'H' give 1 to 8 decimal places, 'I' is a whole number*/
+#define OPRA_PRICE_MAX_DECIMAL_PLACES 8
+
+/*longest formatted uint32_t price, "4294967295" with a decimal point inserted, plus the terminator*/
+#define OPRA_PRICE_BUFFER_SIZE 16
+
+/*10^n for n = 0 .. OPRA_PRICE_MAX_DECIMAL_PLACES*/
+extern const uint32_t opra_price_powers_of_ten[OPRA_PRICE_MAX_DECIMAL_PLACES + 1];
+
+/*decimal places + 1 for each denominator code, 0 for codes the spec doesn't define*/
+extern const uint8_t opra_price_denominator_table[256];
+
+/*number of decimal places for a denominator code, or -1 if the code isn't valid*/
+static inline int opra_price_decimal_places(uint8_t denominator_code)
+{
+    return (int) opra_price_denominator_table[denominator_code] - 1;
+}
+
+/*Prices normalized to OPRA_PRICE_MAX_DECIMAL_PLACES, so prices with different denominator codes can be
+  compared as plain integers.  A uint32_t scaled by at most 10^8 always fits.  Returns false if the code isn't valid.*/
+static inline bool opra_price_scaled(uint32_t value, uint8_t denominator_code, int64_t *scaled)
+{
+    const int dps = opra_price_decimal_places(denominator_code);
+    if (dps < 0)
+        return false;
+
+    *scaled = (int64_t) value * opra_price_powers_of_ten[OPRA_PRICE_MAX_DECIMAL_PLACES - dps];
+    return true;
+}
+
+/*Prices as a double.  Returns false if the code isn't valid.*/
+static inline bool opra_price_to_double(uint32_t value, uint8_t denominator_code, double *price)
+{
+    const int dps = opra_price_decimal_places(denominator_code);
+    if (dps < 0)
+        return false;
+
+    *price = (double) value / opra_price_powers_of_ten[dps];
+    return true;
+}
+
+/*Write the decimal digits of value at buf, without a terminator.  buf must have room for 10 characters.
+  Returns a pointer just past the last digit.*/
+char *opra_format_uint32(char *buf, uint32_t value);
+
+/*Format value with the implied decimal places of denominator_code, e.g. 1234 with 'B' gives "12.34".
+  The result is always terminated if size > 0.  Returns the length written, or 0 if the code isn't valid
+  or the buffer is too small.*/
+size_t opra_price_format(char *buf, size_t size, uint32_t value, uint8_t denominator_code);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_PRICE_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,612 @@
+/* opra-summary.c
+ *
+ * Mergeable summary of an OPRA capture, see opra-summary.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "opra-summary.h"
+#include "opra-price.h"
+
+#define OPRA_SUMMARY_INITIAL_SLOTS 1024
+
+/*record sizes in the file*/
+#define OPRA_SUMMARY_HEADER_SIZE 64
+#define OPRA_SUMMARY_CATEGORIES_SIZE (256 * 8)
+#define OPRA_SUMMARY_LINE_SIZE 56
+#define OPRA_SUMMARY_RANGE_SIZE 12
+#define OPRA_SUMMARY_INSTRUMENT_SIZE 80
+
+bool opra_summary_init(opra_summary *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+    opra_arena_init(&summary->arena);
+    const bool lines = opra_table_init(&summary->lines, sizeof(opra_summary_line_key), OPRA_SUMMARY_INITIAL_SLOTS);
+    const bool instruments = opra_table_init(&summary->instruments, sizeof(opra_instrument_key), OPRA_SUMMARY_INITIAL_SLOTS);
+    return lines && instruments;
+}
+
+static void opra_summary_free_line(void *record, void *user_data)
+{
+    (void) user_data;
+    free(((opra_summary_line *) record)->ranges);
+}
+
+void opra_summary_free(opra_summary *summary)
+{
+    opra_table_foreach(&summary->lines, opra_summary_free_line, NULL);
+    opra_table_free(&summary->lines);
+    opra_table_free(&summary->instruments);
+    opra_arena_free_all(&summary->arena);
+}
+
+/*the record with key, added zero filled if it isn't in the table yet*/
+static void *opra_summary_intern(opra_summary *summary, opra_table *table, const void *key, size_t record_size)
+{
+    const uint32_t hash = opra_table_hash(key, table->key_size);
+    void *record = opra_table_find(table, key, hash);
+    if (NULL != record)
+        return record;
+
+    record = opra_arena_alloc(&summary->arena, record_size);
+    if (NULL == record)
+        return NULL;
+    memcpy(record, key, table->key_size);
+    if (!opra_table_insert(table, record, hash))
+        return NULL;
+    return record;
+}
+
+static bool opra_summary_range_before(const opra_summary_range *a, const opra_summary_range *b)
+{
+    return (a->epoch < b->epoch) || ((a->epoch == b->epoch) && (a->first < b->first));
+}
+
+/*the ranges meet or overlap, a starting no later than b*/
+static bool opra_summary_range_joins(const opra_summary_range *a, const opra_summary_range *b)
+{
+    return (a->epoch == b->epoch) && ((a->last >= b->first) || (a->last + 1 == b->first));
+}
+
+/*Add sequence numbers to a line's ranges.  Blocks mostly come in order, so the common case extends the last range.*/
+static bool opra_summary_add_range(opra_summary_line *line, const opra_summary_range *range)
+{
+    if (0 != line->range_count){
+        opra_summary_range *last = &line->ranges[line->range_count - 1];
+        if (!opra_summary_range_before(range, last) && opra_summary_range_joins(last, range)){
+            if (range->last > last->last)
+                last->last = range->last;
+            return true;
+        }
+    }
+
+    /*the first range that starts after this one*/
+    uint32_t low = 0;
+    uint32_t high = line->range_count;
+    while (low < high){
+        const uint32_t mid = low + (high - low) / 2;
+        if (opra_summary_range_before(range, &line->ranges[mid]))
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    /*join the one before, or insert a new range*/
+    uint32_t at;
+    if ((low > 0) && opra_summary_range_joins(&line->ranges[low - 1], range)){
+        at = low - 1;
+        if (range->last > line->ranges[at].last)
+            line->ranges[at].last = range->last;
+    } else {
+        if (line->range_count == line->range_capacity){
+            const uint32_t capacity = (0 == line->range_capacity) ? 4 : line->range_capacity * 2;
+            opra_summary_range *ranges = (opra_summary_range *) realloc(line->ranges, capacity * sizeof(opra_summary_range));
+            if (NULL == ranges)
+                return false;
+            line->ranges = ranges;
+            line->range_capacity = capacity;
+        }
+        memmove(&line->ranges[low + 1], &line->ranges[low], (line->range_count - low) * sizeof(opra_summary_range));
+        line->ranges[low] = *range;
+        line->range_count++;
+        at = low;
+    }
+
+    /*then swallow the ones after that it now reaches*/
+    uint32_t next = at + 1;
+    while ((next < line->range_count) && opra_summary_range_joins(&line->ranges[at], &line->ranges[next])){
+        if (line->ranges[next].last > line->ranges[at].last)
+            line->ranges[at].last = line->ranges[next].last;
+        next++;
+    }
+    if (next > at + 1){
+        memmove(&line->ranges[at + 1], &line->ranges[next], (line->range_count - next) * sizeof(opra_summary_range));
+        line->range_count -= next - (at + 1);
+    }
+    return true;
+}
+
+bool opra_summary_add_block(opra_summary *summary, const opra_summary_line_key *key, const opra_block *block, bool reset)
+{
+    summary->blocks++;
+
+    /*message headers only, as opra_block_has_message() walks them*/
+    opra_message_iter iter;
+    opra_message_iter_init(&iter, block);
+    uint8_t message_category;
+    while (opra_message_iter_peek_category(&iter, &message_category)){
+        opra_decode_status status = opra_message_iter_skip(&iter);
+        if (OPRA_DECODE_UNKNOWN_CATEGORY == status){
+            int message_len;
+            status = opra_message_iter_resync(&iter, &message_len);
+        }
+        if (OPRA_DECODE_OK != status)
+            break;
+        summary->messages++;
+        summary->category_counts[message_category]++;
+    }
+
+    opra_summary_line *line = (opra_summary_line *) opra_summary_intern(summary, &summary->lines, key, sizeof(opra_summary_line));
+    if (NULL == line)
+        return false;
+
+    const opra_block_header *hdr = &block->hdr;
+    bool added = true;
+    if ('V' == hdr->retransmission_indicator){
+        line->retransmitted_blocks++;
+    } else {
+        line->blocks++;
+        line->messages += hdr->messages_in_block;
+        if (0 != hdr->messages_in_block){
+            opra_summary_range range;
+            range.epoch = line->resets;
+            range.first = hdr->block_sequence_number;
+            /*a block running past the largest sequence number is cut short rather than wrapped*/
+            range.last = (hdr->block_sequence_number > UINT32_MAX - (hdr->messages_in_block - 1U)) ? UINT32_MAX :
+                hdr->block_sequence_number + (hdr->messages_in_block - 1U);
+            added = opra_summary_add_range(line, &range);
+        }
+    }
+    if (reset)
+        line->resets++;
+    return added;
+}
+
+bool opra_summary_add_message(opra_summary *summary, const opra_message *msg)
+{
+    const uint8_t message_category = msg->hdr.message_category;
+    if (('a' != message_category) && ('k' != message_category) && ('q' != message_category))
+        return true;
+
+    opra_instrument_key key;
+    if (!opra_message_instrument(msg, &key))
+        return true;
+    opra_summary_instrument *instrument = (opra_summary_instrument *) opra_summary_intern(summary, &summary->instruments, &key,
+        sizeof(opra_summary_instrument));
+    if (NULL == instrument)
+        return false;
+
+    if ('a' == message_category){
+        int64_t price;
+        instrument->sales++;
+        instrument->volume += msg->body.a.volume;
+        if (opra_price_scaled(msg->body.a.premium_price, msg->body.a.premium_price_denominator_code, &price)){
+            instrument->has_last_sale = true;
+            instrument->last_sale_price = price;
+            instrument->last_sale_volume = msg->body.a.volume;
+        }
+        return true;
+    }
+
+    /*sides the piece never wrote are left as the pieces before it had them*/
+    unsigned written;
+    instrument->quotes++;
+    (void) opra_book_apply(&instrument->top, msg, &written);
+    instrument->sides |= written;
+    return true;
+}
+
+typedef struct _opra_summary_merge_state {
+    opra_summary *dst;
+    bool ok;
+} opra_summary_merge_state;
+
+static void opra_summary_merge_line(void *record, void *user_data)
+{
+    const opra_summary_line *src = (const opra_summary_line *) record;
+    opra_summary_merge_state *state = (opra_summary_merge_state *) user_data;
+    opra_summary_line *dst = (opra_summary_line *) opra_summary_intern(state->dst, &state->dst->lines, &src->key, sizeof(opra_summary_line));
+    if (NULL == dst){
+        state->ok = false;
+        return;
+    }
+
+    /*src's epochs carry on from dst's current one*/
+    for (uint32_t i = 0; i < src->range_count; i++){
+        opra_summary_range range = src->ranges[i];
+        range.epoch += dst->resets;
+        if (!opra_summary_add_range(dst, &range))
+            state->ok = false;
+    }
+    dst->resets += src->resets;
+    dst->blocks += src->blocks;
+    dst->messages += src->messages;
+    dst->retransmitted_blocks += src->retransmitted_blocks;
+}
+
+static void opra_summary_merge_instrument(void *record, void *user_data)
+{
+    const opra_summary_instrument *src = (const opra_summary_instrument *) record;
+    opra_summary_merge_state *state = (opra_summary_merge_state *) user_data;
+    opra_summary_instrument *dst = (opra_summary_instrument *) opra_summary_intern(state->dst, &state->dst->instruments, &src->key,
+        sizeof(opra_summary_instrument));
+    if (NULL == dst){
+        state->ok = false;
+        return;
+    }
+
+    if (src->sides & OPRA_BOOK_BID)
+        dst->top.bid = src->top.bid;
+    if (src->sides & OPRA_BOOK_OFFER)
+        dst->top.offer = src->top.offer;
+    dst->sides |= src->sides;
+    if (src->has_last_sale){
+        dst->has_last_sale = true;
+        dst->last_sale_price = src->last_sale_price;
+        dst->last_sale_volume = src->last_sale_volume;
+    }
+    dst->quotes += src->quotes;
+    dst->sales += src->sales;
+    dst->volume += src->volume;
+}
+
+bool opra_summary_merge(opra_summary *dst, const opra_summary *src)
+{
+    opra_summary_merge_state state = { dst, true };
+    opra_table_foreach(&src->lines, opra_summary_merge_line, &state);
+    opra_table_foreach(&src->instruments, opra_summary_merge_instrument, &state);
+
+    dst->blocks += src->blocks;
+    dst->messages += src->messages;
+    for (unsigned i = 0; i < 256; i++)
+        dst->category_counts[i] += src->category_counts[i];
+    return state.ok;
+}
+
+uint64_t opra_summary_line_gaps(const opra_summary_line *line, void (*func)(const opra_summary_range *gap, void *user_data),
+    void *user_data)
+{
+    uint64_t missing = 0;
+    for (uint32_t i = 1; i < line->range_count; i++){
+        const opra_summary_range *before = &line->ranges[i - 1];
+        const opra_summary_range *after = &line->ranges[i];
+        if (before->epoch != after->epoch)
+            continue;
+
+        opra_summary_range gap = { after->epoch, before->last + 1, after->first - 1 };
+        missing += (uint64_t) gap.last - gap.first + 1;
+        if (NULL != func)
+            func(&gap, user_data);
+    }
+    return missing;
+}
+
+uint64_t opra_summary_line_covered(const opra_summary_line *line)
+{
+    uint64_t covered = 0;
+    for (uint32_t i = 0; i < line->range_count; i++)
+        covered += (uint64_t) line->ranges[i].last - line->ranges[i].first + 1;
+    return covered;
+}
+
+static inline uint8_t *opra_summary_put_uint16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    return p + 2;
+}
+
+static inline uint8_t *opra_summary_put_uint32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) (value >> 16);
+    p[3] = (uint8_t) (value >> 24);
+    return p + 4;
+}
+
+static inline uint8_t *opra_summary_put_uint64(uint8_t *p, uint64_t value)
+{
+    p = opra_summary_put_uint32(p, (uint32_t) value);
+    return opra_summary_put_uint32(p, (uint32_t) (value >> 32));
+}
+
+static inline uint8_t *opra_summary_put_bytes(uint8_t *p, const uint8_t *bytes, size_t length)
+{
+    memcpy(p, bytes, length);
+    return p + length;
+}
+
+typedef struct _opra_summary_records {
+    const void **records;
+    uint32_t count;
+    uint32_t range_count;
+} opra_summary_records;
+
+static void opra_summary_collect(void *record, void *user_data)
+{
+    opra_summary_records *records = (opra_summary_records *) user_data;
+    records->records[records->count++] = record;
+}
+
+static void opra_summary_collect_line(void *record, void *user_data)
+{
+    opra_summary_collect(record, user_data);
+    ((opra_summary_records *) user_data)->range_count += ((const opra_summary_line *) record)->range_count;
+}
+
+static int opra_summary_line_order(const void *a, const void *b)
+{
+    const opra_summary_line *la = *(const opra_summary_line * const *) a;
+    const opra_summary_line *lb = *(const opra_summary_line * const *) b;
+    int order = memcmp(la->key.src, lb->key.src, OPRA_SUMMARY_MAX_ADDRESS_SIZE);
+    if (0 == order)
+        order = (int) la->key.address_length - (int) lb->key.address_length;
+    if (0 == order)
+        order = (int) la->key.dst_port - (int) lb->key.dst_port;
+    if (0 == order)
+        order = (int) la->key.session_indicator - (int) lb->key.session_indicator;
+    return order;
+}
+
+static int opra_summary_instrument_order(const void *a, const void *b)
+{
+    const opra_summary_instrument *ia = *(const opra_summary_instrument * const *) a;
+    const opra_summary_instrument *ib = *(const opra_summary_instrument * const *) b;
+    int order = memcmp(ia->key.security_symbol, ib->key.security_symbol, OPRA_SECURITY_SYMBOL_SIZE);
+    if (0 == order)
+        order = memcmp(ia->key.expiration_block, ib->key.expiration_block, OPRA_EXPIRATION_BLOCK_SIZE);
+    if (0 == order)
+        order = (ia->key.strike_price > ib->key.strike_price) - (ia->key.strike_price < ib->key.strike_price);
+    return order;
+}
+
+static uint8_t *opra_summary_put_side(uint8_t *p, const opra_book_side *side)
+{
+    p = opra_summary_put_uint64(p, (uint64_t) side->price);
+    p = opra_summary_put_uint32(p, side->size);
+    *p++ = side->participant_id;
+    return p;
+}
+
+uint8_t *opra_summary_write(const opra_summary *summary, size_t *length)
+{
+    opra_summary_records lines = { NULL, 0, 0 };
+    opra_summary_records instruments = { NULL, 0, 0 };
+    lines.records = (const void **) malloc(((size_t) summary->lines.count + 1) * sizeof(void *));
+    instruments.records = (const void **) malloc(((size_t) summary->instruments.count + 1) * sizeof(void *));
+    if ((NULL == lines.records) || (NULL == instruments.records)){
+        free(lines.records);
+        free(instruments.records);
+        return NULL;
+    }
+    opra_table_foreach(&summary->lines, opra_summary_collect_line, &lines);
+    opra_table_foreach(&summary->instruments, opra_summary_collect, &instruments);
+    qsort(lines.records, lines.count, sizeof(void *), opra_summary_line_order);
+    qsort(instruments.records, instruments.count, sizeof(void *), opra_summary_instrument_order);
+
+    const size_t size = OPRA_SUMMARY_HEADER_SIZE + OPRA_SUMMARY_CATEGORIES_SIZE + (size_t) lines.count * OPRA_SUMMARY_LINE_SIZE +
+        (size_t) lines.range_count * OPRA_SUMMARY_RANGE_SIZE + (size_t) instruments.count * OPRA_SUMMARY_INSTRUMENT_SIZE;
+    uint8_t *buf = (uint8_t *) calloc(1, size);
+    if (NULL == buf){
+        free(lines.records);
+        free(instruments.records);
+        return NULL;
+    }
+
+    uint8_t *p = buf;
+    p = opra_summary_put_bytes(p, (const uint8_t *) OPRA_SUMMARY_MAGIC, OPRA_SUMMARY_MAGIC_SIZE);
+    p = opra_summary_put_uint32(p, OPRA_SUMMARY_VERSION);
+    p = opra_summary_put_uint32(p, lines.count);
+    p = opra_summary_put_uint32(p, lines.range_count);
+    p = opra_summary_put_uint32(p, instruments.count);
+    p = opra_summary_put_uint64(p, summary->blocks);
+    p = opra_summary_put_uint64(p, summary->messages);
+    p = buf + OPRA_SUMMARY_HEADER_SIZE;
+    for (unsigned i = 0; i < 256; i++)
+        p = opra_summary_put_uint64(p, summary->category_counts[i]);
+
+    for (uint32_t i = 0; i < lines.count; i++){
+        const opra_summary_line *line = (const opra_summary_line *) lines.records[i];
+        uint8_t *record = p;
+        p = opra_summary_put_bytes(p, line->key.src, OPRA_SUMMARY_MAX_ADDRESS_SIZE);
+        *p++ = line->key.address_length;
+        *p++ = line->key.session_indicator;
+        p = opra_summary_put_uint16(p, line->key.dst_port);
+        p = opra_summary_put_uint32(p, line->resets);
+        p = opra_summary_put_uint64(p, line->blocks);
+        p = opra_summary_put_uint64(p, line->messages);
+        p = opra_summary_put_uint64(p, line->retransmitted_blocks);
+        p = opra_summary_put_uint32(p, line->range_count);
+        p = record + OPRA_SUMMARY_LINE_SIZE;
+        for (uint32_t r = 0; r < line->range_count; r++){
+            p = opra_summary_put_uint32(p, line->ranges[r].epoch);
+            p = opra_summary_put_uint32(p, line->ranges[r].first);
+            p = opra_summary_put_uint32(p, line->ranges[r].last);
+        }
+    }
+
+    for (uint32_t i = 0; i < instruments.count; i++){
+        const opra_summary_instrument *instrument = (const opra_summary_instrument *) instruments.records[i];
+        uint8_t *record = p;
+        p = opra_summary_put_bytes(p, instrument->key.security_symbol, OPRA_SECURITY_SYMBOL_SIZE);
+        p = opra_summary_put_bytes(p, instrument->key.expiration_block, OPRA_EXPIRATION_BLOCK_SIZE);
+        p = opra_summary_put_uint64(p, (uint64_t) instrument->key.strike_price);
+        *p++ = (uint8_t) instrument->sides;
+        *p++ = instrument->has_last_sale ? 1 : 0;
+        p = opra_summary_put_side(p, &instrument->top.bid);
+        p = opra_summary_put_side(p, &instrument->top.offer);
+        p = opra_summary_put_uint64(p, (uint64_t) instrument->last_sale_price);
+        p = opra_summary_put_uint32(p, instrument->last_sale_volume);
+        p = opra_summary_put_uint64(p, instrument->quotes);
+        p = opra_summary_put_uint64(p, instrument->sales);
+        p = opra_summary_put_uint64(p, instrument->volume);
+        p = record + OPRA_SUMMARY_INSTRUMENT_SIZE;
+    }
+
+    free(lines.records);
+    free(instruments.records);
+    *length = size;
+    return buf;
+}
+
+/*reads little endian fields in order, going bad rather than past the end*/
+typedef struct _opra_summary_reader {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool ok;
+} opra_summary_reader;
+
+static const uint8_t *opra_summary_take(opra_summary_reader *reader, size_t length)
+{
+    static const uint8_t zeros[OPRA_SUMMARY_MAX_ADDRESS_SIZE];
+    if (!reader->ok || ((size_t) (reader->end - reader->p) < length)){
+        reader->ok = false;
+        return zeros;
+    }
+    const uint8_t *p = reader->p;
+    reader->p += length;
+    return p;
+}
+
+static uint8_t opra_summary_get_uint8(opra_summary_reader *reader)
+{
+    return *opra_summary_take(reader, 1);
+}
+
+static uint16_t opra_summary_get_uint16(opra_summary_reader *reader)
+{
+    const uint8_t *p = opra_summary_take(reader, 2);
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t opra_summary_get_uint32(opra_summary_reader *reader)
+{
+    const uint8_t *p = opra_summary_take(reader, 4);
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t opra_summary_get_uint64(opra_summary_reader *reader)
+{
+    const uint64_t low = opra_summary_get_uint32(reader);
+    return low | ((uint64_t) opra_summary_get_uint32(reader) << 32);
+}
+
+static void opra_summary_get_side(opra_summary_reader *reader, opra_book_side *side)
+{
+    side->price = (int64_t) opra_summary_get_uint64(reader);
+    side->size = opra_summary_get_uint32(reader);
+    side->participant_id = opra_summary_get_uint8(reader);
+}
+
+/*step to the end of a fixed size record*/
+static void opra_summary_skip_to(opra_summary_reader *reader, const uint8_t *record, size_t size)
+{
+    if (reader->ok && (reader->p <= record + size))
+        (void) opra_summary_take(reader, (size_t) (record + size - reader->p));
+}
+
+bool opra_summary_read(opra_summary *summary, const uint8_t *data, size_t length)
+{
+    opra_summary_reader reader = { data, data + length, true };
+    if ((length < OPRA_SUMMARY_HEADER_SIZE + OPRA_SUMMARY_CATEGORIES_SIZE) || (0 != memcmp(data, OPRA_SUMMARY_MAGIC, OPRA_SUMMARY_MAGIC_SIZE)))
+        return false;
+
+    (void) opra_summary_take(&reader, OPRA_SUMMARY_MAGIC_SIZE);
+    if (OPRA_SUMMARY_VERSION != opra_summary_get_uint32(&reader))
+        return false;
+    const uint32_t line_count = opra_summary_get_uint32(&reader);
+    (void) opra_summary_get_uint32(&reader);   /*range count, the lines say where theirs are*/
+    const uint32_t instrument_count = opra_summary_get_uint32(&reader);
+    summary->blocks = opra_summary_get_uint64(&reader);
+    summary->messages = opra_summary_get_uint64(&reader);
+    opra_summary_skip_to(&reader, data, OPRA_SUMMARY_HEADER_SIZE);
+    for (unsigned i = 0; i < 256; i++)
+        summary->category_counts[i] = opra_summary_get_uint64(&reader);
+
+    for (uint32_t i = 0; (i < line_count) && reader.ok; i++){
+        const uint8_t *record = reader.p;
+        opra_summary_line_key key;
+        memcpy(key.src, opra_summary_take(&reader, OPRA_SUMMARY_MAX_ADDRESS_SIZE), OPRA_SUMMARY_MAX_ADDRESS_SIZE);
+        key.address_length = opra_summary_get_uint8(&reader);
+        key.session_indicator = opra_summary_get_uint8(&reader);
+        key.dst_port = opra_summary_get_uint16(&reader);
+        if (!reader.ok)
+            break;
+
+        opra_summary_line *line = (opra_summary_line *) opra_summary_intern(summary, &summary->lines, &key, sizeof(opra_summary_line));
+        if (NULL == line)
+            return false;
+        line->resets = opra_summary_get_uint32(&reader);
+        line->blocks = opra_summary_get_uint64(&reader);
+        line->messages = opra_summary_get_uint64(&reader);
+        line->retransmitted_blocks = opra_summary_get_uint64(&reader);
+        const uint32_t range_count = opra_summary_get_uint32(&reader);
+        opra_summary_skip_to(&reader, record, OPRA_SUMMARY_LINE_SIZE);
+        for (uint32_t r = 0; (r < range_count) && reader.ok; r++){
+            opra_summary_range range;
+            range.epoch = opra_summary_get_uint32(&reader);
+            range.first = opra_summary_get_uint32(&reader);
+            range.last = opra_summary_get_uint32(&reader);
+            if (!reader.ok || (range.last < range.first) || !opra_summary_add_range(line, &range))
+                return false;
+        }
+    }
+
+    for (uint32_t i = 0; (i < instrument_count) && reader.ok; i++){
+        const uint8_t *record = reader.p;
+        opra_instrument_key key;
+        memcpy(key.security_symbol, opra_summary_take(&reader, OPRA_SECURITY_SYMBOL_SIZE), OPRA_SECURITY_SYMBOL_SIZE);
+        memcpy(key.expiration_block, opra_summary_take(&reader, OPRA_EXPIRATION_BLOCK_SIZE), OPRA_EXPIRATION_BLOCK_SIZE);
+        key.strike_price = (int64_t) opra_summary_get_uint64(&reader);
+        if (!reader.ok)
+            break;
+
+        opra_summary_instrument *instrument = (opra_summary_instrument *) opra_summary_intern(summary, &summary->instruments, &key,
+            sizeof(opra_summary_instrument));
+        if (NULL == instrument)
+            return false;
+        instrument->sides = opra_summary_get_uint8(&reader) & (OPRA_BOOK_BID | OPRA_BOOK_OFFER);
+        instrument->has_last_sale = (0 != opra_summary_get_uint8(&reader));
+        opra_summary_get_side(&reader, &instrument->top.bid);
+        opra_summary_get_side(&reader, &instrument->top.offer);
+        instrument->last_sale_price = (int64_t) opra_summary_get_uint64(&reader);
+        instrument->last_sale_volume = opra_summary_get_uint32(&reader);
+        instrument->quotes = opra_summary_get_uint64(&reader);
+        instrument->sales = opra_summary_get_uint64(&reader);
+        instrument->volume = opra_summary_get_uint64(&reader);
+        opra_summary_skip_to(&reader, record, OPRA_SUMMARY_INSTRUMENT_SIZE);
+    }
+
+    return reader.ok && (reader.p == reader.end);
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
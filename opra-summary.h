@@ -0,0 +1,142 @@
+/* opra-summary.h
+ *
+ * Mergeable summary of an OPRA capture, for pipelines that split a capture by time or by line and dissect the
+ * pieces in separate processes.  The first pass over each piece builds a summary, and the pieces' summaries merged
+ * in capture order are exactly the summary of a first pass over the whole capture.  Nothing in a summary depends on
+ * where its piece started: each line keeps the set of message sequence numbers its blocks carried rather than which
+ * block showed a gap, sequence number resets start epochs numbered on from the previous piece's, counters add up,
+ * and each instrument keeps the sides of its top of book that its quotes last wrote.
+ * No epan dependency, memory comes from malloc.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_SUMMARY_H__
+#define __OPRA_SUMMARY_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opra-decode.h"
+#include "opra-book.h"
+#include "opra-pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*File layout, every field little endian:
+    header
+    lines sorted by key, each followed by its ranges
+    instruments sorted by key
+  Records are written in key order so a merged summary and a serial one are the same bytes.*/
+#define OPRA_SUMMARY_MAGIC "OPRASUM1"
+#define OPRA_SUMMARY_MAGIC_SIZE 8
+#define OPRA_SUMMARY_VERSION 1
+
+/*source address lengths a line key can hold*/
+#define OPRA_SUMMARY_MAX_ADDRESS_SIZE 16
+
+/*A line as the dissector tracks it: source address, destination port and session indicator.
+  Zero filled, so it can be hashed and compared as bytes.*/
+typedef struct _opra_summary_line_key {
+    uint8_t src[OPRA_SUMMARY_MAX_ADDRESS_SIZE];
+    uint8_t address_length;
+    uint8_t session_indicator;
+    uint16_t dst_port;
+} opra_summary_line_key;
+
+/*Message sequence numbers first to last, inclusive, of one epoch.  A line's first epoch is 0 and each
+  Reset Block Sequence Number starts the next.*/
+typedef struct _opra_summary_range {
+    uint32_t epoch;
+    uint32_t first;
+    uint32_t last;
+} opra_summary_range;
+
+typedef struct _opra_summary_line {
+    opra_summary_line_key key;          /*first, opra_table takes a record's key from its start*/
+    uint32_t resets;                    /*sequence number resets, also the epoch of the line's next block*/
+    uint64_t blocks;                    /*blocks other than retransmissions*/
+    uint64_t messages;                  /*in those blocks, so sequence numbers carried twice count twice*/
+    uint64_t retransmitted_blocks;
+    opra_summary_range *ranges;         /*sequence numbers those blocks carried, in order, none overlapping or adjacent*/
+    uint32_t range_count;
+    uint32_t range_capacity;
+} opra_summary_line;
+
+typedef struct _opra_summary_instrument {
+    opra_instrument_key key;            /*first, opra_table takes a record's key from its start*/
+    unsigned sides;                     /*OPRA_BOOK_BID and OPRA_BOOK_OFFER for the sides of top some quote wrote*/
+    opra_book_top top;
+    bool has_last_sale;
+    int64_t last_sale_price;            /*scaled to 8 decimal places*/
+    uint32_t last_sale_volume;
+    uint64_t quotes;
+    uint64_t sales;
+    uint64_t volume;
+} opra_summary_instrument;
+
+typedef struct _opra_summary {
+    opra_arena arena;                   /*lines and instruments, their range lists are malloc'd*/
+    opra_table lines;
+    opra_table instruments;
+    uint64_t blocks;                    /*every block, retransmissions too*/
+    uint64_t messages;                  /*every message walked in those blocks*/
+    uint64_t category_counts[256];      /*messages by category byte*/
+} opra_summary;
+
+/*Returns false if the tables can't be allocated*/
+bool opra_summary_init(opra_summary *summary);
+void opra_summary_free(opra_summary *summary);
+
+/*Every block, in capture order.  reset is true for a block holding a Reset Block Sequence Number control message,
+  the blocks after it are numbered in the next epoch.  Returns false if memory runs out.*/
+bool opra_summary_add_block(opra_summary *summary, const opra_summary_line_key *key, const opra_block *block, bool reset);
+
+/*Every message that moves an instrument, in capture order: the quotes and last sales of blocks that aren't
+  retransmissions or the losing copy of an A/B pair.  Other messages are ignored.*/
+bool opra_summary_add_message(opra_summary *summary, const opra_message *msg);
+
+/*Fold in src, the summary of the piece that follows dst's in the capture.  Pieces split by line rather than by
+  time may be merged in any order, as a series is only sent on one line.  Returns false if memory runs out.*/
+bool opra_summary_merge(opra_summary *dst, const opra_summary *src);
+
+/*Sequence numbers missing between the ranges of each epoch of the line, passed to func if not NULL.
+  Returns how many are missing.*/
+uint64_t opra_summary_line_gaps(const opra_summary_line *line, void (*func)(const opra_summary_range *gap, void *user_data),
+    void *user_data);
+
+/*sequence numbers the line's blocks carried, each counted once*/
+uint64_t opra_summary_line_covered(const opra_summary_line *line);
+
+/*Write the summary into a malloc'd buffer, NULL if memory runs out*/
+uint8_t *opra_summary_write(const opra_summary *summary, size_t *length);
+
+/*Read a written summary into summary, freshly initialized.  Returns false if the data isn't a valid summary,
+  summary then holds what could be read and must still be freed.*/
+bool opra_summary_read(opra_summary *summary, const uint8_t *data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_SUMMARY_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,254 @@
+/* opra-tap.c
+ *
+ * Filling and formatting the "opra" tap record, see opra-tap.h
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include <string.h>
+
+#include "opra-tap.h"
+#include "opra-price.h"
+
+/*short quote prices have fixed scales, strikes in tenths and premiums in hundredths*/
+#define OPRA_TAP_SHORT_STRIKE_DENOMINATOR 'A'
+#define OPRA_TAP_SHORT_PREMIUM_DENOMINATOR 'B'
+
+/*copy a space padded symbol, dropping the padding*/
+static void opra_tap_copy_symbol(char *dest, const uint8_t *symbol, unsigned length)
+{
+    while ((length > 0) && (' ' == symbol[length - 1]))
+        length--;
+    memcpy(dest, symbol, length);
+    dest[length] = '\0';
+}
+
+static void opra_tap_set_price(int64_t *dest, uint8_t *flags, uint8_t flag, uint32_t value, uint8_t denominator_code)
+{
+    if (opra_price_scaled(value, denominator_code, dest))
+        *flags |= flag;
+}
+
+void opra_tap_fill(opra_tap_info *info, const opra_block *block, const opra_message *msg, unsigned index)
+{
+    const opra_block_header *hdr = &block->hdr;
+
+    memset(info, 0, sizeof(*info));
+    info->block_sequence_number = hdr->block_sequence_number;
+    info->timestamp_secs = hdr->timestamp_secs;
+    info->timestamp_nsecs = hdr->timestamp_nsecs;
+    info->session_indicator = hdr->session_indicator;
+    info->retransmission_indicator = hdr->retransmission_indicator;
+    info->messages_in_block = hdr->messages_in_block;
+    info->message_index = (uint8_t) index;
+    info->message_offset = (uint16_t) msg->offset;
+    info->message_length = (uint16_t) msg->length;
+
+    info->participant_id = msg->hdr.participant_id;
+    info->message_category = msg->hdr.message_category;
+    info->message_type = msg->hdr.message_type;
+    info->message_indicator = msg->hdr.message_indicator;
+    info->transaction_id = msg->hdr.transaction_id;
+
+    switch(msg->hdr.message_category)
+    {
+        case 'Y':{
+            const opra_msg_cat_Y *Y = &msg->body.Y;
+            opra_tap_copy_symbol(info->security_symbol, Y->security_symbol, 5);
+            opra_tap_set_price(&info->price, &info->flags, OPRA_TAP_HAS_PRICE, Y->index_value, Y->index_value_denominator_code);
+            break;
+        }
+        case 'a':{
+            const opra_msg_cat_a *a = &msg->body.a;
+            opra_tap_copy_symbol(info->security_symbol, a->security_symbol, 5);
+            memcpy(info->expiration_block, a->expiration_block, OPRA_TAP_EXPIRATION_BLOCK_SIZE);
+            opra_tap_set_price(&info->strike_price, &info->flags, OPRA_TAP_HAS_STRIKE, a->strike_price, a->strike_price_denominator_code);
+            opra_tap_set_price(&info->price, &info->flags, OPRA_TAP_HAS_PRICE, a->premium_price, a->premium_price_denominator_code);
+            info->volume = a->volume;
+            info->flags |= OPRA_TAP_HAS_VOLUME;
+            break;
+        }
+        case 'd':{
+            const opra_msg_cat_d *d = &msg->body.d;
+            opra_tap_copy_symbol(info->security_symbol, d->security_symbol, 5);
+            memcpy(info->expiration_block, d->expiration_block, OPRA_TAP_EXPIRATION_BLOCK_SIZE);
+            opra_tap_set_price(&info->strike_price, &info->flags, OPRA_TAP_HAS_STRIKE, d->strike_price, d->strike_price_denominator_code);
+            info->volume = d->volume;
+            info->flags |= OPRA_TAP_HAS_VOLUME;
+            break;
+        }
+        case 'f':{
+            /*the day's last sale and closing quote*/
+            const opra_msg_cat_f *f = &msg->body.f;
+            opra_tap_copy_symbol(info->security_symbol, f->security_symbol, 5);
+            memcpy(info->expiration_block, f->expiration_block, OPRA_TAP_EXPIRATION_BLOCK_SIZE);
+            opra_tap_set_price(&info->strike_price, &info->flags, OPRA_TAP_HAS_STRIKE, f->strike_price, f->strike_price_denominator_code);
+            opra_tap_set_price(&info->price, &info->flags, OPRA_TAP_HAS_PRICE, f->last_price, f->premium_price_denominator_code);
+            opra_tap_set_price(&info->bid_price, &info->flags, OPRA_TAP_HAS_BID, f->bid_price, f->premium_price_denominator_code);
+            opra_tap_set_price(&info->offer_price, &info->flags, OPRA_TAP_HAS_OFFER, f->offer_price, f->premium_price_denominator_code);
+            info->volume = f->volume;
+            info->flags |= OPRA_TAP_HAS_VOLUME;
+            break;
+        }
+        case 'k':{
+            const opra_msg_cat_k *k = &msg->body.k;
+            opra_tap_copy_symbol(info->security_symbol, k->security_symbol, 5);
+            memcpy(info->expiration_block, k->expiration_block, OPRA_TAP_EXPIRATION_BLOCK_SIZE);
+            opra_tap_set_price(&info->strike_price, &info->flags, OPRA_TAP_HAS_STRIKE, k->strike_price, k->strike_price_denominator_code);
+            opra_tap_set_price(&info->bid_price, &info->flags, OPRA_TAP_HAS_BID, k->bid_price, k->premium_price_denominator_code);
+            opra_tap_set_price(&info->offer_price, &info->flags, OPRA_TAP_HAS_OFFER, k->offer_price, k->premium_price_denominator_code);
+            info->bid_size = k->bid_size;
+            info->offer_size = k->offer_size;
+            break;
+        }
+        case 'q':{
+            const opra_msg_cat_q *q = &msg->body.q;
+            opra_tap_copy_symbol(info->security_symbol, q->security_symbol, 4);
+            memcpy(info->expiration_block, q->expiration_block, OPRA_TAP_EXPIRATION_BLOCK_SIZE);
+            opra_tap_set_price(&info->strike_price, &info->flags, OPRA_TAP_HAS_STRIKE, q->strike_price, OPRA_TAP_SHORT_STRIKE_DENOMINATOR);
+            opra_tap_set_price(&info->bid_price, &info->flags, OPRA_TAP_HAS_BID, q->bid_price, OPRA_TAP_SHORT_PREMIUM_DENOMINATOR);
+            opra_tap_set_price(&info->offer_price, &info->flags, OPRA_TAP_HAS_OFFER, q->offer_price, OPRA_TAP_SHORT_PREMIUM_DENOMINATOR);
+            info->bid_size = q->bid_size;
+            info->offer_size = q->offer_size;
+            break;
+        }
+        default:
+            break;
+    }
+
+    opra_appendage_iter iter;
+    opra_quote_appendage appendage;
+    opra_appendage_iter_init(&iter, msg);
+    while (opra_appendage_iter_next(&iter, &appendage)){
+        if (OPRA_APPENDAGE_BID == appendage.side){
+            info->best_bid_participant_id = appendage.participant_id;
+            info->best_bid_size = appendage.size;
+            opra_tap_set_price(&info->best_bid_price, &info->flags, OPRA_TAP_HAS_BEST_BID, appendage.price, appendage.denominator_code);
+        } else {
+            info->best_offer_participant_id = appendage.participant_id;
+            info->best_offer_size = appendage.size;
+            opra_tap_set_price(&info->best_offer_price, &info->flags, OPRA_TAP_HAS_BEST_OFFER, appendage.price, appendage.denominator_code);
+        }
+    }
+}
+
+/*the line being written, one that doesn't fit is cut short but stays terminated*/
+typedef struct _opra_tap_line {
+    char *buf;
+    size_t size;
+    size_t used;
+} opra_tap_line;
+
+static void opra_tap_append(opra_tap_line *line, const char *s)
+{
+    while (('\0' != *s) && (line->used + 1 < line->size))
+        line->buf[line->used++] = *s++;
+    line->buf[line->used] = '\0';
+}
+
+static void opra_tap_append_uint64(opra_tap_line *line, const char *name, uint64_t value)
+{
+    char digits[24];
+    char *p = digits + sizeof(digits) - 1;
+    *p = '\0';
+    do {
+        *--p = (char) ('0' + value % 10);
+        value /= 10;
+    } while (0 != value);
+    opra_tap_append(line, name);
+    opra_tap_append(line, p);
+}
+
+static void opra_tap_append_int64(opra_tap_line *line, const char *name, int64_t value)
+{
+    if (value < 0){
+        opra_tap_append(line, name);
+        opra_tap_append_uint64(line, "-", (uint64_t) 0 - (uint64_t) value);
+    } else {
+        opra_tap_append_uint64(line, name, (uint64_t) value);
+    }
+}
+
+static void opra_tap_append_hex(opra_tap_line *line, const char *name, uint8_t value)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char digits[3] = { hex[value >> 4], hex[value & 0x0f], '\0' };
+    opra_tap_append(line, name);
+    opra_tap_append(line, digits);
+}
+
+/*participant ID, price and size of a best bid or offer appendage*/
+static void opra_tap_append_appendage(opra_tap_line *line, const char *name, uint8_t participant_id, int64_t price, uint32_t size)
+{
+    opra_tap_append_hex(line, name, participant_id);
+    opra_tap_append_int64(line, "/", price);
+    opra_tap_append_uint64(line, "/", size);
+}
+
+char *opra_tap_format(char *buf, size_t size, const opra_tap_info *info)
+{
+    opra_tap_line line = { buf, size, 0 };
+    const bool quote = ('k' == info->message_category) || ('q' == info->message_category);
+    const char category[2] = { (char) info->message_category, '\0' };
+
+    if (0 == size)
+        return buf;
+    buf[0] = '\0';
+
+    opra_tap_append_uint64(&line, "seq=", info->block_sequence_number);
+    opra_tap_append_uint64(&line, " msgs=", info->messages_in_block);
+    opra_tap_append_uint64(&line, " idx=", info->message_index);
+    opra_tap_append_uint64(&line, " off=", info->message_offset);
+    opra_tap_append_uint64(&line, " len=", info->message_length);
+    opra_tap_append_hex(&line, " part=", info->participant_id);
+    opra_tap_append(&line, " cat=");
+    opra_tap_append(&line, category);
+    opra_tap_append_hex(&line, " type=", info->message_type);
+    opra_tap_append_hex(&line, " ind=", info->message_indicator);
+    opra_tap_append_uint64(&line, " txn=", info->transaction_id);
+    if ('\0' != info->security_symbol[0]){
+        opra_tap_append(&line, " sym=");
+        opra_tap_append(&line, info->security_symbol);
+        opra_tap_append_hex(&line, " exp=", info->expiration_block[0]);
+        opra_tap_append_hex(&line, "", info->expiration_block[1]);
+        opra_tap_append_hex(&line, "", info->expiration_block[2]);
+    }
+    opra_tap_append_hex(&line, " flags=", info->flags);
+
+    if (info->flags & OPRA_TAP_HAS_STRIKE)
+        opra_tap_append_int64(&line, " strike=", info->strike_price);
+    if (info->flags & OPRA_TAP_HAS_PRICE)
+        opra_tap_append_int64(&line, " price=", info->price);
+    if (info->flags & OPRA_TAP_HAS_VOLUME)
+        opra_tap_append_uint64(&line, " vol=", info->volume);
+    if (info->flags & OPRA_TAP_HAS_BID)
+        opra_tap_append_int64(&line, " bid=", info->bid_price);
+    if (quote)
+        opra_tap_append_uint64(&line, " bid_size=", info->bid_size);
+    if (info->flags & OPRA_TAP_HAS_OFFER)
+        opra_tap_append_int64(&line, " offer=", info->offer_price);
+    if (quote)
+        opra_tap_append_uint64(&line, " offer_size=", info->offer_size);
+    if (info->flags & OPRA_TAP_HAS_BEST_BID)
+        opra_tap_append_appendage(&line, " best_bid=", info->best_bid_participant_id, info->best_bid_price, info->best_bid_size);
+    if (info->flags & OPRA_TAP_HAS_BEST_OFFER)
+        opra_tap_append_appendage(&line, " best_offer=", info->best_offer_participant_id, info->best_offer_price, info->best_offer_size);
+    return buf;
+}
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
@@ -0,0 +1,54 @@
+/* opra-tap.h
+ *
+ * Filling and formatting the "opra" tap record from the decode core
+ * No epan dependency, so tools and tests outside the dissector build the same records.
+ *
+ * Wireshark - Network traffic analyzer
+ * By Gerald Combs <gerald@wireshark.org>
+ * Copyright 1998 Gerald Combs
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __OPRA_TAP_H__
+#define __OPRA_TAP_H__
+
+#include <stddef.h>
+
+#include "packet-opra.h"
+#include "opra-decode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/*longest line opra_tap_format() writes, a quote with both appendages, plus the terminator*/
+#define OPRA_TAP_FORMAT_SIZE 384
+
+/*Fill info from a decoded message, index being its position within the block.  Everything the decode core knows
+  is set, the port, duplicate, latency_ns and instrument_id are left 0 for the dissector to fill in.*/
+void opra_tap_fill(opra_tap_info *info, const opra_block *block, const opra_message *msg, unsigned index);
+
+/*Format the record as one line of name=value pairs, without a newline, for comparing tap streams as text.
+  Values set only per capture, the port, duplicate, latency_ns and instrument_id, are left out.
+  Optional values are only written when flags has them.  Returns buf.*/
+char *opra_tap_format(char *buf, size_t size, const opra_tap_info *info);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __OPRA_TAP_H__ */
+
+/*
+ * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+ *
+ * Local variables:
+ * c-basic-offset: 4
+ * tab-width: 8
+ * indent-tabs-mode: nil
+ * End:
+ *
+ * vi: set shiftwidth=4 tabstop=8 expandtab:
+ * :indentSize=4:tabSize=8:noTabs=true:
+ */
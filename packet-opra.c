@@ -12,42 +12,88 @@
  *
  */
 
-#include <math.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
 #include <string.h>
-#include <assert.h>
+#ifdef OPRA_PERF
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
 
 #include "config.h"
 #include <epan/packet.h>
+#include <epan/conversation.h>
 #include <epan/expert.h>
+#include <epan/prefs.h>
+#include <epan/uat.h>
+#include <epan/tap.h>
+#include <epan/stats_tree.h>
+#include <epan/stat_tap_ui.h>
+#include <wsutil/report_message.h>
+#include <epan/dissectors/packet-tcp.h>
 
 #include "packet-opra.h"
+#include "opra-decode.h"
+#include "opra-price.h"
+#include "opra-burst.h"
+#include "opra-book.h"
+#include "opra-checksum.h"
+#include "opra-index.h"
+#include "opra-export.h"
+#include "opra-pool.h"
+#include "opra-summary.h"
+#include "opra-tap.h"
 
 void proto_register_opra(void);
 void proto_reg_handoff_opra(void);
+static void opra_update_category_filter(void);
+static void opra_update_watchlist(void);
 
 static int dissect_opra(tvbuff_t *, packet_info *, proto_tree *, void*);
-static int dissect_opra_message_category_C(tvbuff_t *, int, packet_info *, proto_tree *, void*);
-static int dissect_opra_message_category_Y(tvbuff_t *, int, packet_info *, proto_tree *, void*);
-static int dissect_opra_message_category_a(tvbuff_t *, int, packet_info *, proto_tree *, void*);
-static int dissect_opra_message_category_d(tvbuff_t *, int, packet_info *, proto_tree *, void*);
-static int dissect_opra_message_category_k(tvbuff_t *, int, packet_info *, proto_tree *, void*);
-static int dissect_opra_message_category_q(tvbuff_t *, int, packet_info *, proto_tree *, void*);
-static int dissect_opra_quote_appendage(tvbuff_t *, int, packet_info *, proto_tree *, void*, uint32_t);
-
-/*port ranges for OPRA UDP dissemination*/
-#define OPRA_UDP_PORT_MIN 54321
-#define OPRA_UDP_PORT_MAX 54321
-
-/*block header size and message header size are fixed. Message sizes vary.*/
-#define OPRA_BLOCK_HEADER_SIZE 21
-#define OPRA_MESSAGE_HEADER_SIZE 12
+static bool dissect_opra_heur(tvbuff_t *, packet_info *, proto_tree *, void*);
+static int dissect_opra_tcp(tvbuff_t *, packet_info *, proto_tree *, void*);
+static bool dissect_opra_heur_tcp(tvbuff_t *, packet_info *, proto_tree *, void*);
+typedef struct _opra_block_summary opra_block_summary;
+static int dissect_opra_block(tvbuff_t *, packet_info *, proto_tree *, unsigned, opra_block_summary *);
+/*default port range for OPRA UDP dissemination, the udp.ports preference overrides it*/
+#define OPRA_UDP_PORT_RANGE "54321"
+
+static dissector_handle_t opra_handle;
+static dissector_handle_t opra_tcp_handle;
+static range_t *global_opra_udp_range;
+static range_t *opra_udp_range;
+
+/*Retransmission server sessions carry back to back blocks over TCP.  No ports by default, the sessions are
+  found with the tcp.ports preference, Decode As or the heuristic dissector.*/
+static range_t *global_opra_tcp_range;
+static range_t *opra_tcp_range;
+static bool opra_desegment = true;
+
+/*block format version the heuristic dissector accepts*/
+static unsigned opra_heur_version = OPRA_BLOCK_VERSION;
 
 static int proto_opra;
+static int opra_tap;
 static int ett_opra;
 static int ett_opra_message_header;
+static int ett_opra_book;
+static int ett_opra_expiration;
 
 /*expert fields for highlighting malformed packets / protocol errors*/
 static expert_field hf_opra_exp_block_length_error;
+static expert_field hf_opra_exp_block_truncated;
+static expert_field hf_opra_exp_sequence_gap;
+static expert_field hf_opra_exp_sequence_duplicate;
+static expert_field hf_opra_exp_sequence_reset;
+static expert_field hf_opra_exp_feed_duplicate;
+static expert_field hf_opra_exp_unknown_category;
+static expert_field hf_opra_exp_checksum_bad;
+static expert_field hf_opra_exp_book_evicted;
+static expert_field hf_opra_exp_unknown_length_guessed;
 
 /*block header and trailer fields*/
 static int hf_opra_version;
@@ -59,8 +105,54 @@ static int hf_opra_block_sequence_number;
 static int hf_opra_messages_in_block;
 static int hf_opra_block_timestamp;
 static int hf_opra_block_checksum;
+static int hf_opra_block_checksum_status;
 static int hf_opra_block_pad_byte;
 
+/*sequence tracking, generated*/
+static int hf_opra_expected_sequence_number;
+static int hf_opra_gap_size;
+static int hf_opra_prev_block_frame;
+
+/*A/B feed arbitration, generated*/
+static int hf_opra_feed;
+static int hf_opra_feed_line;
+static int hf_opra_feed_duplicate;
+static int hf_opra_feed_other_frame;
+static int hf_opra_feed_delta;
+
+/*exchange to capture latency, generated*/
+static int hf_opra_latency;
+
+/*category filter and watchlist, generated*/
+static int hf_opra_skipped_messages;
+static int hf_opra_unwatched_messages;
+
+/*instrument interning, generated*/
+static int hf_opra_instrument_id;
+static int hf_opra_instrument;
+
+/*decoded expiration block, shared by the categories that carry one*/
+static int hf_opra_expiration_month;
+static int hf_opra_expiration_put_call;
+static int hf_opra_expiration_day;
+static int hf_opra_expiration_year;
+static int hf_opra_expiration_date;
+static int hf_opra_expiration_days;
+
+/*sidecar index lookups, generated*/
+static int hf_opra_instrument_prev_frame;
+static int hf_opra_instrument_next_frame;
+static int hf_opra_instrument_messages;
+
+/*top of book, generated*/
+static int hf_opra_book_frame;
+static int hf_opra_book_bid_participant_id;
+static int hf_opra_book_bid_price;
+static int hf_opra_book_bid_size;
+static int hf_opra_book_offer_participant_id;
+static int hf_opra_book_offer_price;
+static int hf_opra_book_offer_size;
+
 /*message header fields*/
 static int hf_opra_msg_hdr_participant_id;
 static int hf_opra_msg_hdr_message_category;
@@ -74,6 +166,10 @@ static int hf_opra_msg_hdr_participant_reference_number;
 static int hf_opra_msg_cat_C_data_length;
 static int hf_opra_msg_cat_C_data;
 
+/*body of a message of unknown category*/
+static int hf_opra_msg_unknown_data;
+static int hf_opra_msg_unknown_length;
+
 /*control messages are header only, no fields.*/
 
 /*underlying value*/
@@ -103,6 +199,25 @@ static int hf_opra_msg_cat_d_strike_price_denominator_code;
 static int hf_opra_msg_cat_d_strike_price;
 static int hf_opra_msg_cat_d_volume;
 
+/*end of day summary*/
+static int hf_opra_msg_cat_f_security_symbol;
+static int hf_opra_msg_cat_f_reserved;
+static int hf_opra_msg_cat_f_expiration_block;
+static int hf_opra_msg_cat_f_strike_price_denominator_code;
+static int hf_opra_msg_cat_f_strike_price;
+static int hf_opra_msg_cat_f_volume;
+static int hf_opra_msg_cat_f_open_interest;
+static int hf_opra_msg_cat_f_premium_price_denominator_code;
+static int hf_opra_msg_cat_f_open_price;
+static int hf_opra_msg_cat_f_high_price;
+static int hf_opra_msg_cat_f_low_price;
+static int hf_opra_msg_cat_f_last_price;
+static int hf_opra_msg_cat_f_net_change;
+static int hf_opra_msg_cat_f_underlying_price_denominator_code;
+static int hf_opra_msg_cat_f_underlying_price;
+static int hf_opra_msg_cat_f_bid_price;
+static int hf_opra_msg_cat_f_offer_price;
+
 /*long quote*/
 static int hf_opra_msg_cat_k_security_symbol;
 static int hf_opra_msg_cat_k_reserved;
@@ -135,7 +250,57 @@ static int hf_opra_msg_offer_appendage_denominator_code;
 static int hf_opra_msg_offer_appendage_price;
 static int hf_opra_msg_offer_appendage_size;
 
+/*normalized numeric prices, generated alongside every price field*/
+static int hf_opra_msg_cat_Y_index_value_value;
+static int hf_opra_msg_cat_Y_index_value_e8;
+static int hf_opra_msg_cat_a_strike_price_value;
+static int hf_opra_msg_cat_a_strike_price_e8;
+static int hf_opra_msg_cat_a_premium_price_value;
+static int hf_opra_msg_cat_a_premium_price_e8;
+static int hf_opra_msg_cat_d_strike_price_value;
+static int hf_opra_msg_cat_d_strike_price_e8;
+static int hf_opra_msg_cat_f_strike_price_value;
+static int hf_opra_msg_cat_f_strike_price_e8;
+static int hf_opra_msg_cat_f_open_price_value;
+static int hf_opra_msg_cat_f_open_price_e8;
+static int hf_opra_msg_cat_f_high_price_value;
+static int hf_opra_msg_cat_f_high_price_e8;
+static int hf_opra_msg_cat_f_low_price_value;
+static int hf_opra_msg_cat_f_low_price_e8;
+static int hf_opra_msg_cat_f_last_price_value;
+static int hf_opra_msg_cat_f_last_price_e8;
+static int hf_opra_msg_cat_f_net_change_value;
+static int hf_opra_msg_cat_f_net_change_e8;
+static int hf_opra_msg_cat_f_underlying_price_value;
+static int hf_opra_msg_cat_f_underlying_price_e8;
+static int hf_opra_msg_cat_f_bid_price_value;
+static int hf_opra_msg_cat_f_bid_price_e8;
+static int hf_opra_msg_cat_f_offer_price_value;
+static int hf_opra_msg_cat_f_offer_price_e8;
+static int hf_opra_msg_cat_k_strike_price_value;
+static int hf_opra_msg_cat_k_strike_price_e8;
+static int hf_opra_msg_cat_k_bid_price_value;
+static int hf_opra_msg_cat_k_bid_price_e8;
+static int hf_opra_msg_cat_k_offer_price_value;
+static int hf_opra_msg_cat_k_offer_price_e8;
+static int hf_opra_msg_cat_q_strike_price_value;
+static int hf_opra_msg_cat_q_strike_price_e8;
+static int hf_opra_msg_cat_q_bid_price_value;
+static int hf_opra_msg_cat_q_bid_price_e8;
+static int hf_opra_msg_cat_q_offer_price_value;
+static int hf_opra_msg_cat_q_offer_price_e8;
+static int hf_opra_msg_bid_appendage_price_value;
+static int hf_opra_msg_bid_appendage_price_e8;
+static int hf_opra_msg_offer_appendage_price_value;
+static int hf_opra_msg_offer_appendage_price_e8;
+
 /*friendly display names for simple enum fields*/
+static const value_string hf_opra_feeds[] = {
+    {'A', "A Feed"},
+    {'B', "B Feed"},
+    { 0, NULL}
+};
+
 static const value_string hf_opra_data_feed_indicators[] = {
     {'O', "OPRA"},
     { 0, NULL}
@@ -149,7 +314,30 @@ static const value_string hf_opra_retransmission_indicators[] = {
 
 static const value_string hf_opra_session_indicators[] = {
     { 0, "Normal"},
-    {'X', "Pre-market Extended"}
+    {'X', "Pre-market Extended"},
+    { 0, NULL}
+};
+
+static const value_string hf_opra_expiration_months[] = {
+    { 1, "January"},
+    { 2, "February"},
+    { 3, "March"},
+    { 4, "April"},
+    { 5, "May"},
+    { 6, "June"},
+    { 7, "July"},
+    { 8, "August"},
+    { 9, "September"},
+    {10, "October"},
+    {11, "November"},
+    {12, "December"},
+    { 0, NULL}
+};
+
+static const value_string hf_opra_put_call[] = {
+    {'C', "Call"},
+    {'P', "Put"},
+    { 0, NULL}
 };
 
 static const value_string hf_opra_participant_ids[] = {
@@ -186,15 +374,15 @@ static const value_string hf_opra_message_categories[] = {
 };
 
 /*Decoding of message type depends on message category.
-  Some types have both a short and long description, combine those into one string for display.*/
-#define OPRA_MESSAGE_TYPES_DISPLAY_STRING(w, x, y) {w, x " : " y},
+  Some types have both a short and long description, combine those into one string for display.
+  The tables are indexed directly by the message type byte, unused entries are NULL.*/
+#define OPRA_MESSAGE_TYPES_DISPLAY_STRING(w, x, y) [w] = x " : " y,
 
 /*administrative*/
 #define OPRA_MSG_CAT_C_TYPES(D) \
     D(' ', "", "Administrative")
-static const value_string hf_opra_msg_cat_C_types[] = {
+static const char * const hf_opra_msg_cat_C_types[256] = {
     OPRA_MSG_CAT_C_TYPES(OPRA_MESSAGE_TYPES_DISPLAY_STRING)
-    { 0, NULL}
 };
 
 /*control*/
@@ -208,18 +396,16 @@ static const value_string hf_opra_msg_cat_C_types[] = {
     D('M', "", "End of Open Interest") \
     D('N', "", "Line Integrity") \
     D('P', "", "Disaster Recovery Data Center Activation")
-static const value_string hf_opra_msg_cat_H_types[] = {
+static const char * const hf_opra_msg_cat_H_types[256] = {
     OPRA_MSG_CAT_H_TYPES(OPRA_MESSAGE_TYPES_DISPLAY_STRING)
-    { 0, NULL}
 };
 
 /*Underlying Value*/
 #define OPRA_MSG_CAT_Y_TYPES(D) \
     D(' ', "", "Index based on Last Sale") \
     D('I', "", "Index based on Bid and Offer")
-static const value_string hf_opra_msg_cat_Y_types[] = {
+static const char * const hf_opra_msg_cat_Y_types[256] = {
     OPRA_MSG_CAT_Y_TYPES(OPRA_MESSAGE_TYPES_DISPLAY_STRING)
-    { 0, NULL}
 };
 
 /*last sale*/
@@ -258,27 +444,24 @@ static const value_string hf_opra_msg_cat_Y_types[] = {
     D('u', "MCTP", "Multilateral Compression Trade of Proprietary Products") \
     D('v', "EXHT", "Extended Hours Trade")
 
-static const value_string hf_opra_msg_cat_a_types[] = {
+static const char * const hf_opra_msg_cat_a_types[256] = {
     OPRA_MSG_CAT_a_TYPES(OPRA_MESSAGE_TYPES_DISPLAY_STRING)
-    { 0, NULL}
 };
 
 /*open interest*/
 #define OPRA_MSG_CAT_d_TYPES(D) \
     D(' ', "", "Open Interest")
 
-static const value_string hf_opra_msg_cat_d_types[] = {
+static const char * const hf_opra_msg_cat_d_types[256] = {
     OPRA_MSG_CAT_d_TYPES(OPRA_MESSAGE_TYPES_DISPLAY_STRING)
-    { 0, NULL}
 };
 
-/*open interest*/
+/*end of day summary*/
 #define OPRA_MSG_CAT_f_TYPES(D) \
     D(' ', "", "Equity and Index End of Day Summary")
 
-static const value_string hf_opra_msg_cat_f_types[] = {
+static const char * const hf_opra_msg_cat_f_types[256] = {
     OPRA_MSG_CAT_f_TYPES(OPRA_MESSAGE_TYPES_DISPLAY_STRING)
-    { 0, NULL}
 };
 
 /*long quote*/
@@ -295,9 +478,8 @@ static const value_string hf_opra_msg_cat_f_types[] = {
     D('X', "", "Offer Side of Quote Not Firm; Bid Side Firm") \
     D('Y', "", "Bid Side of Quote Not Firm; Offer Side Firm")
 
-static const value_string hf_opra_msg_cat_k_types[] = {
+static const char * const hf_opra_msg_cat_k_types[256] = {
     OPRA_MSG_CAT_k_TYPES(OPRA_MESSAGE_TYPES_DISPLAY_STRING)
-    { 0, NULL}
 };
 
 /*short quote, currently same as long quote*/
@@ -314,142 +496,238 @@ static const value_string hf_opra_msg_cat_k_types[] = {
     D('X', "", "Offer Side of Quote Not Firm; Bid Side Firm") \
     D('Y', "", "Bid Side of Quote Not Firm; Offer Side Firm")
 
-static const value_string hf_opra_msg_cat_q_types[] = {
+static const char * const hf_opra_msg_cat_q_types[256] = {
     OPRA_MSG_CAT_q_TYPES(OPRA_MESSAGE_TYPES_DISPLAY_STRING)
-    { 0, NULL}
 };
 
-/*associate category with permitted message types*/
-typedef struct _hf_opra_msg_cat_to_types_detail {
-    char category;
-    const value_string *message_types;
-} hf_opra_msg_cat_to_types_detail;
-
-static const hf_opra_msg_cat_to_types_detail hf_opra_msg_cat_to_types[] = {
-    {.category = 'C', .message_types = hf_opra_msg_cat_C_types},
-    {'H', hf_opra_msg_cat_H_types},
-    {'Y', hf_opra_msg_cat_Y_types},
-    {'a', hf_opra_msg_cat_a_types},
-    {'d', hf_opra_msg_cat_d_types},
-    {'f', hf_opra_msg_cat_f_types},
-    {'k', hf_opra_msg_cat_k_types},
-    {'q', hf_opra_msg_cat_q_types},
-    { 0, NULL}
+/*associate category with permitted message types, indexed directly by the category byte*/
+static const char * const *hf_opra_msg_cat_to_types[256] = {
+    ['C'] = hf_opra_msg_cat_C_types,
+    ['H'] = hf_opra_msg_cat_H_types,
+    ['Y'] = hf_opra_msg_cat_Y_types,
+    ['a'] = hf_opra_msg_cat_a_types,
+    ['d'] = hf_opra_msg_cat_d_types,
+    ['f'] = hf_opra_msg_cat_f_types,
+    ['k'] = hf_opra_msg_cat_k_types,
+    ['q'] = hf_opra_msg_cat_q_types,
 };
 
-static const hf_opra_msg_cat_to_types_detail *FindTypesForCategory(char category)
+/*get appropriate description for message type, depending on message category*/
+static const char* GetMessageTypeDescription(uint8_t message_category, uint8_t message_type)
 {
-    const hf_opra_msg_cat_to_types_detail *p = hf_opra_msg_cat_to_types;
-    assert(NULL != p);
-
-    while (0 != p->category){
-        if (category == p->category)
-            return p;
-
-        /*advance to next array entry*/
-        p++;
-    }
+    const char * const *message_types = hf_opra_msg_cat_to_types[message_category];
+    if (NULL == message_types)
+        return "cat not found";
 
-    return NULL;
+    const char *description = message_types[message_type];
+    return (NULL != description) ? description : "type not found";
 }
 
-/*get appropriate description for message type, depending on message category*/
-static const char* GetMessageTypeDescription(uint32_t message_category, uint8_t message_type)
-{
-    /*get the map detail for this category*/
-    const hf_opra_msg_cat_to_types_detail *pMessageTypes = FindTypesForCategory(message_category);
-    if (NULL == pMessageTypes)
-        return "cat not found";
+/*Message Indicator decoding for short and long quote types, indexed directly by the indicator byte*/
+static const char * const hf_opra_message_indicators[256] = {
+    ['A'] = "No Best Bid Change, No Best Offer Change",
+    ['B'] = "No Best Bid Change, Quote Contains Best Offer",
+    ['C'] = "No Best Bid Change, Best Offer Appendage",
+    ['D'] = "No Best Bid Change, No Best Offer",
+
+    ['E'] = "Quote Contains Best Bid, No Best Offer Change",
+    ['F'] = "Quote Contains Best Bid, Quote Contains Best Offer",
+    ['G'] = "Quote Contains Best Bid, Best Offer Appendage",
+    ['H'] = "Quote Contains Best Bid, No Best Offer",
+
+    ['I'] = "No Best Bid, No Best Offer Change",
+    ['J'] = "No Best Bid, Quote Contains Best Offer",
+    ['K'] = "No Best Bid, Best Offer Appendage",
+    ['L'] = "No Best Bid, No Best Offer",
+
+    ['M'] = "Best Bid Appendage, No Best Offer Change",
+    ['N'] = "Best Bid Appendage, Quote Contains Best Offer",
+    ['O'] = "Best Bid Appendage, Best Offer Appendage",
+    ['P'] = "Best Bid Appendage, No Best Offer",
+
+    [' '] = "Unused",
+};
 
-    /*look at each types entry until we find one that matches our type, or return "not found"*/
-    return val_to_str(message_type, pMessageTypes->message_types, "type not found");
+static int dissect_opra_no_tree(tvbuff_t *, packet_info *, const opra_block *, unsigned, bool, opra_block_summary *);
+typedef struct _opra_instrument opra_instrument;
+static opra_instrument *opra_intern_instrument(packet_info *, const opra_message *);
+static char *opra_format_instrument_name(wmem_allocator_t *, const opra_instrument_key *);
+static void dissect_opra_instrument(tvbuff_t *, packet_info *, proto_tree *, const opra_message *, opra_instrument *);
+static inline bool opra_message_skipped(const opra_message_iter *);
+static bool opra_watchlist_root_matches(const opra_message_iter *);
+static bool opra_block_updates_book(const packet_info *, const opra_block *, bool);
+static void opra_book_update(packet_info *, const opra_message *, unsigned, unsigned, opra_instrument *);
+static void dissect_opra_book(tvbuff_t *, packet_info *, proto_tree *, const opra_message *, unsigned, unsigned, opra_instrument *);
+static void opra_tap_message(packet_info *, const opra_block *, const opra_message *, unsigned, bool, const opra_instrument *);
+typedef struct _opra_sequence_info opra_sequence_info;
+static const opra_sequence_info *opra_track_sequence(packet_info *, const opra_block *, unsigned);
+static void opra_summary_note_message(const opra_message *);
+static void opra_summary_note_skipped(const opra_message_iter *, bool);
+static void dissect_opra_sequence(tvbuff_t *, packet_info *, proto_tree *, proto_item *, const opra_sequence_info *);
+typedef struct _opra_arbitration_info opra_arbitration_info;
+static const opra_arbitration_info *opra_arbitrate(packet_info *, const opra_block *, unsigned);
+static void dissect_opra_arbitration(tvbuff_t *, packet_info *, proto_tree *, const opra_arbitration_info *);
+static int64_t opra_latency_ns(const packet_info *, const opra_block_header *);
+static int dissect_opra_message_header(tvbuff_t *, int, proto_tree *, const opra_message *);
+static int dissect_opra_message_category_C(tvbuff_t *, int, proto_tree *, const opra_message *);
+typedef struct _opra_message_layout opra_message_layout;
+static int dissect_opra_message_body(tvbuff_t *, int, proto_tree *, const uint8_t *, const opra_message_layout *, const opra_block *,
+    const opra_instrument *);
+static int dissect_opra_quote_appendages(tvbuff_t *, int, proto_tree *, const opra_message *);
+
+#ifdef OPRA_PERF
+/*Hot path counters, built with the OPRA_PERF CMake option and shown by Statistics > OPRA Performance, -z opra,perf.
+  The ticks are charged to one stage at a time: entering a stage charges those since the last switch to the stage
+  being left, so a stage nested in another, such as price formatting while the tree is built, isn't counted twice.
+  Ticks are the time stamp counter on x86, the virtual counter on AArch64 and microseconds elsewhere.
+  The counters are per thread, so a tool dissecting on several threads keeps them without locks; Wireshark
+  dissects on one, the thread the tap reports on.*/
+#if defined(_MSC_VER)
+#define OPRA_PERF_THREAD_LOCAL __declspec(thread)
+#else
+#define OPRA_PERF_THREAD_LOCAL _Thread_local
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define opra_perf_ticks() ((uint64_t) __rdtsc())
+#elif defined(__x86_64__) || defined(__i386__)
+#define opra_perf_ticks() ((uint64_t) __rdtsc())
+#elif defined(__GNUC__) && defined(__aarch64__)
+static inline uint64_t opra_perf_ticks(void)
+{
+    uint64_t ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r" (ticks));
+    return ticks;
 }
+#else
+#define opra_perf_ticks() ((uint64_t) g_get_monotonic_time())
+#endif
+
+/*the idle stage is the time outside the dissector, it isn't shown*/
+enum {
+    OPRA_PERF_STAGE_IDLE,
+    OPRA_PERF_STAGE_BLOCK,
+    OPRA_PERF_STAGE_SEQUENCE,
+    OPRA_PERF_STAGE_CHECKSUM,
+    OPRA_PERF_STAGE_WALK,
+    OPRA_PERF_STAGE_INSTRUMENT,
+    OPRA_PERF_STAGE_BOOK,
+    OPRA_PERF_STAGE_TAP,
+    OPRA_PERF_STAGE_TREE,
+    OPRA_PERF_STAGE_PRICE,
+    OPRA_PERF_STAGE_INFO,
+    OPRA_PERF_STAGES
+};
 
-/*Message Indicator decoding for short and long quote types*/
-static const value_string hf_opra_message_indicators[] = {
-    {'A', "No Best Bid Change, No Best Offer Change"},
-    {'B', "No Best Bid Change, Quote Contains Best Offer"},
-    {'C', "No Best Bid Change, Best Offer Appendage"},
-    {'D', "No Best Bid Change, No Best Offer"},
+typedef struct _opra_perf_counters {
+    uint64_t ticks[OPRA_PERF_STAGES];
+    uint64_t calls[OPRA_PERF_STAGES];
+    uint64_t messages[256];         /*by category byte, every message walked or skipped*/
+    uint64_t bytes[256];
+    uint64_t since;                 /*ticks at the last switch*/
+    unsigned stage;                 /*being charged*/
+} opra_perf_counters;
 
-    {'E', "Quote Contains Best Bid, No Best Offer Change"},
-    {'F', "Quote Contains Best Bid, Quote Contains Best Offer"},
-    {'G', "Quote Contains Best Bid, Best Offer Appendage"},
-    {'H', "Quote Contains Best Bid, No Best Offer"},
+static OPRA_PERF_THREAD_LOCAL opra_perf_counters opra_perf;
 
-    {'I', "No Best Bid, No Best Offer Change"},
-    {'J', "No Best Bid, Quote Contains Best Offer"},
-    {'K', "No Best Bid, Best Offer Appendage"},
-    {'L', "No Best Bid, No Best Offer"},
+static void opra_perf_reset(void)
+{
+    memset(&opra_perf, 0, sizeof(opra_perf));
+    opra_perf.since = opra_perf_ticks();
+}
 
-    {'M', "Best Bid Appendage, No Best Offer Change"},
-    {'N', "Best Bid Appendage, Quote Contains Best Offer"},
-    {'O', "Best Bid Appendage, Best Offer Appendage"},
-    {'P', "Best Bid Appendage, No Best Offer"},
+/*charge the ticks so far to the current stage and go on in stage*/
+static inline void opra_perf_charge(unsigned stage)
+{
+    const uint64_t now = opra_perf_ticks();
+    opra_perf.ticks[opra_perf.stage] += now - opra_perf.since;
+    opra_perf.since = now;
+    opra_perf.stage = stage;
+}
 
-    {' ', "Unused"},
-    { 0, NULL}
-};
+/*returns the stage left, for opra_perf_charge() to go back to*/
+static inline unsigned opra_perf_enter(unsigned stage)
+{
+    const unsigned left = opra_perf.stage;
+    opra_perf_charge(stage);
+    opra_perf.calls[stage]++;
+    return left;
+}
+
+/*into the dissector.  A dissection that threw out of a stage never went back, so the time since goes to idle.*/
+static inline void opra_perf_begin(void)
+{
+    opra_perf.stage = OPRA_PERF_STAGE_IDLE;
+    opra_perf_charge(OPRA_PERF_STAGE_BLOCK);
+}
 
-/*these Message Indicator values indicate the presence of quote appendages*/
-static const char *hf_opra_msg_indicator_best_offer_appendages _U_ = "CGKO";
-static const char *hf_opra_msg_indicator_best_bid_appendages _U_ = "MNOP";
+static inline void opra_perf_message(const opra_message_iter *iter, int offset, opra_decode_status status)
+{
+    if (OPRA_DECODE_OK != status)
+        return;
+    const uint8_t message_category = iter->block->data[offset + OPRA_MESSAGE_CATEGORY_OFFSET];
+    opra_perf.messages[message_category]++;
+    opra_perf.bytes[message_category] += (uint64_t) (iter->offset - offset);
+}
 
-/*fixed point denominator codes used by the spec.  Various uses for these.*/
+#define OPRA_PERF_BEGIN() opra_perf_begin()
+#define OPRA_PERF_END() opra_perf_charge(OPRA_PERF_STAGE_IDLE)
+#define OPRA_PERF_ENTER(left, stage) const unsigned left = opra_perf_enter(stage)
+#define OPRA_PERF_SWITCH(stage) (void) opra_perf_enter(stage)
+#define OPRA_PERF_LEAVE(left) opra_perf_charge(left)
+#else
+#define OPRA_PERF_BEGIN()
+#define OPRA_PERF_END()
+#define OPRA_PERF_ENTER(left, stage)
+#define OPRA_PERF_SWITCH(stage)
+#define OPRA_PERF_LEAVE(left)
+#endif
+
+/*fixed point denominator codes used by the spec.  Various uses for these.
+  The number of decimal places for each code is in the decode core, see opra-price.h*/
 #define OPRA_DENOMINATOR_CODE_LIST(D) \
-    D('A', _1dps, "(%d) %d.%01d", "1 DPS") \
-    D('B', _2dps, "(%d) %d.%02d", "2 DPS") \
-    D('C', _3dps, "(%d) %d.%03d", "3 DPS") \
-    D('D', _4dps, "(%d) %d.%04d", "4 DPS") \
-    D('E', _5dps, "(%d) %d.%05d", "5 DPS") \
-    D('F', _6dps, "(%d) %d.%06d", "6 DPS") \
-    D('G', _7dps, "(%d) %d.%07d", "7 DPS") \
-    D('H', _8dps, "(%d) %d.%08d", "8 DPS") \
-    D('I', _0dps, "(%d) %d", "0 DPS")
+    D('A', _1dps, "1 DPS") \
+    D('B', _2dps, "2 DPS") \
+    D('C', _3dps, "3 DPS") \
+    D('D', _4dps, "4 DPS") \
+    D('E', _5dps, "5 DPS") \
+    D('F', _6dps, "6 DPS") \
+    D('G', _7dps, "7 DPS") \
+    D('H', _8dps, "8 DPS") \
+    D('I', _0dps, "0 DPS")
 
 /*define the denom codes in an enum*/
-#define OPRA_DENOMINATOR_CODE_ENUM_ENTRY(w, x, y, z) x = w,
+#define OPRA_DENOMINATOR_CODE_ENUM_ENTRY(x, y, z) y = x,
 typedef enum _denom_code {
     OPRA_DENOMINATOR_CODE_LIST(OPRA_DENOMINATOR_CODE_ENUM_ENTRY)
 } denom_code;
 
 /*value_string array for display of the denom code*/
-#define OPRA_DENOMINATOR_CODE_DISPLAY_STRING_ENTRY(w, x, y, z) { x, z },
+#define OPRA_DENOMINATOR_CODE_DISPLAY_STRING_ENTRY(x, y, z) { y, z },
 static const value_string hf_opra_denominator_codes[] = {
     OPRA_DENOMINATOR_CODE_LIST(OPRA_DENOMINATOR_CODE_DISPLAY_STRING_ENTRY)
     {0, NULL}
 };
 
-/*value_string array for formatting prices depending on denom code*/
-#define OPRA_DENOMINATOR_CODE_FORMAT_STRING_ENTRY(w, x, y, z) { x, y },
-static const value_string denom_code_format_strings[] = {
-    OPRA_DENOMINATOR_CODE_LIST(OPRA_DENOMINATOR_CODE_FORMAT_STRING_ENTRY)
-    {0, NULL}
-};
-
 //TODO - check upcasting of char into uint32_t if I'm doing that anywhere - char might be signed on some systems.
 
-/*Price formatting utility functions*/
+/*Price formatting utility functions.
+  Writes "(raw value) price" into the caller's buffer, which must be ITEM_LABEL_LENGTH bytes.*/
 static void DisplayPrice(char *pBuff, uint32_t value, denom_code code)
 {
     if (NULL == pBuff)
         return;
 
-    const char *fmt = val_to_str(code, denom_code_format_strings, "bad denom_code");
-
-    /*make use of the ascending ascii values for denom code, 0dps is the exception*/
-    uint32_t divisor;
-    if (_0dps == code) {divisor = 1;}
-        else {divisor = pow(10, ((uint8_t) (code - _1dps) + 1));}
-
-    const uint32_t whole_part = value / divisor;
-    const uint32_t fraction_part = value % divisor;
-
-    int size = snprintf(pBuff, ITEM_LABEL_LENGTH, fmt, value, whole_part, fraction_part);
-
-    if (size > ITEM_LABEL_LENGTH) {snprintf(pBuff, ITEM_LABEL_LENGTH, "xxxx");}
+    OPRA_PERF_ENTER(perf_left, OPRA_PERF_STAGE_PRICE);
+    char *p = pBuff;
+    *p++ = '(';
+    p = opra_format_uint32(p, value);
+    *p++ = ')';
+    *p++ = ' ';
 
-    return;
+    if (0 == opra_price_format(p, ITEM_LABEL_LENGTH - (p - pBuff), value, code))
+        (void) g_strlcpy(p, "bad denom_code", ITEM_LABEL_LENGTH - (p - pBuff));
+    OPRA_PERF_LEAVE(perf_left);
 }
 
 /*Helper functions for use with BASE_CUSTOM fields*/
@@ -465,12 +743,792 @@ static void DisplayShortQuotePrice(char *pBuff, uint32_t value)
     return DisplayPrice(pBuff, value, _2dps);
 }
 
+/*two's complement prices, the denominator code applies to the magnitude*/
+static void DisplaySignedPrice(char *pBuff, int32_t value, denom_code code)
+{
+    if (NULL == pBuff)
+        return;
+    if (value >= 0){
+        DisplayPrice(pBuff, (uint32_t) value, code);
+        return;
+    }
+
+    const uint32_t magnitude = (uint32_t) 0 - (uint32_t) value;
+    char *p = pBuff;
+    *p++ = '(';
+    *p++ = '-';
+    p = opra_format_uint32(p, magnitude);
+    *p++ = ')';
+    *p++ = ' ';
+
+    *p = '-';
+    if (0 == opra_price_format(p + 1, ITEM_LABEL_LENGTH - (p + 1 - pBuff), magnitude, code))
+        (void) g_strlcpy(p, "bad denom_code", ITEM_LABEL_LENGTH - (p - pBuff));
+}
+
 static void DisplayShortQuoteSize(char * pBuff, uint32_t value)
 {
     /*per spec is implied whole number*/
     return DisplayPrice(pBuff, value, _0dps);
 }
 
+/*Field layouts of the fixed size message bodies.  A single loop, dissect_opra_message_body, walks these
+  for every category, so adding a category is a matter of adding a table.*/
+typedef enum _opra_field_kind {
+    OPRA_FIELD_UINT,              /*big endian unsigned integer*/
+    OPRA_FIELD_TEXT,              /*ASCII text, added from the tvb so non ASCII bytes get the usual substitution*/
+    OPRA_FIELD_BYTES,             /*raw bytes, added from the tvb*/
+    OPRA_FIELD_EXPIRATION,        /*expiration block, the raw bytes with the decoded date under them*/
+    OPRA_FIELD_DENOMINATOR,       /*denominator code, applies to the price fields that follow it*/
+    OPRA_FIELD_NEXT_DENOMINATOR,  /*denominator code for the next price field only, the previous code applies after it*/
+    OPRA_FIELD_PRICE,             /*fixed point price, a number labelled with the preceding denominator code applied*/
+    OPRA_FIELD_SIGNED_PRICE,      /*as OPRA_FIELD_PRICE, two's complement*/
+    OPRA_FIELD_PRICE_TEXT         /*fixed point price shown as a string field, formatted with the preceding denominator code*/
+} opra_field_kind;
+
+/*Price fields also carry the normalized numeric fields added after them.  Prices with a fixed scale in the
+  spec, the short quote, name their denominator code here instead of following a denominator field.*/
+typedef struct _opra_field_layout {
+    int *hf;
+    uint8_t length;
+    opra_field_kind kind;
+    uint8_t implied_denominator;
+    int *hf_price_value;
+    int *hf_price_e8;
+} opra_field_layout;
+
+struct _opra_message_layout {
+    const opra_field_layout *fields;
+    unsigned field_count;
+};
+
+#define OPRA_MESSAGE_LAYOUT(fields) { fields, array_length(fields) }
+#define OPRA_FIELD(hf, length, kind) { &hf, length, kind, 0, NULL, NULL }
+#define OPRA_PRICE_FIELD(hf, length, kind, implied_denominator) { &hf, length, kind, implied_denominator, &hf##_value, &hf##_e8 }
+
+/*underlying value*/
+static const opra_field_layout opra_msg_cat_Y_fields[] = {
+    OPRA_FIELD(hf_opra_msg_cat_Y_security_symbol, 5, OPRA_FIELD_TEXT),
+    OPRA_FIELD(hf_opra_msg_cat_Y_reserved1, 1, OPRA_FIELD_BYTES),
+    OPRA_FIELD(hf_opra_msg_cat_Y_index_value_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_Y_index_value, 4, OPRA_FIELD_PRICE_TEXT, 0),
+    OPRA_FIELD(hf_opra_msg_cat_Y_reserved2, 4, OPRA_FIELD_BYTES),
+};
+
+/*last sale*/
+static const opra_field_layout opra_msg_cat_a_fields[] = {
+    OPRA_FIELD(hf_opra_msg_cat_a_security_symbol, 5, OPRA_FIELD_TEXT),
+    OPRA_FIELD(hf_opra_msg_cat_a_reserved1, 1, OPRA_FIELD_BYTES),
+    OPRA_FIELD(hf_opra_msg_cat_a_expiration_block, 3, OPRA_FIELD_EXPIRATION),
+    OPRA_FIELD(hf_opra_msg_cat_a_strike_price_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_a_strike_price, 4, OPRA_FIELD_PRICE_TEXT, 0),
+    OPRA_FIELD(hf_opra_msg_cat_a_volume, 4, OPRA_FIELD_UINT),
+    OPRA_FIELD(hf_opra_msg_cat_a_premium_price_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_a_premium_price, 4, OPRA_FIELD_PRICE_TEXT, 0),
+    OPRA_FIELD(hf_opra_msg_cat_a_trade_identifier, 4, OPRA_FIELD_UINT),
+    OPRA_FIELD(hf_opra_msg_cat_a_reserved2, 4, OPRA_FIELD_BYTES),
+};
+
+/*open interest*/
+static const opra_field_layout opra_msg_cat_d_fields[] = {
+    OPRA_FIELD(hf_opra_msg_cat_d_security_symbol, 5, OPRA_FIELD_TEXT),
+    OPRA_FIELD(hf_opra_msg_cat_d_reserved, 1, OPRA_FIELD_BYTES),
+    OPRA_FIELD(hf_opra_msg_cat_d_expiration_block, 3, OPRA_FIELD_EXPIRATION),
+    OPRA_FIELD(hf_opra_msg_cat_d_strike_price_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_d_strike_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_FIELD(hf_opra_msg_cat_d_volume, 4, OPRA_FIELD_UINT),
+};
+
+/*end of day summary.  The bid and offer are premiums, they follow the underlying price but not its denominator code.*/
+static const opra_field_layout opra_msg_cat_f_fields[] = {
+    OPRA_FIELD(hf_opra_msg_cat_f_security_symbol, 5, OPRA_FIELD_TEXT),
+    OPRA_FIELD(hf_opra_msg_cat_f_reserved, 1, OPRA_FIELD_BYTES),
+    OPRA_FIELD(hf_opra_msg_cat_f_expiration_block, 3, OPRA_FIELD_EXPIRATION),
+    OPRA_FIELD(hf_opra_msg_cat_f_strike_price_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_strike_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_FIELD(hf_opra_msg_cat_f_volume, 4, OPRA_FIELD_UINT),
+    OPRA_FIELD(hf_opra_msg_cat_f_open_interest, 4, OPRA_FIELD_UINT),
+    OPRA_FIELD(hf_opra_msg_cat_f_premium_price_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_open_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_high_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_low_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_last_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_net_change, 4, OPRA_FIELD_SIGNED_PRICE, 0),
+    OPRA_FIELD(hf_opra_msg_cat_f_underlying_price_denominator_code, 1, OPRA_FIELD_NEXT_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_underlying_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_bid_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_f_offer_price, 4, OPRA_FIELD_PRICE, 0),
+};
+
+/*long quote*/
+static const opra_field_layout opra_msg_cat_k_fields[] = {
+    OPRA_FIELD(hf_opra_msg_cat_k_security_symbol, 5, OPRA_FIELD_TEXT),
+    OPRA_FIELD(hf_opra_msg_cat_k_reserved, 1, OPRA_FIELD_BYTES),
+    OPRA_FIELD(hf_opra_msg_cat_k_expiration_block, 3, OPRA_FIELD_EXPIRATION),
+    OPRA_FIELD(hf_opra_msg_cat_k_strike_price_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_k_strike_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_FIELD(hf_opra_msg_cat_k_premium_price_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_k_bid_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_FIELD(hf_opra_msg_cat_k_bid_size, 4, OPRA_FIELD_UINT),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_k_offer_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_FIELD(hf_opra_msg_cat_k_offer_size, 4, OPRA_FIELD_UINT),
+};
+
+/*short quote*/
+static const opra_field_layout opra_msg_cat_q_fields[] = {
+    OPRA_FIELD(hf_opra_msg_cat_q_security_symbol, 4, OPRA_FIELD_TEXT),
+    OPRA_FIELD(hf_opra_msg_cat_q_expiration_block, 3, OPRA_FIELD_EXPIRATION),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_q_strike_price, 2, OPRA_FIELD_UINT, _1dps),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_q_bid_price, 2, OPRA_FIELD_UINT, _2dps),
+    OPRA_FIELD(hf_opra_msg_cat_q_bid_size, 2, OPRA_FIELD_UINT),
+    OPRA_PRICE_FIELD(hf_opra_msg_cat_q_offer_price, 2, OPRA_FIELD_UINT, _2dps),
+    OPRA_FIELD(hf_opra_msg_cat_q_offer_size, 2, OPRA_FIELD_UINT),
+};
+
+/*bid/offer appendages*/
+static const opra_field_layout opra_bid_appendage_fields[] = {
+    OPRA_FIELD(hf_opra_msg_bid_appendage_participant_id, 1, OPRA_FIELD_UINT),
+    OPRA_FIELD(hf_opra_msg_bid_appendage_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_bid_appendage_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_FIELD(hf_opra_msg_bid_appendage_size, 4, OPRA_FIELD_UINT),
+};
+
+static const opra_field_layout opra_offer_appendage_fields[] = {
+    OPRA_FIELD(hf_opra_msg_offer_appendage_participant_id, 1, OPRA_FIELD_UINT),
+    OPRA_FIELD(hf_opra_msg_offer_appendage_denominator_code, 1, OPRA_FIELD_DENOMINATOR),
+    OPRA_PRICE_FIELD(hf_opra_msg_offer_appendage_price, 4, OPRA_FIELD_PRICE, 0),
+    OPRA_FIELD(hf_opra_msg_offer_appendage_size, 4, OPRA_FIELD_UINT),
+};
+
+static const opra_message_layout opra_bid_appendage_layout = OPRA_MESSAGE_LAYOUT(opra_bid_appendage_fields);
+static const opra_message_layout opra_offer_appendage_layout = OPRA_MESSAGE_LAYOUT(opra_offer_appendage_fields);
+
+/*control messages are header only.  Administrative messages are variable length and have their own dissector.*/
+static const opra_message_layout opra_empty_layout = { NULL, 0 };
+
+static const opra_message_layout opra_msg_cat_Y_layout = OPRA_MESSAGE_LAYOUT(opra_msg_cat_Y_fields);
+static const opra_message_layout opra_msg_cat_a_layout = OPRA_MESSAGE_LAYOUT(opra_msg_cat_a_fields);
+static const opra_message_layout opra_msg_cat_d_layout = OPRA_MESSAGE_LAYOUT(opra_msg_cat_d_fields);
+static const opra_message_layout opra_msg_cat_f_layout = OPRA_MESSAGE_LAYOUT(opra_msg_cat_f_fields);
+static const opra_message_layout opra_msg_cat_k_layout = OPRA_MESSAGE_LAYOUT(opra_msg_cat_k_fields);
+static const opra_message_layout opra_msg_cat_q_layout = OPRA_MESSAGE_LAYOUT(opra_msg_cat_q_fields);
+
+/*category to layout, indexed directly by the category byte*/
+static const opra_message_layout *opra_message_layouts[256] = {
+    ['H'] = &opra_empty_layout,
+    ['Y'] = &opra_msg_cat_Y_layout,
+    ['a'] = &opra_msg_cat_a_layout,
+    ['d'] = &opra_msg_cat_d_layout,
+    ['f'] = &opra_msg_cat_f_layout,
+    ['k'] = &opra_msg_cat_k_layout,
+    ['q'] = &opra_msg_cat_q_layout,
+};
+
+/*Sequence tracking.  A line is a (source, destination port, session indicator) triple.  The block sequence number
+  is the sequence number of the block's first message, so the next block on a line is expected at
+  sequence + messages in block.  Lines are walked once, on the first pass, and each frame keeps the result
+  as proto data so later dissections are a lookup.*/
+typedef struct _opra_line_key {
+    address src;
+    uint32_t dst_port;
+    uint8_t session_indicator;
+} opra_line_key;
+
+typedef struct _opra_index_line_run opra_index_line_run;
+
+typedef struct _opra_line_state {
+    uint32_t next_sequence_number;
+    uint32_t last_frame;
+    bool synchronized;              /*false until the first block, and again after a sequence number reset*/
+    opra_index_line_run *index;     /*current run while building an index*/
+} opra_line_state;
+
+typedef enum _opra_sequence_status {
+    OPRA_SEQUENCE_FIRST,            /*first block on the line or after a reset, nothing to compare against*/
+    OPRA_SEQUENCE_IN_ORDER,
+    OPRA_SEQUENCE_GAP,
+    OPRA_SEQUENCE_DUPLICATE,        /*behind the expected sequence number and not flagged as a retransmission*/
+    OPRA_SEQUENCE_RETRANSMISSION,   /*retransmitted blocks don't move the line*/
+    OPRA_SEQUENCE_RESET             /*block holds a Reset Block Sequence Number control message, the next block starts afresh*/
+} opra_sequence_status;
+
+struct _opra_sequence_info {
+    opra_sequence_status status;
+    uint32_t expected_sequence_number;
+    uint32_t gap_size;
+    uint32_t prev_block_frame;      /*previous block on the same line, 0 if none*/
+};
+
+/*proto data key for the per frame sequence result*/
+#define OPRA_PROTO_DATA_SEQUENCE 0
+
+/*A frame can hold several blocks: back to back in one datagram or recorded file, or as TCP PDUs, each dissected
+  as its own layer.  Each is numbered by its layer and its place in the tvb, the same on every pass, and its
+  per frame results are stored under that number.  A tvb holds fewer than 65536 blocks, each at least a header long.*/
+#define OPRA_BLOCK_NUMBER(pinfo, block_in_tvb) (((unsigned) (pinfo)->curr_layer_num << 16) | (block_in_tvb))
+#define OPRA_PROTO_DATA_KEY(kind, block_number) (((uint32_t) (block_number) << 1) | (kind))
+
+static unsigned opra_line_hash(const void *v)
+{
+    const opra_line_key *key = (const opra_line_key *) v;
+    return add_address_to_hash(key->dst_port ^ ((unsigned) key->session_indicator << 16), &key->src);
+}
+
+static int opra_line_equal(const void *a, const void *b)
+{
+    const opra_line_key *ka = (const opra_line_key *) a;
+    const opra_line_key *kb = (const opra_line_key *) b;
+    return (ka->dst_port == kb->dst_port) && (ka->session_indicator == kb->session_indicator) && addresses_equal(&ka->src, &kb->src);
+}
+
+/*A/B arbitration.  Every line is sent twice, on the A and B feeds.  The preferences pair the destination ports of
+  the two feeds, and the first copy of each (pair, session indicator, block sequence number) to arrive wins.
+  The other copy is marked as a duplicate and, if asked, its messages aren't decoded.*/
+typedef struct _opra_feed_pair {
+    char *line_name;
+    unsigned a_port;
+    unsigned b_port;
+} opra_feed_pair;
+
+static opra_feed_pair *opra_feed_pairs;
+static unsigned num_opra_feed_pairs;
+static bool opra_skip_duplicate_messages;
+
+/*Capture clock less exchange clock, in nanoseconds.  Taken off every latency so a known skew between the
+  exchange's clock and the capture host's doesn't show up as latency.  Kept as a string since it may be negative.*/
+static const char *opra_clock_offset_pref = "0";
+static int64_t opra_clock_offset_ns;
+
+/*Sum every block and compare it with its checksum field.  Off by default as it is a pass over every byte.*/
+static bool opra_check_checksum;
+
+/*Categories decoded in full, as lists of category characters.  An empty decode list means every category,
+  the skip list is taken out of it.  Skipped messages are stepped over by length alone: no tree, tap, instrument
+  or top of book.*/
+static const char *opra_decode_categories_pref = "";
+static const char *opra_skip_categories_pref = "";
+
+/*indexed directly by the category byte, rebuilt from the two lists when the preferences change*/
+static bool opra_category_skipped[256];
+
+/*Watchlist of roots and instrument IDs, e.g. "SPY, AAPL, 42".  When set, only messages for these get a subtree.
+  The others are still decoded for the tap and the first pass, and are counted at block level.*/
+static const char *opra_watchlist_pref = "";
+
+/*Open addressed set of watched keys, rebuilt when the preference changes.  Roots are packed big endian into the
+  low 40 bits, space padded like the wire, and instrument IDs are tagged with OPRA_WATCH_INSTRUMENT_ID.
+  0 marks an empty slot, no key can be 0.*/
+#define OPRA_WATCH_INSTRUMENT_ID (UINT64_C(1) << 63)
+
+static uint64_t *opra_watchlist;
+static unsigned opra_watchlist_mask;        /*slots - 1, the slot count is a power of two*/
+static unsigned opra_watchlist_ids;         /*instrument IDs in the set, roots alone never need the instrument*/
+
+/*destination port to ((pair index << 1) | is B feed) + 1, 0 for ports not in a pair.  Rebuilt when the table changes.*/
+static uint16_t opra_feed_port_lookup[65536];
+
+#define OPRA_MAX_FEED_PAIRS 32767
+
+/*zero filled with no padding, opra_table compares keys as bytes*/
+typedef struct _opra_arbitration_key {
+    uint32_t block_sequence_number;
+    uint16_t pair;
+    uint8_t session_indicator;
+    uint8_t reserved;
+} opra_arbitration_key;
+
+struct _opra_arbitration_info {
+    uint16_t pair;
+    uint8_t feed;                   /*'A' or 'B'*/
+    bool duplicate;                 /*the other feed's copy arrived first*/
+    uint32_t other_frame;           /*frame holding the other feed's copy, 0 if it hasn't been seen*/
+    int64_t delta_ns;               /*B arrival less A arrival, only valid with other_frame*/
+    uint32_t frame;                 /*first pass only, for the other feed's copy to refer back to*/
+    nstime_t arrival;
+};
+
+/*proto data key for the per frame arbitration result*/
+#define OPRA_PROTO_DATA_ARBITRATION 1
+
+/*(pair, session, sequence) to the winning frame's opra_arbitration_info.  The other feed's copy follows within
+  moments, so only the most recent OPRA_ARBITRATION_WINDOW first copies are kept, in a ring whose oldest entry
+  leaves the table when a new one takes its place.  A copy arriving later than that is taken as a first copy.
+  Emptied when the capture file is closed.*/
+#define OPRA_ARBITRATION_WINDOW 262144
+
+typedef struct _opra_arbitration_entry {
+    opra_arbitration_key key;
+    opra_arbitration_info *info;        /*NULL while the ring slot is unused*/
+} opra_arbitration_entry;
+
+UAT_CSTRING_CB_DEF(opra_feed_pairs, line_name, opra_feed_pair)
+UAT_DEC_CB_DEF(opra_feed_pairs, a_port, opra_feed_pair)
+UAT_DEC_CB_DEF(opra_feed_pairs, b_port, opra_feed_pair)
+
+static void *opra_feed_pair_copy_cb(void *dest, const void *orig, size_t len _U_)
+{
+    const opra_feed_pair *o = (const opra_feed_pair *) orig;
+    opra_feed_pair *d = (opra_feed_pair *) dest;
+
+    d->line_name = g_strdup(o->line_name);
+    d->a_port = o->a_port;
+    d->b_port = o->b_port;
+    return d;
+}
+
+static bool opra_feed_pair_update_cb(void *r, char **err)
+{
+    const opra_feed_pair *rec = (const opra_feed_pair *) r;
+
+    if ((0 == rec->a_port) || (rec->a_port > 65535) || (0 == rec->b_port) || (rec->b_port > 65535)){
+        *err = g_strdup("Ports must be between 1 and 65535");
+        return false;
+    }
+    if (rec->a_port == rec->b_port){
+        *err = g_strdup("The A and B feeds must use different ports");
+        return false;
+    }
+    return true;
+}
+
+static void opra_feed_pair_free_cb(void *r)
+{
+    opra_feed_pair *rec = (opra_feed_pair *) r;
+    g_free(rec->line_name);
+}
+
+static void opra_feed_pair_post_update_cb(void)
+{
+    memset(opra_feed_port_lookup, 0, sizeof(opra_feed_port_lookup));
+
+    for (unsigned i = 0; (i < num_opra_feed_pairs) && (i < OPRA_MAX_FEED_PAIRS); i++){
+        opra_feed_port_lookup[opra_feed_pairs[i].a_port] = (uint16_t) ((i << 1) + 1);
+        opra_feed_port_lookup[opra_feed_pairs[i].b_port] = (uint16_t) ((i << 1) + 2);
+    }
+}
+
+/*Instrument interning.  Each distinct (root, expiration, strike) gets a dense ID, from 1 in the order the first
+  pass meets them, so one series can be filtered on with an integer compare.  The display name is built the
+  first time an instrument is shown and kept with it.
+  Each instrument also keeps its top of book history, one row per change in capture order, binary searched for
+  the row in force at any message so no frame needs the book replayed.*/
+
+/*a message's place in the capture, blocks hold at most 255 messages*/
+#define OPRA_BOOK_POSITION(frame, block_number, index) (((uint64_t) (frame) << 32) | ((uint64_t) (block_number) << 8) | (index))
+#define OPRA_BOOK_POSITION_FRAME(position) ((uint32_t) ((position) >> 32))
+
+struct _opra_instrument {
+    opra_instrument_key key;        /*first, opra_table takes a record's key from its start*/
+    uint32_t id;
+    const char *name;               /*NULL until first needed, see opra_instrument_name()*/
+    opra_expiration expiration;     /*the key's expiration block decoded, once per series rather than per message*/
+    bool has_book;                  /*the first pass has applied a quote*/
+    opra_book_top top;              /*as of the last quote the first pass applied*/
+    opra_book_history book;
+    opra_lru_link book_lru;         /*in opra_capture.book_lru while the history holds rows*/
+    wmem_array_t *index_ranges;     /*opra_index_range, frames of the instrument's messages while building an index*/
+    uint32_t index_messages;
+    const opra_index_instrument *indexed;   /*entry in the mapped index, NULL until looked up or if absent*/
+    bool index_looked_up;
+};
+
+/*Everything the decode carries from one block to the next, for one capture file: sequence tracking, A/B
+  arbitration, instruments and their books.  It is all here rather than in statics scattered through the file, set
+  up by opra_state_init() when a file is opened and freed by opra_state_cleanup() when it is closed, so nothing
+  outlives its file and nothing else holds decode state.  Wireshark dissects one file per process, so there is one
+  instance; a pipeline that splits a capture dissects each piece in its own process and merges the pieces'
+  summaries, see opra-summary.h.
+  State that grows with the capture lives outside wmem, so that it can be counted, capped and given back piecemeal:
+  instruments, their names and index entries come from one arena, book history chunks from a pool over it.  When
+  the histories pass the memory limit, those of the least recently used instruments are given back.  Their
+  instruments keep their IDs and current top of book, so later quotes start a new history, and messages from before
+  show that theirs was evicted.  The lines and the per frame results stay in wmem, they grow with the number of
+  lines and frames, which Wireshark keeps anyway.*/
+typedef struct _opra_capture_state {
+    wmem_map_t *lines;                          /*line key to opra_line_state, emptied when the capture file is closed*/
+    opra_table arbitration;
+    opra_arbitration_entry *arbitration_window; /*allocated with the first A/B block*/
+    unsigned arbitration_next;                  /*ring slot to fill next*/
+    uint64_t arbitration_evicted;
+    opra_arena arena;
+    opra_pool book_chunk_pool;
+    opra_table instruments;                     /*opra_instrument_key to opra_instrument*/
+    opra_lru book_lru;
+    size_t book_bytes;                          /*chunk lists and chunks in use of every history, see opra_book_history_bytes()*/
+    uint64_t book_evicted;                      /*histories given back*/
+    unsigned instrument_name_count;
+    size_t instrument_name_bytes;
+    opra_summary *summary;                      /*built by the first pass when a summary file is set, NULL otherwise*/
+} opra_capture_state;
+
+static opra_capture_state opra_capture;
+
+/*limit on the top of book histories, in MiB, 0 for none*/
+static unsigned opra_book_memory_limit = 1024;
+
+/*Mergeable summary of the capture, written after the first pass, see opra-summary.h*/
+static const char *opra_summary_file_pref = "";
+
+static inline bool opra_summary_enabled(void)
+{
+    return (NULL != opra_summary_file_pref) && ('\0' != opra_summary_file_pref[0]);
+}
+
+#define OPRA_INSTRUMENT_TABLE_INITIAL_SLOTS 4096
+#define OPRA_ARBITRATION_TABLE_INITIAL_SLOTS 4096
+
+static void opra_state_init(void)
+{
+    opra_arena_init(&opra_capture.arena);
+    opra_pool_init(&opra_capture.book_chunk_pool, &opra_capture.arena, sizeof(opra_book_chunk));
+    opra_table_init(&opra_capture.instruments, sizeof(opra_instrument_key), OPRA_INSTRUMENT_TABLE_INITIAL_SLOTS);
+    opra_table_init(&opra_capture.arbitration, sizeof(opra_arbitration_key), OPRA_ARBITRATION_TABLE_INITIAL_SLOTS);
+    opra_lru_init(&opra_capture.book_lru);
+    opra_capture.book_bytes = 0;
+    opra_capture.book_evicted = 0;
+    opra_capture.instrument_name_count = 0;
+    opra_capture.instrument_name_bytes = 0;
+    opra_capture.arbitration_window = NULL;
+    opra_capture.arbitration_next = 0;
+    opra_capture.arbitration_evicted = 0;
+#ifdef OPRA_PERF
+    opra_perf_reset();
+#endif
+
+    opra_capture.summary = NULL;
+    if (opra_summary_enabled()){
+        opra_capture.summary = g_new(opra_summary, 1);
+        if (!opra_summary_init(opra_capture.summary)){
+            opra_summary_free(opra_capture.summary);
+            g_free(opra_capture.summary);
+            opra_capture.summary = NULL;
+        }
+    }
+}
+
+static void opra_state_free_summary(void)
+{
+    if (NULL == opra_capture.summary)
+        return;
+    opra_summary_free(opra_capture.summary);
+    g_free(opra_capture.summary);
+    opra_capture.summary = NULL;
+}
+
+/*chunk lists are malloc'd per history, the rest goes with the arena*/
+static void opra_state_free_book(void *record, void *user_data _U_)
+{
+    opra_instrument *instrument = (opra_instrument *) record;
+    opra_book_history_release(&instrument->book, &opra_capture.book_chunk_pool);
+}
+
+static void opra_state_cleanup(void)
+{
+    opra_table_foreach(&opra_capture.instruments, opra_state_free_book, NULL);
+    opra_table_free(&opra_capture.instruments);
+    opra_table_free(&opra_capture.arbitration);
+    g_free(opra_capture.arbitration_window);
+    opra_capture.arbitration_window = NULL;
+    opra_arena_free_all(&opra_capture.arena);
+    opra_lru_init(&opra_capture.book_lru);
+    opra_state_free_summary();
+}
+
+static inline opra_instrument *opra_book_lru_instrument(opra_lru_link *link)
+{
+    return (opra_instrument *) ((char *) link - offsetof(opra_instrument, book_lru));
+}
+
+/*give back the least recently used histories until the rest fit in the limit, keeping the one being added to*/
+static void opra_book_enforce_limit(const opra_instrument *keep)
+{
+    if (0 == opra_book_memory_limit)
+        return;
+
+    const size_t limit = (size_t) opra_book_memory_limit * 1024 * 1024;
+    opra_lru_link *link;
+    while ((opra_capture.book_bytes > limit) && (NULL != (link = opra_lru_oldest(&opra_capture.book_lru)))){
+        opra_instrument *instrument = opra_book_lru_instrument(link);
+        if (instrument == keep)
+            break;
+        opra_lru_remove(link);
+        opra_capture.book_bytes -= opra_book_history_bytes(&instrument->book);
+        opra_book_history_release(&instrument->book, &opra_capture.book_chunk_pool);
+        opra_capture.book_evicted++;
+    }
+}
+
+/*After the first pass, write the summary it built.  The later passes don't add to it, so it goes once written.*/
+static void opra_summary_write_file(void)
+{
+    if (NULL == opra_capture.summary)
+        return;
+
+    size_t size;
+    uint8_t *buf = opra_summary_write(opra_capture.summary, &size);
+    if (NULL == buf){
+        report_failure("Can't write the OPRA summary file \"%s\": out of memory", opra_summary_file_pref);
+    } else {
+        GError *err = NULL;
+        if (!g_file_set_contents(opra_summary_file_pref, (const char *) buf, (gssize) size, &err)){
+            report_failure("Can't write the OPRA summary file \"%s\": %s", opra_summary_file_pref, err->message);
+            g_error_free(err);
+        }
+        free(buf);
+    }
+    opra_state_free_summary();
+}
+
+/*short month names for instrument names, see opra_expiration_month_table for the codes*/
+static const char *opra_expiration_months[12] = {
+    "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+/*Sidecar index, see opra-index.h.  With a file named in the preferences, the first pass records the frames of
+  every instrument's messages and each line's sequence runs, and writes them out once the pass is over.  On the
+  next open of the capture the file is mapped instead, and each instrument shows its neighbouring frames.
+  The name comes from the preferences since dissectors aren't told which capture file they are reading.*/
+static const char *opra_index_file_pref = "";
+
+static GMappedFile *opra_index_mapping;
+static opra_index opra_index_mapped;            /*valid while opra_index_mapping is set*/
+static bool opra_index_checked;                 /*the mapped index has been matched with the capture's first OPRA frame*/
+static bool opra_index_building;                /*first pass is recording a new index*/
+static opra_index_header opra_index_build_header;
+static wmem_array_t *opra_index_runs;           /*opra_index_line_run *, in the order the runs started*/
+
+/*a line's sequence run while it is being recorded*/
+struct _opra_index_line_run {
+    opra_index_line line;
+    wmem_array_t *checkpoints;                  /*opra_index_checkpoint*/
+    uint32_t blocks_since_checkpoint;
+};
+
+static inline bool opra_index_enabled(void)
+{
+    return (NULL != opra_index_file_pref) && ('\0' != opra_index_file_pref[0]);
+}
+
+static void opra_index_unmap(void)
+{
+    if (NULL != opra_index_mapping)
+        g_mapped_file_unref(opra_index_mapping);
+    opra_index_mapping = NULL;
+    memset(&opra_index_mapped, 0, sizeof(opra_index_mapped));
+}
+
+/*A missing or unreadable file isn't an error, the first pass writes a new one*/
+static bool opra_index_map(const char *path)
+{
+    GMappedFile *mapping = g_mapped_file_new(path, false, NULL);
+    if (NULL == mapping)
+        return false;
+
+    if (!opra_index_open(&opra_index_mapped, (const uint8_t *) g_mapped_file_get_contents(mapping), g_mapped_file_get_length(mapping))){
+        g_mapped_file_unref(mapping);
+        return false;
+    }
+    opra_index_mapping = mapping;
+    return true;
+}
+
+static void opra_index_start_building(void)
+{
+    opra_index_unmap();
+    opra_index_building = true;
+    memset(&opra_index_build_header, 0, sizeof(opra_index_build_header));
+    opra_index_runs = wmem_array_new(wmem_file_scope(), sizeof(opra_index_line_run *));
+}
+
+static void opra_index_init(void)
+{
+    opra_index_checked = false;
+    opra_index_building = false;
+    opra_index_runs = NULL;
+    opra_index_unmap();
+
+    if (opra_index_enabled() && !opra_index_map(opra_index_file_pref))
+        opra_index_start_building();
+}
+
+static void opra_index_cleanup(void)
+{
+    opra_index_building = false;
+    opra_index_runs = NULL;
+    opra_index_unmap();
+}
+
+/*First pass, every block.  A mapped index must start at the same frame and time as the capture, otherwise it
+  belongs to another capture and is rebuilt.*/
+static void opra_index_note_frame(const packet_info *pinfo)
+{
+    if ((NULL != opra_index_mapping) && !opra_index_checked){
+        const opra_index_header *hdr = &opra_index_mapped.hdr;
+        opra_index_checked = true;
+        if ((hdr->first_frame != pinfo->num) || (hdr->first_frame_secs != (uint64_t) pinfo->abs_ts.secs) || (hdr->first_frame_nsecs != (uint32_t) pinfo->abs_ts.nsecs))
+            opra_index_start_building();
+    }
+    if (!opra_index_building)
+        return;
+
+    opra_index_header *hdr = &opra_index_build_header;
+    if (0 == hdr->first_frame){
+        hdr->first_frame = pinfo->num;
+        hdr->first_frame_secs = (uint64_t) pinfo->abs_ts.secs;
+        hdr->first_frame_nsecs = (uint32_t) pinfo->abs_ts.nsecs;
+    }
+    hdr->last_frame = pinfo->num;
+}
+
+/*First pass, every block once its line has been worked out.  Retransmissions and duplicates don't move the line
+  and are left out of its runs.*/
+static void opra_index_note_block(opra_line_state *line, const opra_line_key *key, opra_sequence_status status,
+    const opra_block_header *hdr, uint32_t frame)
+{
+    if ((OPRA_SEQUENCE_RETRANSMISSION == status) || (OPRA_SEQUENCE_DUPLICATE == status))
+        return;
+
+    opra_index_line_run *run = line->index;
+    bool checkpoint = (OPRA_SEQUENCE_GAP == status);
+    if ((NULL == run) || (OPRA_SEQUENCE_FIRST == status)){
+        run = wmem_new0(wmem_file_scope(), opra_index_line_run);
+        run->checkpoints = wmem_array_new(wmem_file_scope(), sizeof(opra_index_checkpoint));
+        if (((AT_IPv4 == key->src.type) || (AT_IPv6 == key->src.type)) && (key->src.len <= OPRA_INDEX_MAX_ADDRESS_SIZE)){
+            run->line.address_length = (uint8_t) key->src.len;
+            memcpy(run->line.src, key->src.data, key->src.len);
+        }
+        run->line.dst_port = (uint16_t) key->dst_port;
+        run->line.session_indicator = key->session_indicator;
+        run->line.first_sequence = hdr->block_sequence_number;
+        run->line.first_frame = frame;
+        wmem_array_append_one(opra_index_runs, run);
+        opra_index_build_header.line_count++;
+        line->index = run;
+        checkpoint = true;
+    }
+
+    if (checkpoint || (run->blocks_since_checkpoint >= OPRA_INDEX_CHECKPOINT_INTERVAL)){
+        opra_index_checkpoint entry = { hdr->block_sequence_number, frame };
+        wmem_array_append_one(run->checkpoints, entry);
+        opra_index_build_header.checkpoint_count++;
+        run->blocks_since_checkpoint = 0;
+    }
+    run->blocks_since_checkpoint++;
+    run->line.block_count++;
+    run->line.last_frame = frame;
+    run->line.last_sequence = hdr->block_sequence_number + ((0 != hdr->messages_in_block) ? hdr->messages_in_block - 1U : 0);
+}
+
+/*First pass, every interned message.  A frame next to the instrument's last range extends it, so a range
+  holds exactly the frames with its messages.*/
+static void opra_index_note_message(opra_instrument *instrument, uint32_t frame)
+{
+    if (NULL == instrument->index_ranges)
+        instrument->index_ranges = wmem_array_new(wmem_file_scope(), sizeof(opra_index_range));
+    instrument->index_messages++;
+
+    const unsigned count = wmem_array_get_count(instrument->index_ranges);
+    if (count > 0){
+        opra_index_range *last = (opra_index_range *) wmem_array_index(instrument->index_ranges, count - 1);
+        if (frame <= last->last_frame + 1){
+            if (frame > last->last_frame)
+                last->last_frame = frame;
+            return;
+        }
+    }
+    opra_index_range range = { frame, frame };
+    wmem_array_append_one(instrument->index_ranges, range);
+    opra_index_build_header.range_count++;
+}
+
+static void opra_index_collect_instrument(void *record, void *user_data)
+{
+    opra_instrument *instrument = (opra_instrument *) record;
+    if (NULL != instrument->index_ranges)
+        g_ptr_array_add((GPtrArray *) user_data, instrument);
+}
+
+static int opra_index_instrument_order(const void *a, const void *b)
+{
+    const opra_instrument *ia = *(const opra_instrument * const *) a;
+    const opra_instrument *ib = *(const opra_instrument * const *) b;
+    return opra_index_compare_keys(&ia->key, &ib->key);
+}
+
+/*After the first pass, write what it recorded and map it for the later passes*/
+static void opra_index_write(void)
+{
+    if (!opra_index_building)
+        return;
+    opra_index_building = false;
+
+    GPtrArray *instruments = g_ptr_array_new();
+    opra_table_foreach(&opra_capture.instruments, opra_index_collect_instrument, instruments);
+    g_ptr_array_sort(instruments, opra_index_instrument_order);
+
+    opra_index_header *hdr = &opra_index_build_header;
+    hdr->version = OPRA_INDEX_VERSION;
+    hdr->instrument_count = instruments->len;
+    const size_t size = opra_index_size(hdr);
+    uint8_t *buf = (uint8_t *) g_malloc0(size);
+    opra_index_put_header(buf, hdr);
+
+    uint32_t next_range = 0;
+    for (unsigned i = 0; i < instruments->len; i++){
+        const opra_instrument *instrument = (const opra_instrument *) g_ptr_array_index(instruments, i);
+        const unsigned range_count = wmem_array_get_count(instrument->index_ranges);
+        opra_index_instrument entry;
+        entry.key = instrument->key;
+        entry.instrument_id = instrument->id;
+        entry.message_count = instrument->index_messages;
+        entry.first_range = next_range;
+        entry.range_count = range_count;
+        opra_index_put_instrument(buf, i, &entry);
+        for (unsigned r = 0; r < range_count; r++)
+            opra_index_put_range(buf, hdr, next_range++, (const opra_index_range *) wmem_array_index(instrument->index_ranges, r));
+    }
+    g_ptr_array_free(instruments, true);
+
+    uint32_t next_checkpoint = 0;
+    for (unsigned i = 0; i < wmem_array_get_count(opra_index_runs); i++){
+        opra_index_line_run *run = *(opra_index_line_run **) wmem_array_index(opra_index_runs, i);
+        const unsigned checkpoint_count = wmem_array_get_count(run->checkpoints);
+        run->line.first_checkpoint = next_checkpoint;
+        run->line.checkpoint_count = checkpoint_count;
+        opra_index_put_line(buf, hdr, i, &run->line);
+        for (unsigned c = 0; c < checkpoint_count; c++)
+            opra_index_put_checkpoint(buf, hdr, next_checkpoint++, (const opra_index_checkpoint *) wmem_array_index(run->checkpoints, c));
+    }
+
+    GError *err = NULL;
+    if (!g_file_set_contents(opra_index_file_pref, (const char *) buf, (gssize) size, &err)){
+        report_failure("Can't write the OPRA index file \"%s\": %s", opra_index_file_pref, err->message);
+        g_error_free(err);
+    } else if (opra_index_map(opra_index_file_pref)){
+        opra_index_checked = true;
+    }
+    g_free(buf);
+}
+
+/*the instrument's entry in the mapped index, looked up once per instrument*/
+static const opra_index_instrument *opra_index_lookup_instrument(opra_instrument *instrument)
+{
+    if (NULL == opra_index_mapping)
+        return NULL;
+
+    if (!instrument->index_looked_up){
+        opra_index_instrument entry;
+        instrument->index_looked_up = true;
+        if (opra_index_find_instrument(&opra_index_mapped, &instrument->key, &entry)){
+            opra_index_instrument *indexed = (opra_index_instrument *) opra_arena_alloc(&opra_capture.arena, sizeof(entry));
+            if (NULL != indexed)
+                *indexed = entry;
+            instrument->indexed = indexed;
+        }
+    }
+    return instrument->indexed;
+}
+
 /*registration*/
 void proto_register_opra(void)
 {
@@ -482,6 +1540,60 @@ void proto_register_opra(void)
             { "opra.block_length_error",
             PI_DEBUG, PI_WARN,
             "block length length doesn't match buffer bytes", EXPFILL}
+        },
+        {
+            &hf_opra_exp_block_truncated,
+            { "opra.block_truncated",
+            PI_MALFORMED, PI_ERROR,
+            "block truncated, message extends past the end of the captured data", EXPFILL}
+        },
+        {
+            &hf_opra_exp_sequence_gap,
+            { "opra.sequence_gap",
+            PI_SEQUENCE, PI_WARN,
+            "block sequence gap, messages missing on this line", EXPFILL}
+        },
+        {
+            &hf_opra_exp_sequence_duplicate,
+            { "opra.sequence_duplicate",
+            PI_SEQUENCE, PI_NOTE,
+            "block sequence number already seen on this line", EXPFILL}
+        },
+        {
+            &hf_opra_exp_sequence_reset,
+            { "opra.sequence_reset",
+            PI_SEQUENCE, PI_CHAT,
+            "block sequence number reset", EXPFILL}
+        },
+        {
+            &hf_opra_exp_feed_duplicate,
+            { "opra.feed_duplicate",
+            PI_SEQUENCE, PI_CHAT,
+            "block already received on the other feed", EXPFILL}
+        },
+        {
+            &hf_opra_exp_unknown_category,
+            { "opra.unknown_category",
+            PI_UNDECODED, PI_WARN,
+            "unknown message category", EXPFILL}
+        },
+        {
+            &hf_opra_exp_checksum_bad,
+            { "opra.checksum.bad",
+            PI_CHECKSUM, PI_ERROR,
+            "block checksum doesn't match the block, corrupted in capture or on the feed", EXPFILL}
+        },
+        {
+            &hf_opra_exp_book_evicted,
+            { "opra.book.evicted",
+            PI_UNDECODED, PI_NOTE,
+            "top of book history evicted to stay within the memory limit", EXPFILL}
+        },
+        {
+            &hf_opra_exp_unknown_length_guessed,
+            { "opra.unknown_length_guessed",
+            PI_UNDECODED, PI_NOTE,
+            "length of the unknown category message guessed, the shortest that lets the messages after it fill the block", EXPFILL}
         }
     };
 
@@ -554,6 +1666,13 @@ void proto_register_opra(void)
                 NULL, 0x0,
                 NULL, HFILL }
         },
+        {
+            &hf_opra_block_checksum_status,
+            {   "OPRA Block Checksum Status", "opra.checksum.status",
+                FT_UINT8, BASE_NONE,
+                VALS(proto_checksum_vals), 0x0,
+                NULL, HFILL }
+        },
         {
             &hf_opra_block_pad_byte,
             {   "OPRA Block Pad Byte", "opra.block_pad_byte",
@@ -561,15 +1680,226 @@ void proto_register_opra(void)
                 NULL, 0x0,
                 NULL, HFILL }
         },
-        /*Message Header*/
-        {   &hf_opra_msg_hdr_participant_id,
-            {   "Participant ID", "opra.msg_hdr.participant_id",
-                FT_CHAR, BASE_HEX,
-                VALS(hf_opra_participant_ids), 0x0,
-                NULL, HFILL }
-        },
+        /*sequence tracking, generated*/
         {
-            &hf_opra_msg_hdr_message_category,
+            &hf_opra_expected_sequence_number,
+            {   "Expected Block Sequence Number", "opra.expected_sequence_number",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                "Sequence number the previous block on this line implies", HFILL }
+        },
+        {
+            &hf_opra_gap_size,
+            {   "Gap Size", "opra.gap_size",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                "Messages missing on this line before this block", HFILL }
+        },
+        {
+            &hf_opra_prev_block_frame,
+            {   "Previous Block Frame", "opra.prev_block_frame",
+                FT_FRAMENUM, BASE_NONE,
+                NULL, 0x0,
+                "Frame holding the previous block on this line", HFILL }
+        },
+        /*A/B feed arbitration, generated*/
+        {
+            &hf_opra_feed,
+            {   "Feed", "opra.feed",
+                FT_CHAR, BASE_HEX,
+                VALS(hf_opra_feeds), 0x0,
+                "Which feed of an A/B pair the block arrived on", HFILL }
+        },
+        {
+            &hf_opra_feed_line,
+            {   "Feed Line", "opra.feed_line",
+                FT_STRING, BASE_NONE,
+                NULL, 0x0,
+                "Line name of the A/B pair", HFILL }
+        },
+        {
+            &hf_opra_feed_duplicate,
+            {   "Duplicate", "opra.feed_duplicate_copy",
+                FT_BOOLEAN, BASE_NONE,
+                NULL, 0x0,
+                "The other feed's copy of this block arrived first", HFILL }
+        },
+        {
+            &hf_opra_feed_other_frame,
+            {   "Other Feed Frame", "opra.feed_other_frame",
+                FT_FRAMENUM, BASE_NONE,
+                FRAMENUM_TYPE(FT_FRAMENUM_DUP_ACK), 0x0,
+                "Frame holding the other feed's copy of this block", HFILL }
+        },
+        {
+            &hf_opra_feed_delta,
+            {   "A/B Delta (ns)", "opra.feed_delta",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "B feed arrival less A feed arrival, in nanoseconds", HFILL }
+        },
+        /*category filter, generated*/
+        {
+            &hf_opra_skipped_messages,
+            {   "Skipped Messages", "opra.skipped_messages",
+                FT_UINT8, BASE_DEC,
+                NULL, 0x0,
+                "Messages of categories the preferences don't decode", HFILL }
+        },
+        {
+            &hf_opra_unwatched_messages,
+            {   "Messages Not Watched", "opra.unwatched_messages",
+                FT_UINT8, BASE_DEC,
+                NULL, 0x0,
+                "Messages decoded but not shown, they aren't on the watchlist", HFILL }
+        },
+        /*exchange to capture latency, generated*/
+        {
+            &hf_opra_latency,
+            {   "Latency (ns)", "opra.latency",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Frame capture time less block timestamp and the clock offset preference, in nanoseconds", HFILL }
+        },
+        /*instrument interning, generated*/
+        {
+            &hf_opra_instrument_id,
+            {   "Instrument ID", "opra.instrument_id",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                "Capture wide ID of the option series: root, expiration, strike and put or call", HFILL }
+        },
+        {
+            &hf_opra_instrument,
+            {   "Instrument", "opra.instrument",
+                FT_STRING, BASE_NONE,
+                NULL, 0x0,
+                "Option series as root, expiration, strike and put or call", HFILL }
+        },
+        /*decoded expiration block*/
+        {
+            &hf_opra_expiration_month,
+            {   "Expiration Month", "opra.expiration.month",
+                FT_UINT8, BASE_DEC,
+                VALS(hf_opra_expiration_months), 0x0,
+                "Month of the expiration month code", HFILL }
+        },
+        {
+            &hf_opra_expiration_put_call,
+            {   "Put/Call", "opra.expiration.put_call",
+                FT_CHAR, BASE_HEX,
+                VALS(hf_opra_put_call), 0x0,
+                "Put or call, carried by the expiration month code", HFILL }
+        },
+        {
+            &hf_opra_expiration_day,
+            {   "Expiration Day", "opra.expiration.day",
+                FT_UINT8, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_expiration_year,
+            {   "Expiration Year", "opra.expiration.year",
+                FT_UINT16, BASE_DEC,
+                NULL, 0x0,
+                "The block's two digit year from 2000", HFILL }
+        },
+        {
+            &hf_opra_expiration_date,
+            {   "Expiration Date", "opra.expiration.date",
+                FT_ABSOLUTE_TIME, ABSOLUTE_TIME_UTC,
+                NULL, 0x0,
+                "Start of the expiration day, UTC", HFILL }
+        },
+        {
+            &hf_opra_expiration_days,
+            {   "Days To Expiration", "opra.expiration.days",
+                FT_INT32, BASE_DEC,
+                NULL, 0x0,
+                "Days from the block timestamp's UTC date to expiration, 0 for same day expiry", HFILL }
+        },
+        /*sidecar index lookups, generated*/
+        {
+            &hf_opra_instrument_prev_frame,
+            {   "Previous Message In", "opra.instrument.prev_frame",
+                FT_FRAMENUM, BASE_NONE,
+                NULL, 0x0,
+                "Previous frame with a message for this instrument, from the index file", HFILL }
+        },
+        {
+            &hf_opra_instrument_next_frame,
+            {   "Next Message In", "opra.instrument.next_frame",
+                FT_FRAMENUM, BASE_NONE,
+                NULL, 0x0,
+                "Next frame with a message for this instrument, from the index file", HFILL }
+        },
+        {
+            &hf_opra_instrument_messages,
+            {   "Messages In Capture", "opra.instrument.messages",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                "Messages for this instrument in the whole capture, from the index file", HFILL }
+        },
+        /*top of book, generated*/
+        {
+            &hf_opra_book_frame,
+            {   "Book Changed In", "opra.book.frame",
+                FT_FRAMENUM, BASE_NONE,
+                NULL, 0x0,
+                "Frame holding the quote that last changed this instrument's best bid or offer", HFILL }
+        },
+        {
+            &hf_opra_book_bid_participant_id,
+            {   "Best Bid Participant ID", "opra.book.bid_participant_id",
+                FT_CHAR, BASE_HEX,
+                VALS(hf_opra_participant_ids), 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_book_bid_price,
+            {   "Best Bid Price", "opra.book.bid_price",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_book_bid_size,
+            {   "Best Bid Size", "opra.book.bid_size",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_book_offer_participant_id,
+            {   "Best Offer Participant ID", "opra.book.offer_participant_id",
+                FT_CHAR, BASE_HEX,
+                VALS(hf_opra_participant_ids), 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_book_offer_price,
+            {   "Best Offer Price", "opra.book.offer_price",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_book_offer_size,
+            {   "Best Offer Size", "opra.book.offer_size",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        /*Message Header*/
+        {   &hf_opra_msg_hdr_participant_id,
+            {   "Participant ID", "opra.msg_hdr.participant_id",
+                FT_CHAR, BASE_HEX,
+                VALS(hf_opra_participant_ids), 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_hdr_message_category,
             {   "Message Category", "opra.msg_hdr.message_category",
                 FT_CHAR, BASE_HEX,
                 VALS(hf_opra_message_categories), 0x0,
@@ -613,14 +1943,29 @@ void proto_register_opra(void)
                 NULL, HFILL }
         },
         {
-            /*The combination of FT_CHAR, BASE_HEX works to display the character instead of a hex code.  Dissect using ENC_BIG_ENDIAN for consistency.*/
             &hf_opra_msg_cat_C_data,
             {   "Data", "opra.msg_cat_C.data",
-                FT_CHAR, BASE_HEX,
+                FT_STRING, BASE_NONE,
                 NULL, 0x0,
                 NULL, HFILL }
         },
 
+        /*Unknown Category Message*/
+        {
+            &hf_opra_msg_unknown_data,
+            {   "Undecoded Data", "opra.msg_unknown.data",
+                FT_BYTES, BASE_NONE,
+                NULL, 0x0,
+                "Body of a message of unknown category", HFILL }
+        },
+        {
+            &hf_opra_msg_unknown_length,
+            {   "Guessed Message Length", "opra.msg_unknown.length",
+                FT_UINT16, BASE_DEC,
+                NULL, 0x0,
+                "Length of a message of unknown category including its header, from the messages that follow it", HFILL }
+        },
+
         /*control message has no fields, only header info*/
 
         /*underlying value*/
@@ -776,11 +2121,126 @@ void proto_register_opra(void)
                 NULL, HFILL }
         },
 
-
-
-
-
-
+        /*End of Day Summary Message*/
+        {
+            &hf_opra_msg_cat_f_security_symbol,
+            {   "Security Symbol", "opra.msg_cat_f.security_symbol",
+                FT_STRING, BASE_NONE,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_reserved,
+            {   "Reserved", "opra.msg_cat_f.reserved",
+                FT_BYTES, BASE_NONE,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_expiration_block,
+            {   "Expiration Block", "opra.msg_cat_f.expiration_block",
+                FT_BYTES, BASE_NONE,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_strike_price_denominator_code,
+            {   "Strike Price Denominator Code", "opra.msg_cat_f.strike_price_denominator_code",
+                FT_CHAR, BASE_HEX,
+                VALS(hf_opra_denominator_codes), 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_strike_price,
+            {   "Strike Price", "opra.msg_cat_f.strike_price",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_volume,
+            {   "Volume", "opra.msg_cat_f.volume",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_open_interest,
+            {   "Open Interest", "opra.msg_cat_f.open_interest",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_premium_price_denominator_code,
+            {   "Premium Price Denominator Code", "opra.msg_cat_f.premium_price_denominator_code",
+                FT_CHAR, BASE_HEX,
+                VALS(hf_opra_denominator_codes), 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_open_price,
+            {   "Open Price", "opra.msg_cat_f.open_price",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_high_price,
+            {   "High Price", "opra.msg_cat_f.high_price",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_low_price,
+            {   "Low Price", "opra.msg_cat_f.low_price",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_last_price,
+            {   "Last Price", "opra.msg_cat_f.last_price",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_net_change,
+            {   "Net Change", "opra.msg_cat_f.net_change",
+                FT_INT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_underlying_price_denominator_code,
+            {   "Underlying Price Denominator Code", "opra.msg_cat_f.underlying_price_denominator_code",
+                FT_CHAR, BASE_HEX,
+                VALS(hf_opra_denominator_codes), 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_underlying_price,
+            {   "Underlying Price", "opra.msg_cat_f.underlying_price",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_bid_price,
+            {   "Bid Price", "opra.msg_cat_f.bid_price",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_offer_price,
+            {   "Offer Price", "opra.msg_cat_f.offer_price",
+                FT_UINT32, BASE_DEC,
+                NULL, 0x0,
+                NULL, HFILL }
+        },
 
         /*Long Quote Message*/
         {
@@ -961,183 +2421,2386 @@ void proto_register_opra(void)
                 NULL, 0x0,
                 NULL, HFILL }
         },
-    };
-
-    /*protocol subtree array*/
-    static int *ett[] = {
-        &ett_opra,
-        &ett_opra_message_header
-    };
-
-    proto_opra = proto_register_protocol("OPRA protocol", "OPRA", "opra");
-    proto_register_field_array(proto_opra, hf, array_length(hf));
-    proto_register_subtree_array(ett, array_length(ett));
-
-    expert_opra = expert_register_protocol(proto_opra);
-    expert_register_field_array(expert_opra, ei, array_length(ei));
-}
-
-void proto_reg_handoff_opra(void)
-{
-    static dissector_handle_t opra_handle;
-    static range_t range = {1, {{OPRA_UDP_PORT_MIN, OPRA_UDP_PORT_MAX}}};
-
-    opra_handle = create_dissector_handle(dissect_opra, proto_opra);
-    dissector_add_uint_range("udp.port", &range, opra_handle);
-}
-
-static int dissect_opra(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
-{
-    /*set protocol column*/
-    col_set_str(pinfo->cinfo, COL_PROTOCOL, "OPRA");
-
-    /*clear info column*/
-    col_clear(pinfo->cinfo, COL_INFO);
-
-    /*0, -1 means we consume all the remaining tvb*/
-    proto_item *ti = proto_tree_add_item(tree, proto_opra, tvb, 0, -1, ENC_NA);
-
-    /*add the opra protocol tree*/
-    proto_tree *opra_tree = proto_item_add_subtree(ti, ett_opra);
-
-    /*first item in the tree is the version number*/
-    int offset = 0;
-    int len = 1;
-    proto_tree_add_item(opra_tree, hf_opra_version, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
-
-    /*block size*/
-    len = 2;
-    proto_tree_add_item(opra_tree, hf_opra_block_size, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+        {
+            &hf_opra_msg_cat_Y_index_value_value,
+            {   "Index Value (Value)", "opra.msg_cat_Y.index_value.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_Y_index_value_e8,
+            {   "Index Value (1e-8 Units)", "opra.msg_cat_Y.index_value.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_a_strike_price_value,
+            {   "Strike Price (Value)", "opra.msg_cat_a.strike_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_a_strike_price_e8,
+            {   "Strike Price (1e-8 Units)", "opra.msg_cat_a.strike_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_a_premium_price_value,
+            {   "Premium Price (Value)", "opra.msg_cat_a.premium_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_a_premium_price_e8,
+            {   "Premium Price (1e-8 Units)", "opra.msg_cat_a.premium_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_d_strike_price_value,
+            {   "Strike Price (Value)", "opra.msg_cat_d.strike_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_d_strike_price_e8,
+            {   "Strike Price (1e-8 Units)", "opra.msg_cat_d.strike_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_strike_price_value,
+            {   "Strike Price (Value)", "opra.msg_cat_f.strike_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_strike_price_e8,
+            {   "Strike Price (1e-8 Units)", "opra.msg_cat_f.strike_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_open_price_value,
+            {   "Open Price (Value)", "opra.msg_cat_f.open_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_open_price_e8,
+            {   "Open Price (1e-8 Units)", "opra.msg_cat_f.open_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_high_price_value,
+            {   "High Price (Value)", "opra.msg_cat_f.high_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_high_price_e8,
+            {   "High Price (1e-8 Units)", "opra.msg_cat_f.high_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_low_price_value,
+            {   "Low Price (Value)", "opra.msg_cat_f.low_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_low_price_e8,
+            {   "Low Price (1e-8 Units)", "opra.msg_cat_f.low_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_last_price_value,
+            {   "Last Price (Value)", "opra.msg_cat_f.last_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_last_price_e8,
+            {   "Last Price (1e-8 Units)", "opra.msg_cat_f.last_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_net_change_value,
+            {   "Net Change (Value)", "opra.msg_cat_f.net_change.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_net_change_e8,
+            {   "Net Change (1e-8 Units)", "opra.msg_cat_f.net_change.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_underlying_price_value,
+            {   "Underlying Price (Value)", "opra.msg_cat_f.underlying_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_underlying_price_e8,
+            {   "Underlying Price (1e-8 Units)", "opra.msg_cat_f.underlying_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_bid_price_value,
+            {   "Bid Price (Value)", "opra.msg_cat_f.bid_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_bid_price_e8,
+            {   "Bid Price (1e-8 Units)", "opra.msg_cat_f.bid_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_offer_price_value,
+            {   "Offer Price (Value)", "opra.msg_cat_f.offer_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_f_offer_price_e8,
+            {   "Offer Price (1e-8 Units)", "opra.msg_cat_f.offer_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_k_strike_price_value,
+            {   "Strike Price (Value)", "opra.msg_cat_k.strike_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_k_strike_price_e8,
+            {   "Strike Price (1e-8 Units)", "opra.msg_cat_k.strike_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_k_bid_price_value,
+            {   "Bid Price (Value)", "opra.msg_cat_k.bid_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_k_bid_price_e8,
+            {   "Bid Price (1e-8 Units)", "opra.msg_cat_k.bid_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_k_offer_price_value,
+            {   "Offer Price (Value)", "opra.msg_cat_k.offer_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_k_offer_price_e8,
+            {   "Offer Price (1e-8 Units)", "opra.msg_cat_k.offer_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_q_strike_price_value,
+            {   "Strike Price (Value)", "opra.msg_cat_q.strike_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_q_strike_price_e8,
+            {   "Strike Price (1e-8 Units)", "opra.msg_cat_q.strike_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_q_bid_price_value,
+            {   "Bid Price (Value)", "opra.msg_cat_q.bid_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_q_bid_price_e8,
+            {   "Bid Price (1e-8 Units)", "opra.msg_cat_q.bid_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_q_offer_price_value,
+            {   "Offer Price (Value)", "opra.msg_cat_q.offer_price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_cat_q_offer_price_e8,
+            {   "Offer Price (1e-8 Units)", "opra.msg_cat_q.offer_price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_bid_appendage_price_value,
+            {   "Price (Value)", "opra.msg_bid_appendage.price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_bid_appendage_price_e8,
+            {   "Price (1e-8 Units)", "opra.msg_bid_appendage.price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+        {
+            &hf_opra_msg_offer_appendage_price_value,
+            {   "Price (Value)", "opra.msg_offer_appendage.price.value",
+                FT_DOUBLE, BASE_NONE,
+                NULL, 0x0,
+                "Price with the denominator code applied", HFILL }
+        },
+        {
+            &hf_opra_msg_offer_appendage_price_e8,
+            {   "Price (1e-8 Units)", "opra.msg_offer_appendage.price.e8",
+                FT_INT64, BASE_DEC,
+                NULL, 0x0,
+                "Price scaled to 8 decimal places", HFILL }
+        },
+    };
+
+    /*protocol subtree array*/
+    static int *ett[] = {
+        &ett_opra,
+        &ett_opra_message_header,
+        &ett_opra_book,
+        &ett_opra_expiration
+    };
+
+    proto_opra = proto_register_protocol("OPRA protocol", "OPRA", "opra");
+    proto_register_field_array(proto_opra, hf, array_length(hf));
+    proto_register_subtree_array(ett, array_length(ett));
+
+    /*by name too, for recorded files of back to back blocks read as a user link layer or exported PDUs*/
+    opra_handle = register_dissector("opra", dissect_opra, proto_opra);
+    opra_tcp_handle = register_dissector("opra.tcp", dissect_opra_tcp, proto_opra);
+
+    expert_opra = expert_register_protocol(proto_opra);
+    expert_register_field_array(expert_opra, ei, array_length(ei));
+
+    opra_tap = register_tap("opra");
+
+    opra_capture.lines = wmem_map_new_autoreset(wmem_epan_scope(), wmem_file_scope(), opra_line_hash, opra_line_equal);
+
+    /*preferences*/
+    static uat_field_t opra_feed_pair_fields[] = {
+        UAT_FLD_CSTRING(opra_feed_pairs, line_name, "Line", "Name of the line"),
+        UAT_FLD_DEC(opra_feed_pairs, a_port, "A Feed Port", "Destination UDP port of the A feed"),
+        UAT_FLD_DEC(opra_feed_pairs, b_port, "B Feed Port", "Destination UDP port of the B feed"),
+        UAT_END_FIELDS
+    };
+
+    module_t *opra_module = prefs_register_protocol(proto_opra, proto_reg_handoff_opra);
+
+    range_convert_str(wmem_epan_scope(), &global_opra_udp_range, OPRA_UDP_PORT_RANGE, 65535);
+    prefs_register_range_preference(opra_module, "udp.ports", "UDP ports",
+        "UDP destination ports of the OPRA lines",
+        &global_opra_udp_range, 65535);
+
+    range_convert_str(wmem_epan_scope(), &global_opra_tcp_range, "", 65535);
+    prefs_register_range_preference(opra_module, "tcp.ports", "TCP ports",
+        "TCP ports of retransmission server sessions, which carry back to back blocks",
+        &global_opra_tcp_range, 65535);
+
+    prefs_register_bool_preference(opra_module, "desegment", "Reassemble blocks spanning multiple TCP segments",
+        "Whether the OPRA dissector should reassemble blocks spanning multiple TCP segments.  "
+        "To use this option, you must also enable \"Allow subdissectors to reassemble TCP streams\" in the TCP protocol settings.",
+        &opra_desegment);
+
+    prefs_register_uint_preference(opra_module, "heur_version", "Heuristic block version",
+        "Block format version the heuristic UDP and TCP dissectors accept",
+        10, &opra_heur_version);
+
+    uat_t *opra_feed_pairs_uat = uat_new("OPRA A/B Feed Pairs",
+        sizeof(opra_feed_pair),
+        "opra_feed_pairs",
+        true,
+        &opra_feed_pairs,
+        &num_opra_feed_pairs,
+        UAT_AFFECTS_DISSECTION,
+        NULL,
+        opra_feed_pair_copy_cb,
+        opra_feed_pair_update_cb,
+        opra_feed_pair_free_cb,
+        opra_feed_pair_post_update_cb,
+        NULL,
+        opra_feed_pair_fields);
+
+    prefs_register_uat_preference(opra_module, "feed_pairs", "A/B feed pairs",
+        "Destination ports of the A and B feeds of each line.  The second copy of a block to arrive is marked as a duplicate.",
+        opra_feed_pairs_uat);
+
+    prefs_register_bool_preference(opra_module, "skip_duplicate_messages", "Don't decode the messages of duplicate blocks",
+        "Only the block header of the losing copy of an A/B pair is decoded",
+        &opra_skip_duplicate_messages);
+
+    prefs_register_string_preference(opra_module, "clock_offset", "Capture clock offset (ns)",
+        "Capture clock less exchange clock, in nanoseconds, may be negative.  Subtracted from opra.latency.",
+        &opra_clock_offset_pref);
+
+    prefs_register_bool_preference(opra_module, "check_checksum", "Validate the block checksum",
+        "Sum the bytes of every block and compare the sum with its checksum field",
+        &opra_check_checksum);
+
+    prefs_register_string_preference(opra_module, "decode_categories", "Categories to decode",
+        "Message categories decoded in full, e.g. \"aY\" for last sale and underlying value only.  "
+        "Empty decodes every category.  Other messages are skipped by length and not tapped.",
+        &opra_decode_categories_pref);
+
+    prefs_register_string_preference(opra_module, "skip_categories", "Categories to skip",
+        "Message categories skipped by length even if listed in the categories to decode, e.g. \"kq\" to leave out quotes",
+        &opra_skip_categories_pref);
+
+    prefs_register_string_preference(opra_module, "watchlist", "Watchlist",
+        "Roots and instrument IDs, separated by commas or spaces, e.g. \"SPY, AAPL, 42\".  "
+        "Only their messages get a subtree, the rest are counted as opra.unwatched_messages.  Empty shows every message.",
+        &opra_watchlist_pref);
+
+    prefs_register_filename_preference(opra_module, "index_file", "Index file",
+        "Sidecar index of the capture, e.g. the capture's name with \".opraidx\" appended.  Written after the first pass "
+        "and read back when the same capture is opened again, to show each instrument's previous and next messages.  "
+        "Empty turns the index off.",
+        &opra_index_file_pref, true);
+
+    prefs_register_uint_preference(opra_module, "book_memory_limit", "Top of book memory limit (MiB)",
+        "Memory the top of book histories may use.  Past it, the histories of the least recently used instruments "
+        "are evicted and their earlier messages show no top of book.  0 for no limit.",
+        10, &opra_book_memory_limit);
+
+    prefs_register_filename_preference(opra_module, "summary_file", "Summary file",
+        "Mergeable summary of the capture: each line's sequence number ranges and gaps, each instrument's last top of "
+        "book and last sale, and message counts.  Written after the first pass.  Summaries of the pieces of a split "
+        "capture, dissected separately, merge into the summary of the whole.  The category preferences and the watchlist "
+        "don't change it.  Empty writes none.",
+        &opra_summary_file_pref, true);
+
+    /*before any dissection, so every thread checksums with the kernel chosen here*/
+    opra_checksum_init();
+
+    register_init_routine(opra_state_init);
+    register_cleanup_routine(opra_state_cleanup);
+    register_init_routine(opra_index_init);
+    register_cleanup_routine(opra_index_cleanup);
+    register_postseq_cleanup_routine(opra_index_write);
+    register_postseq_cleanup_routine(opra_summary_write_file);
+}
+
+/*Statistics > OPRA > Messages, -z opra,tree.  Built from the tap records.
+  Losing A/B copies are only counted under their own node so the breakdowns don't count a line twice.*/
+static int st_node_opra_messages = -1;
+static int st_node_opra_categories = -1;
+static int st_node_opra_types = -1;
+static int st_node_opra_participants = -1;
+static int st_node_opra_lines = -1;
+static int st_node_opra_retransmissions = -1;
+static int st_node_opra_blocks = -1;
+static int st_node_opra_block_messages = -1;
+
+static const char *st_str_opra_messages = "OPRA Messages";
+static const char *st_str_opra_categories = "By Message Category";
+static const char *st_str_opra_types = "By Message Type";
+static const char *st_str_opra_participants = "By Participant";
+static const char *st_str_opra_lines = "By Line";
+static const char *st_str_opra_retransmissions = "By Retransmission Indicator";
+static const char *st_str_opra_duplicates = "A/B Duplicate Copies";
+static const char *st_str_opra_blocks = "OPRA Blocks";
+static const char *st_str_opra_block_messages = "Messages per Block";
+
+static void opra_stats_tree_init(stats_tree *st)
+{
+    st_node_opra_messages = stats_tree_create_node(st, st_str_opra_messages, 0, STAT_DT_INT, true);
+    st_node_opra_categories = stats_tree_create_pivot(st, st_str_opra_categories, st_node_opra_messages);
+    st_node_opra_types = stats_tree_create_pivot(st, st_str_opra_types, st_node_opra_messages);
+    st_node_opra_participants = stats_tree_create_pivot(st, st_str_opra_participants, st_node_opra_messages);
+    st_node_opra_lines = stats_tree_create_pivot(st, st_str_opra_lines, st_node_opra_messages);
+    st_node_opra_retransmissions = stats_tree_create_pivot(st, st_str_opra_retransmissions, st_node_opra_messages);
+    stats_tree_create_node(st, st_str_opra_duplicates, 0, STAT_DT_INT, false);
+
+    st_node_opra_blocks = stats_tree_create_node(st, st_str_opra_blocks, 0, STAT_DT_INT, true);
+    st_node_opra_block_messages = stats_tree_create_range_node(st, st_str_opra_block_messages, st_node_opra_blocks,
+        "1", "2", "3-4", "5-8", "9-16", "17-32", "33-64", "65-255", NULL);
+}
+
+static tap_packet_status opra_stats_tree_packet(stats_tree *st, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *p, tap_flags_t flags _U_)
+{
+    const opra_tap_info *info = (const opra_tap_info *) p;
+    char line[16];
+    char type[ITEM_LABEL_LENGTH];
+
+    if (info->duplicate){
+        tick_stat_node(st, st_str_opra_duplicates, 0, false);
+        return TAP_PACKET_REDRAW;
+    }
+
+    tick_stat_node(st, st_str_opra_messages, 0, true);
+    stats_tree_tick_pivot(st, st_node_opra_categories, val_to_str(info->message_category, hf_opra_message_categories, "Unknown (0x%02x)"));
+    /*type descriptions repeat between categories, so lead with the category*/
+    snprintf(type, sizeof(type), "[%c] %s", info->message_category, GetMessageTypeDescription(info->message_category, info->message_type));
+    stats_tree_tick_pivot(st, st_node_opra_types, type);
+    stats_tree_tick_pivot(st, st_node_opra_participants, val_to_str(info->participant_id, hf_opra_participant_ids, "Unknown (0x%02x)"));
+    snprintf(line, sizeof(line), "Port %u", info->port);
+    stats_tree_tick_pivot(st, st_node_opra_lines, line);
+    stats_tree_tick_pivot(st, st_node_opra_retransmissions, val_to_str(info->retransmission_indicator, hf_opra_retransmission_indicators, "Unknown (0x%02x)"));
+
+    /*a block's records all carry its header, count it once*/
+    if (0 == info->message_index){
+        tick_stat_node(st, st_str_opra_blocks, 0, true);
+        stats_tree_tick_range(st, st_str_opra_block_messages, st_node_opra_blocks, info->messages_in_block);
+    }
+
+    return TAP_PACKET_REDRAW;
+}
+
+/*Statistics > OPRA Microbursts, -z opra,bursts.  The busiest 1, 10 and 100 ms windows of each line, by block
+  timestamp and by capture time.  Each line keeps a ring of buckets per window (see opra-burst.h), so a block
+  costs the same however long the capture is.*/
+#define OPRA_BURST_CLOCKS 2
+#define OPRA_BURST_WIDTHS 3
+
+static const char *opra_burst_clock_names[OPRA_BURST_CLOCKS] = { "Exchange Time", "Capture Time" };
+static const uint64_t opra_burst_widths_ns[OPRA_BURST_WIDTHS] = { 1000000, 10000000, 100000000 };
+static const char *opra_burst_width_names[OPRA_BURST_WIDTHS] = { "1 ms", "10 ms", "100 ms" };
+
+typedef struct _opra_burst_line {
+    unsigned slot;              /*rows slot * OPRA_BURST_TOP_N onwards in every table*/
+    uint16_t port;
+    opra_burst_window windows[OPRA_BURST_CLOCKS][OPRA_BURST_WIDTHS];
+} opra_burst_line;
+
+/*destination port to opra_burst_line, kept across resets so the table rows stay put*/
+static wmem_map_t *opra_burst_lines;
+
+enum {
+    OPRA_BURST_COLUMN_LINE,
+    OPRA_BURST_COLUMN_RANK,
+    OPRA_BURST_COLUMN_MESSAGES,
+    OPRA_BURST_COLUMN_RATE,
+    OPRA_BURST_COLUMN_START,
+    OPRA_BURST_COLUMN_FIRST_FRAME,
+    OPRA_BURST_COLUMN_LAST_FRAME
+};
+
+static stat_tap_table_item opra_burst_stat_fields[] = {
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Port", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Rank", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Messages", "%u"},
+    {TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Rate (msg/s)", "%.0f"},
+    {TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Window Start (s)", "%.6f"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "First Frame", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Last Frame", "%u"}
+};
+
+static void opra_burst_line_init_windows(opra_burst_line *line)
+{
+    for (unsigned c = 0; c < OPRA_BURST_CLOCKS; c++)
+        for (unsigned w = 0; w < OPRA_BURST_WIDTHS; w++)
+            opra_burst_window_init(&line->windows[c][w], opra_burst_widths_ns[w]);
+}
+
+static void opra_burst_reset_line(void *key _U_, void *value, void *user_data _U_)
+{
+    opra_burst_line_init_windows((opra_burst_line *) value);
+}
+
+static void opra_burst_stat_init(stat_tap_table_ui *new_stat)
+{
+    const int num_fields = array_length(opra_burst_stat_fields);
+    char table_name[64];
+
+    for (unsigned c = 0; c < OPRA_BURST_CLOCKS; c++){
+        for (unsigned w = 0; w < OPRA_BURST_WIDTHS; w++){
+            snprintf(table_name, sizeof(table_name), "%s, %s Window", opra_burst_clock_names[c], opra_burst_width_names[w]);
+
+            stat_tap_table *table = stat_tap_find_table(new_stat, table_name);
+            if (table){
+                if (new_stat->stat_tap_reset_table_cb)
+                    new_stat->stat_tap_reset_table_cb(table);
+                continue;
+            }
+
+            table = stat_tap_init_table(table_name, num_fields, 0, NULL);
+            stat_tap_add_table(new_stat, table);
+        }
+    }
+
+    if (NULL == opra_burst_lines)
+        opra_burst_lines = wmem_map_new(wmem_epan_scope(), g_direct_hash, g_direct_equal);
+}
+
+static void opra_burst_stat_reset(stat_tap_table *table)
+{
+    for (unsigned row = 0; row < table->num_elements; row++){
+        for (unsigned column = OPRA_BURST_COLUMN_MESSAGES; column < table->num_fields; column++){
+            stat_tap_table_item_type *item_data = stat_tap_get_field_data(table, row, column);
+            memset(&item_data->value, 0, sizeof(item_data->value));
+            stat_tap_set_field_data(table, row, column, item_data);
+        }
+    }
+
+    if (NULL != opra_burst_lines)
+        wmem_map_foreach(opra_burst_lines, opra_burst_reset_line, NULL);
+}
+
+static void opra_burst_stat_update(stat_tap_table *table, const opra_burst_line *line, const opra_burst_window *window)
+{
+    for (unsigned rank = 0; rank < window->top_count; rank++){
+        const opra_burst *burst = &window->top[rank];
+        const unsigned row = line->slot * OPRA_BURST_TOP_N + rank;
+        stat_tap_table_item_type *item_data;
+
+        item_data = stat_tap_get_field_data(table, row, OPRA_BURST_COLUMN_MESSAGES);
+        item_data->value.uint_value = (unsigned) burst->messages;
+        stat_tap_set_field_data(table, row, OPRA_BURST_COLUMN_MESSAGES, item_data);
+
+        item_data = stat_tap_get_field_data(table, row, OPRA_BURST_COLUMN_RATE);
+        item_data->value.float_value = opra_burst_rate(window, burst);
+        stat_tap_set_field_data(table, row, OPRA_BURST_COLUMN_RATE, item_data);
+
+        item_data = stat_tap_get_field_data(table, row, OPRA_BURST_COLUMN_START);
+        item_data->value.float_value = (double) burst->start_ns / 1e9;
+        stat_tap_set_field_data(table, row, OPRA_BURST_COLUMN_START, item_data);
+
+        item_data = stat_tap_get_field_data(table, row, OPRA_BURST_COLUMN_FIRST_FRAME);
+        item_data->value.uint_value = burst->first_frame;
+        stat_tap_set_field_data(table, row, OPRA_BURST_COLUMN_FIRST_FRAME, item_data);
+
+        item_data = stat_tap_get_field_data(table, row, OPRA_BURST_COLUMN_LAST_FRAME);
+        item_data->value.uint_value = burst->last_frame;
+        stat_tap_set_field_data(table, row, OPRA_BURST_COLUMN_LAST_FRAME, item_data);
+    }
+}
+
+static opra_burst_line *opra_burst_find_line(stat_tap_table_ui *stat_tap_data, uint16_t port)
+{
+    opra_burst_line *line = (opra_burst_line *) wmem_map_lookup(opra_burst_lines, GUINT_TO_POINTER(port));
+    if (NULL != line)
+        return line;
+
+    line = wmem_new0(wmem_epan_scope(), opra_burst_line);
+    line->slot = wmem_map_size(opra_burst_lines);
+    line->port = port;
+    opra_burst_line_init_windows(line);
+    wmem_map_insert(opra_burst_lines, GUINT_TO_POINTER(port), line);
+
+    /*every table gets the line's rows up front, ranked and empty*/
+    stat_tap_table_item_type items[array_length(opra_burst_stat_fields)];
+    memset(items, 0, sizeof(items));
+    for (unsigned i = 0; i < array_length(opra_burst_stat_fields); i++)
+        items[i].type = opra_burst_stat_fields[i].type;
+    items[OPRA_BURST_COLUMN_LINE].value.uint_value = port;
+
+    for (unsigned t = 0; t < OPRA_BURST_CLOCKS * OPRA_BURST_WIDTHS; t++){
+        stat_tap_table *table = g_array_index(stat_tap_data->tables, stat_tap_table *, t);
+        for (unsigned rank = 0; rank < OPRA_BURST_TOP_N; rank++){
+            items[OPRA_BURST_COLUMN_RANK].value.uint_value = rank + 1;
+            stat_tap_init_table_row(table, line->slot * OPRA_BURST_TOP_N + rank, array_length(opra_burst_stat_fields), items);
+        }
+    }
+    return line;
+}
+
+static tap_packet_status opra_burst_stat_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data, tap_flags_t flags _U_)
+{
+    stat_data_t *stat_data = (stat_data_t *) tapdata;
+    const opra_tap_info *info = (const opra_tap_info *) data;
+
+    /*bursts are counted a block at a time, from the block's first record.  The losing A/B copy isn't new traffic.*/
+    if ((0 != info->message_index) || info->duplicate)
+        return TAP_PACKET_DONT_REDRAW;
+
+    opra_burst_line *line = opra_burst_find_line(stat_data->stat_tap_data, info->port);
+    const uint64_t times_ns[OPRA_BURST_CLOCKS] = {
+        (uint64_t) info->timestamp_secs * 1000000000 + info->timestamp_nsecs,
+        (uint64_t) pinfo->abs_ts.secs * 1000000000 + (uint64_t) pinfo->abs_ts.nsecs
+    };
+    tap_packet_status status = TAP_PACKET_DONT_REDRAW;
+
+    for (unsigned c = 0; c < OPRA_BURST_CLOCKS; c++){
+        for (unsigned w = 0; w < OPRA_BURST_WIDTHS; w++){
+            opra_burst_window *window = &line->windows[c][w];
+            if (opra_burst_window_add(window, times_ns[c], info->messages_in_block, pinfo->num)){
+                stat_tap_table *table = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table *, c * OPRA_BURST_WIDTHS + w);
+                opra_burst_stat_update(table, line, window);
+                status = TAP_PACKET_REDRAW;
+            }
+        }
+    }
+
+    return status;
+}
+
+static stat_tap_table_ui opra_burst_stat_table = {
+    REGISTER_STAT_GROUP_UNSORTED,
+    "OPRA Microbursts",
+    "opra",
+    "opra,bursts",
+    opra_burst_stat_init,
+    opra_burst_stat_packet,
+    opra_burst_stat_reset,
+    NULL,
+    NULL,
+    array_length(opra_burst_stat_fields), opra_burst_stat_fields,
+    0, NULL,
+    NULL,
+    0
+};
+
+/*Statistics > OPRA Index, -z opra,index and -z opra,index_lines.  The instruments and line runs of the mapped
+  index file, filled the first time the tap fires.  On the pass that writes the index there is nothing mapped
+  yet, the tables list it from the next read of the capture on.*/
+enum {
+    OPRA_INDEX_COLUMN_INSTRUMENT,
+    OPRA_INDEX_COLUMN_ID,
+    OPRA_INDEX_COLUMN_MESSAGES,
+    OPRA_INDEX_COLUMN_FIRST_FRAME,
+    OPRA_INDEX_COLUMN_LAST_FRAME,
+    OPRA_INDEX_COLUMN_FRAMES
+};
+
+static stat_tap_table_item opra_index_stat_fields[] = {
+    {TABLE_ITEM_STRING, TAP_ALIGN_LEFT, "Instrument", "%-24s"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "ID", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Messages", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "First Frame", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Last Frame", "%u"},
+    {TABLE_ITEM_STRING, TAP_ALIGN_LEFT, "Frames", "%s"}
+};
+
+enum {
+    OPRA_INDEX_LINE_COLUMN_SOURCE,
+    OPRA_INDEX_LINE_COLUMN_PORT,
+    OPRA_INDEX_LINE_COLUMN_SESSION,
+    OPRA_INDEX_LINE_COLUMN_FIRST_SEQUENCE,
+    OPRA_INDEX_LINE_COLUMN_LAST_SEQUENCE,
+    OPRA_INDEX_LINE_COLUMN_BLOCKS,
+    OPRA_INDEX_LINE_COLUMN_FIRST_FRAME,
+    OPRA_INDEX_LINE_COLUMN_LAST_FRAME
+};
+
+static stat_tap_table_item opra_index_line_stat_fields[] = {
+    {TABLE_ITEM_STRING, TAP_ALIGN_LEFT, "Source", "%-40s"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Port", "%u"},
+    {TABLE_ITEM_STRING, TAP_ALIGN_LEFT, "Session", "%s"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "First Seq", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Last Seq", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Blocks", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "First Frame", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Last Frame", "%u"}
+};
+
+/*ranges listed in the Frames column, the rest are summed up*/
+#define OPRA_INDEX_STAT_MAX_RANGES 16
+
+static bool opra_index_stat_filled;
+static bool opra_index_line_stat_filled;
+
+static void opra_index_stat_init_table(stat_tap_table_ui *new_stat, const char *table_name, unsigned num_fields)
+{
+    stat_tap_table *table = stat_tap_find_table(new_stat, table_name);
+    if (table){
+        if (new_stat->stat_tap_reset_table_cb)
+            new_stat->stat_tap_reset_table_cb(table);
+        return;
+    }
+
+    table = stat_tap_init_table(table_name, num_fields, 0, NULL);
+    stat_tap_add_table(new_stat, table);
+}
+
+static void opra_index_stat_init(stat_tap_table_ui *new_stat)
+{
+    opra_index_stat_init_table(new_stat, "Instruments", array_length(opra_index_stat_fields));
+    opra_index_stat_filled = false;
+}
+
+static void opra_index_line_stat_init(stat_tap_table_ui *new_stat)
+{
+    opra_index_stat_init_table(new_stat, "Line Runs", array_length(opra_index_line_stat_fields));
+    opra_index_line_stat_filled = false;
+}
+
+/*Rows are only added and replaced, never emptied, so a reset leaves them to be refilled from the index*/
+static void opra_index_stat_reset(stat_tap_table *table _U_)
+{
+    opra_index_stat_filled = false;
+}
+
+static void opra_index_line_stat_reset(stat_tap_table *table _U_)
+{
+    opra_index_line_stat_filled = false;
+}
+
+static void opra_index_stat_free_item(stat_tap_table *table _U_, unsigned row _U_, unsigned column _U_, stat_tap_table_item_type *field_data)
+{
+    if (TABLE_ITEM_STRING != field_data->type)
+        return;
+    g_free((char *) field_data->value.string_value);
+    field_data->value.string_value = NULL;
+}
+
+static void opra_index_stat_set_row(stat_tap_table *table, unsigned row, unsigned num_fields, const stat_tap_table_item_type *items)
+{
+    if (row < table->num_elements){
+        for (unsigned column = 0; column < num_fields; column++)
+            opra_index_stat_free_item(table, row, column, stat_tap_get_field_data(table, row, column));
+    }
+    stat_tap_init_table_row(table, row, num_fields, items);
+}
+
+/*the instrument's frames as a display filter set, e.g. "12..15 20"*/
+static char *opra_index_stat_frames(const opra_index_instrument *instrument)
+{
+    GString *frames = g_string_new(NULL);
+    const uint32_t listed = MIN(instrument->range_count, OPRA_INDEX_STAT_MAX_RANGES);
+    opra_index_range range;
+
+    for (uint32_t r = 0; r < listed; r++){
+        opra_index_get_range(&opra_index_mapped, instrument->first_range + r, &range);
+        if (0 != r)
+            g_string_append_c(frames, ' ');
+        if (range.first_frame == range.last_frame)
+            g_string_append_printf(frames, "%u", range.first_frame);
+        else
+            g_string_append_printf(frames, "%u..%u", range.first_frame, range.last_frame);
+    }
+    if (instrument->range_count > listed)
+        g_string_append_printf(frames, " and %u more ranges", instrument->range_count - listed);
+    return g_string_free(frames, false);
+}
+
+static tap_packet_status opra_index_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *data _U_, tap_flags_t flags _U_)
+{
+    stat_data_t *stat_data = (stat_data_t *) tapdata;
+
+    if (opra_index_stat_filled || (NULL == opra_index_mapping))
+        return TAP_PACKET_DONT_REDRAW;
+    opra_index_stat_filled = true;
+
+    stat_tap_table *table = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table *, 0);
+    stat_tap_table_item_type items[array_length(opra_index_stat_fields)];
+    memset(items, 0, sizeof(items));
+    for (unsigned i = 0; i < array_length(opra_index_stat_fields); i++)
+        items[i].type = opra_index_stat_fields[i].type;
+
+    opra_index_instrument instrument;
+    opra_index_range range;
+    for (uint32_t i = 0; i < opra_index_mapped.hdr.instrument_count; i++){
+        opra_index_get_instrument(&opra_index_mapped, i, &instrument);
+        items[OPRA_INDEX_COLUMN_INSTRUMENT].value.string_value = opra_format_instrument_name(NULL, &instrument.key);
+        items[OPRA_INDEX_COLUMN_ID].value.uint_value = instrument.instrument_id;
+        items[OPRA_INDEX_COLUMN_MESSAGES].value.uint_value = instrument.message_count;
+        items[OPRA_INDEX_COLUMN_FIRST_FRAME].value.uint_value = 0;
+        items[OPRA_INDEX_COLUMN_LAST_FRAME].value.uint_value = 0;
+        if (0 != instrument.range_count){
+            opra_index_get_range(&opra_index_mapped, instrument.first_range, &range);
+            items[OPRA_INDEX_COLUMN_FIRST_FRAME].value.uint_value = range.first_frame;
+            opra_index_get_range(&opra_index_mapped, instrument.first_range + instrument.range_count - 1, &range);
+            items[OPRA_INDEX_COLUMN_LAST_FRAME].value.uint_value = range.last_frame;
+        }
+        items[OPRA_INDEX_COLUMN_FRAMES].value.string_value = opra_index_stat_frames(&instrument);
+        opra_index_stat_set_row(table, i, array_length(opra_index_stat_fields), items);
+    }
+    return TAP_PACKET_REDRAW;
+}
+
+static tap_packet_status opra_index_line_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *data _U_, tap_flags_t flags _U_)
+{
+    stat_data_t *stat_data = (stat_data_t *) tapdata;
+
+    if (opra_index_line_stat_filled || (NULL == opra_index_mapping))
+        return TAP_PACKET_DONT_REDRAW;
+    opra_index_line_stat_filled = true;
+
+    stat_tap_table *table = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table *, 0);
+    stat_tap_table_item_type items[array_length(opra_index_line_stat_fields)];
+    memset(items, 0, sizeof(items));
+    for (unsigned i = 0; i < array_length(opra_index_line_stat_fields); i++)
+        items[i].type = opra_index_line_stat_fields[i].type;
+
+    opra_index_line line;
+    address src;
+    for (uint32_t i = 0; i < opra_index_mapped.hdr.line_count; i++){
+        opra_index_get_line(&opra_index_mapped, i, &line);
+        if (4 == line.address_length)
+            set_address(&src, AT_IPv4, 4, line.src);
+        else if (16 == line.address_length)
+            set_address(&src, AT_IPv6, 16, line.src);
+        else
+            clear_address(&src);
+        items[OPRA_INDEX_LINE_COLUMN_SOURCE].value.string_value = address_to_str(NULL, &src);
+        items[OPRA_INDEX_LINE_COLUMN_PORT].value.uint_value = line.dst_port;
+        items[OPRA_INDEX_LINE_COLUMN_SESSION].value.string_value = g_strdup_printf("%c", g_ascii_isprint(line.session_indicator) ? line.session_indicator : '?');
+        items[OPRA_INDEX_LINE_COLUMN_FIRST_SEQUENCE].value.uint_value = line.first_sequence;
+        items[OPRA_INDEX_LINE_COLUMN_LAST_SEQUENCE].value.uint_value = line.last_sequence;
+        items[OPRA_INDEX_LINE_COLUMN_BLOCKS].value.uint_value = line.block_count;
+        items[OPRA_INDEX_LINE_COLUMN_FIRST_FRAME].value.uint_value = line.first_frame;
+        items[OPRA_INDEX_LINE_COLUMN_LAST_FRAME].value.uint_value = line.last_frame;
+        opra_index_stat_set_row(table, i, array_length(opra_index_line_stat_fields), items);
+    }
+    return TAP_PACKET_REDRAW;
+}
+
+static stat_tap_table_ui opra_index_stat_table = {
+    REGISTER_STAT_GROUP_UNSORTED,
+    "OPRA Index",
+    "opra",
+    "opra,index",
+    opra_index_stat_init,
+    opra_index_stat_packet,
+    opra_index_stat_reset,
+    opra_index_stat_free_item,
+    NULL,
+    array_length(opra_index_stat_fields), opra_index_stat_fields,
+    0, NULL,
+    NULL,
+    0
+};
+
+static stat_tap_table_ui opra_index_line_stat_table = {
+    REGISTER_STAT_GROUP_UNSORTED,
+    "OPRA Index Lines",
+    "opra",
+    "opra,index_lines",
+    opra_index_line_stat_init,
+    opra_index_line_stat_packet,
+    opra_index_line_stat_reset,
+    opra_index_stat_free_item,
+    NULL,
+    array_length(opra_index_line_stat_fields), opra_index_line_stat_fields,
+    0, NULL,
+    NULL,
+    0
+};
+
+/*Statistics > OPRA Memory, -z opra,memory.  What the per capture state holds, refreshed with every tap record
+  so a live capture shows it grow.  The arena row is what the state has taken from malloc in all.*/
+enum {
+    OPRA_MEMORY_ROW_INSTRUMENTS,
+    OPRA_MEMORY_ROW_INSTRUMENT_TABLE,
+    OPRA_MEMORY_ROW_INSTRUMENT_NAMES,
+    OPRA_MEMORY_ROW_BOOK_HISTORY,
+    OPRA_MEMORY_ROW_BOOK_FREE_CHUNKS,
+    OPRA_MEMORY_ROW_ARBITRATION,
+    OPRA_MEMORY_ROW_ARENA,
+    OPRA_MEMORY_ROWS
+};
+
+static const char *opra_memory_row_names[OPRA_MEMORY_ROWS] = {
+    "Instruments",
+    "Instrument table slots",
+    "Instrument names",
+    "Top of book history chunks",
+    "Top of book free chunks",
+    "A/B arbitration window",
+    "Arena chunks"
+};
+
+enum {
+    OPRA_MEMORY_COLUMN_STRUCTURE,
+    OPRA_MEMORY_COLUMN_ENTRIES,
+    OPRA_MEMORY_COLUMN_KIB,
+    OPRA_MEMORY_COLUMN_EVICTED
+};
+
+static stat_tap_table_item opra_memory_stat_fields[] = {
+    {TABLE_ITEM_STRING, TAP_ALIGN_LEFT, "Structure", "%-28s"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Entries", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "KiB", "%u"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Evicted", "%u"}
+};
+
+static void opra_memory_stat_init(stat_tap_table_ui *new_stat)
+{
+    const char *table_name = "Per Capture State";
+    stat_tap_table *table = stat_tap_find_table(new_stat, table_name);
+    if (table){
+        if (new_stat->stat_tap_reset_table_cb)
+            new_stat->stat_tap_reset_table_cb(table);
+        return;
+    }
+
+    table = stat_tap_init_table(table_name, array_length(opra_memory_stat_fields), 0, NULL);
+    stat_tap_add_table(new_stat, table);
+
+    /*one row per structure, the names are static so there is nothing to free*/
+    stat_tap_table_item_type items[array_length(opra_memory_stat_fields)];
+    memset(items, 0, sizeof(items));
+    for (unsigned i = 0; i < array_length(opra_memory_stat_fields); i++)
+        items[i].type = opra_memory_stat_fields[i].type;
+    for (unsigned row = 0; row < OPRA_MEMORY_ROWS; row++){
+        items[OPRA_MEMORY_COLUMN_STRUCTURE].value.string_value = opra_memory_row_names[row];
+        stat_tap_init_table_row(table, row, array_length(opra_memory_stat_fields), items);
+    }
+}
+
+static void opra_memory_stat_reset(stat_tap_table *table)
+{
+    for (unsigned row = 0; row < table->num_elements; row++){
+        for (unsigned column = OPRA_MEMORY_COLUMN_ENTRIES; column < table->num_fields; column++){
+            stat_tap_table_item_type *item_data = stat_tap_get_field_data(table, row, column);
+            memset(&item_data->value, 0, sizeof(item_data->value));
+            stat_tap_set_field_data(table, row, column, item_data);
+        }
+    }
+}
+
+static void opra_memory_stat_set_row(stat_tap_table *table, unsigned row, uint64_t entries, size_t bytes, uint64_t evicted)
+{
+    stat_tap_table_item_type *item_data;
+
+    item_data = stat_tap_get_field_data(table, row, OPRA_MEMORY_COLUMN_ENTRIES);
+    item_data->value.uint_value = (unsigned) MIN(entries, UINT_MAX);
+    stat_tap_set_field_data(table, row, OPRA_MEMORY_COLUMN_ENTRIES, item_data);
+
+    item_data = stat_tap_get_field_data(table, row, OPRA_MEMORY_COLUMN_KIB);
+    item_data->value.uint_value = (unsigned) MIN((bytes + 1023) / 1024, UINT_MAX);
+    stat_tap_set_field_data(table, row, OPRA_MEMORY_COLUMN_KIB, item_data);
+
+    item_data = stat_tap_get_field_data(table, row, OPRA_MEMORY_COLUMN_EVICTED);
+    item_data->value.uint_value = (unsigned) MIN(evicted, UINT_MAX);
+    stat_tap_set_field_data(table, row, OPRA_MEMORY_COLUMN_EVICTED, item_data);
+}
+
+static tap_packet_status opra_memory_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *data _U_, tap_flags_t flags _U_)
+{
+    stat_data_t *stat_data = (stat_data_t *) tapdata;
+    stat_tap_table *table = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table *, 0);
+
+    const opra_pool *chunks = &opra_capture.book_chunk_pool;
+    const size_t window_bytes = (NULL != opra_capture.arbitration_window) ? OPRA_ARBITRATION_WINDOW * sizeof(opra_arbitration_entry) : 0;
+
+    opra_memory_stat_set_row(table, OPRA_MEMORY_ROW_INSTRUMENTS, opra_capture.instruments.count, opra_capture.instruments.count * sizeof(opra_instrument), 0);
+    opra_memory_stat_set_row(table, OPRA_MEMORY_ROW_INSTRUMENT_TABLE, (uint64_t) opra_capture.instruments.mask + 1, opra_table_bytes(&opra_capture.instruments), 0);
+    opra_memory_stat_set_row(table, OPRA_MEMORY_ROW_INSTRUMENT_NAMES, opra_capture.instrument_name_count, opra_capture.instrument_name_bytes, 0);
+    opra_memory_stat_set_row(table, OPRA_MEMORY_ROW_BOOK_HISTORY, chunks->in_use, opra_capture.book_bytes, opra_capture.book_evicted);
+    opra_memory_stat_set_row(table, OPRA_MEMORY_ROW_BOOK_FREE_CHUNKS, chunks->free_count, chunks->free_count * chunks->object_size, 0);
+    opra_memory_stat_set_row(table, OPRA_MEMORY_ROW_ARBITRATION, opra_capture.arbitration.count, window_bytes + opra_table_bytes(&opra_capture.arbitration), opra_capture.arbitration_evicted);
+    opra_memory_stat_set_row(table, OPRA_MEMORY_ROW_ARENA, opra_capture.arena.used, opra_capture.arena.reserved, 0);
+    return TAP_PACKET_REDRAW;
+}
+
+static stat_tap_table_ui opra_memory_stat_table = {
+    REGISTER_STAT_GROUP_UNSORTED,
+    "OPRA Memory",
+    "opra",
+    "opra,memory",
+    opra_memory_stat_init,
+    opra_memory_stat_packet,
+    opra_memory_stat_reset,
+    NULL,
+    NULL,
+    array_length(opra_memory_stat_fields), opra_memory_stat_fields,
+    0, NULL,
+    NULL,
+    0
+};
+
+#ifdef OPRA_PERF
+/*Statistics > OPRA Performance, -z opra,perf.  The hot path counters of this thread, see opra_perf_counters,
+  refreshed with every tap record.  The tap this table listens to is one of the stages it times.*/
+static const char *opra_perf_stage_names[OPRA_PERF_STAGES] = {
+    [OPRA_PERF_STAGE_BLOCK] = "Block header and setup",
+    [OPRA_PERF_STAGE_SEQUENCE] = "Sequence and A/B arbitration",
+    [OPRA_PERF_STAGE_CHECKSUM] = "Checksum",
+    [OPRA_PERF_STAGE_WALK] = "Message walk and decode",
+    [OPRA_PERF_STAGE_INSTRUMENT] = "Instrument lookup",
+    [OPRA_PERF_STAGE_BOOK] = "Top of book",
+    [OPRA_PERF_STAGE_TAP] = "Tap",
+    [OPRA_PERF_STAGE_TREE] = "Tree building",
+    [OPRA_PERF_STAGE_PRICE] = "Price formatting",
+    [OPRA_PERF_STAGE_INFO] = "Info column"
+};
+
+/*Both tables have these columns.  For a stage the total is in millions of ticks and the share is of the ticks,
+  for a message category the total is in KiB and the share is of the messages.*/
+enum {
+    OPRA_PERF_COLUMN_NAME,
+    OPRA_PERF_COLUMN_COUNT,
+    OPRA_PERF_COLUMN_TOTAL,
+    OPRA_PERF_COLUMN_AVERAGE,
+    OPRA_PERF_COLUMN_SHARE
+};
+
+static stat_tap_table_item opra_perf_stat_fields[] = {
+    {TABLE_ITEM_STRING, TAP_ALIGN_LEFT, "Stage or Category", "%-36s"},
+    {TABLE_ITEM_UINT, TAP_ALIGN_RIGHT, "Count", "%u"},
+    {TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Total", "%.3f"},
+    {TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Per Count", "%.1f"},
+    {TABLE_ITEM_FLOAT, TAP_ALIGN_RIGHT, "Share %", "%.2f"}
+};
+
+#define OPRA_PERF_CATEGORY_ROWS (array_length(hf_opra_message_categories) - 1)
+
+/*one row per name, the names are static so there is nothing to free*/
+static void opra_perf_stat_add_table(stat_tap_table_ui *new_stat, const char *table_name, const char *(*row_name)(unsigned), unsigned rows)
+{
+    stat_tap_table *table = stat_tap_find_table(new_stat, table_name);
+    if (table){
+        if (new_stat->stat_tap_reset_table_cb)
+            new_stat->stat_tap_reset_table_cb(table);
+        return;
+    }
+
+    table = stat_tap_init_table(table_name, array_length(opra_perf_stat_fields), 0, NULL);
+    stat_tap_add_table(new_stat, table);
+
+    stat_tap_table_item_type items[array_length(opra_perf_stat_fields)];
+    memset(items, 0, sizeof(items));
+    for (unsigned i = 0; i < array_length(opra_perf_stat_fields); i++)
+        items[i].type = opra_perf_stat_fields[i].type;
+    for (unsigned row = 0; row < rows; row++){
+        items[OPRA_PERF_COLUMN_NAME].value.string_value = row_name(row);
+        stat_tap_init_table_row(table, row, array_length(opra_perf_stat_fields), items);
+    }
+}
+
+/*rows leave out the idle stage*/
+static const char *opra_perf_stage_row_name(unsigned row)
+{
+    return opra_perf_stage_names[row + 1];
+}
+
+static const char *opra_perf_category_row_name(unsigned row)
+{
+    return hf_opra_message_categories[row].strptr;
+}
+
+static void opra_perf_stat_init(stat_tap_table_ui *new_stat)
+{
+    opra_perf_stat_add_table(new_stat, "Stages, Millions of Ticks", opra_perf_stage_row_name, OPRA_PERF_STAGES - 1);
+    opra_perf_stat_add_table(new_stat, "Message Categories, KiB", opra_perf_category_row_name, OPRA_PERF_CATEGORY_ROWS);
+}
+
+static void opra_perf_stat_reset(stat_tap_table *table)
+{
+    for (unsigned row = 0; row < table->num_elements; row++){
+        for (unsigned column = OPRA_PERF_COLUMN_COUNT; column < table->num_fields; column++){
+            stat_tap_table_item_type *item_data = stat_tap_get_field_data(table, row, column);
+            memset(&item_data->value, 0, sizeof(item_data->value));
+            stat_tap_set_field_data(table, row, column, item_data);
+        }
+    }
+}
+
+/*count calls or messages adding up to amount, the total shown divided by unit.  share is the row's part of share_total.*/
+static void opra_perf_stat_set_row(stat_tap_table *table, unsigned row, uint64_t count, uint64_t amount, double unit, uint64_t share,
+    uint64_t share_total)
+{
+    stat_tap_table_item_type *item_data;
+
+    item_data = stat_tap_get_field_data(table, row, OPRA_PERF_COLUMN_COUNT);
+    item_data->value.uint_value = (unsigned) MIN(count, UINT_MAX);
+    stat_tap_set_field_data(table, row, OPRA_PERF_COLUMN_COUNT, item_data);
+
+    item_data = stat_tap_get_field_data(table, row, OPRA_PERF_COLUMN_TOTAL);
+    item_data->value.float_value = (double) amount / unit;
+    stat_tap_set_field_data(table, row, OPRA_PERF_COLUMN_TOTAL, item_data);
+
+    item_data = stat_tap_get_field_data(table, row, OPRA_PERF_COLUMN_AVERAGE);
+    item_data->value.float_value = (0 != count) ? (double) amount / (double) count : 0.0;
+    stat_tap_set_field_data(table, row, OPRA_PERF_COLUMN_AVERAGE, item_data);
+
+    item_data = stat_tap_get_field_data(table, row, OPRA_PERF_COLUMN_SHARE);
+    item_data->value.float_value = (0 != share_total) ? 100.0 * (double) share / (double) share_total : 0.0;
+    stat_tap_set_field_data(table, row, OPRA_PERF_COLUMN_SHARE, item_data);
+}
+
+static tap_packet_status opra_perf_stat_packet(void *tapdata, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *data _U_, tap_flags_t flags _U_)
+{
+    stat_data_t *stat_data = (stat_data_t *) tapdata;
+    stat_tap_table *stages = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table *, 0);
+    stat_tap_table *categories = g_array_index(stat_data->stat_tap_data->tables, stat_tap_table *, 1);
+
+    uint64_t ticks = 0;
+    for (unsigned stage = OPRA_PERF_STAGE_IDLE + 1; stage < OPRA_PERF_STAGES; stage++)
+        ticks += opra_perf.ticks[stage];
+    for (unsigned stage = OPRA_PERF_STAGE_IDLE + 1; stage < OPRA_PERF_STAGES; stage++)
+        opra_perf_stat_set_row(stages, stage - 1, opra_perf.calls[stage], opra_perf.ticks[stage], 1e6, opra_perf.ticks[stage], ticks);
+
+    uint64_t messages = 0;
+    for (unsigned row = 0; row < OPRA_PERF_CATEGORY_ROWS; row++)
+        messages += opra_perf.messages[(uint8_t) hf_opra_message_categories[row].value];
+    for (unsigned row = 0; row < OPRA_PERF_CATEGORY_ROWS; row++){
+        const uint8_t message_category = (uint8_t) hf_opra_message_categories[row].value;
+        const uint64_t count = opra_perf.messages[message_category];
+        opra_perf_stat_set_row(categories, row, count, opra_perf.bytes[message_category], 1024.0, count, messages);
+    }
+    return TAP_PACKET_REDRAW;
+}
+
+static stat_tap_table_ui opra_perf_stat_table = {
+    REGISTER_STAT_GROUP_UNSORTED,
+    "OPRA Performance",
+    "opra",
+    "opra,perf",
+    opra_perf_stat_init,
+    opra_perf_stat_packet,
+    opra_perf_stat_reset,
+    NULL,
+    NULL,
+    array_length(opra_perf_stat_fields), opra_perf_stat_fields,
+    0, NULL,
+    NULL,
+    0
+};
+#endif
+
+/*Columnar export, -z opra,export,<prefix>.  Decoded messages go to one Arrow IPC stream per category,
+  <prefix>-a.arrows and so on, a batch at a time as the tap records arrive.  Prices are the tap's integers
+  scaled to 8 decimal places and symbols are dictionary encoded, so the files load without any parsing.
+  Losing A/B copies aren't exported.*/
+enum {
+    OPRA_EXPORT_COLUMN_FRAME,
+    OPRA_EXPORT_COLUMN_TIMESTAMP,
+    OPRA_EXPORT_COLUMN_PORT,
+    OPRA_EXPORT_COLUMN_SESSION,
+    OPRA_EXPORT_COLUMN_BLOCK_SEQUENCE,
+    OPRA_EXPORT_COLUMN_MESSAGE_INDEX,
+    OPRA_EXPORT_COLUMN_PARTICIPANT,
+    OPRA_EXPORT_COLUMN_MESSAGE_TYPE,
+    OPRA_EXPORT_COLUMN_TRANSACTION_ID,
+    OPRA_EXPORT_COLUMN_SYMBOL,
+    OPRA_EXPORT_COMMON_COLUMNS
+};
+
+/*after the common columns of the categories with an instrument*/
+enum {
+    OPRA_EXPORT_COLUMN_INSTRUMENT_ID = OPRA_EXPORT_COMMON_COLUMNS,
+    OPRA_EXPORT_COLUMN_EXPIRATION_MONTH,
+    OPRA_EXPORT_COLUMN_EXPIRATION_DAY,
+    OPRA_EXPORT_COLUMN_EXPIRATION_YEAR,
+    OPRA_EXPORT_COLUMN_STRIKE,
+    OPRA_EXPORT_INSTRUMENT_COLUMNS
+};
+
+enum {
+    OPRA_EXPORT_COLUMN_Y_INDEX_VALUE = OPRA_EXPORT_COMMON_COLUMNS
+};
+
+enum {
+    OPRA_EXPORT_COLUMN_a_PREMIUM = OPRA_EXPORT_INSTRUMENT_COLUMNS,
+    OPRA_EXPORT_COLUMN_a_VOLUME
+};
+
+enum {
+    OPRA_EXPORT_COLUMN_d_OPEN_INTEREST = OPRA_EXPORT_INSTRUMENT_COLUMNS
+};
+
+enum {
+    OPRA_EXPORT_COLUMN_f_LAST = OPRA_EXPORT_INSTRUMENT_COLUMNS,
+    OPRA_EXPORT_COLUMN_f_BID,
+    OPRA_EXPORT_COLUMN_f_OFFER,
+    OPRA_EXPORT_COLUMN_f_VOLUME
+};
+
+/*long and short quotes*/
+enum {
+    OPRA_EXPORT_COLUMN_QUOTE_BID_PRICE = OPRA_EXPORT_INSTRUMENT_COLUMNS,
+    OPRA_EXPORT_COLUMN_QUOTE_BID_SIZE,
+    OPRA_EXPORT_COLUMN_QUOTE_OFFER_PRICE,
+    OPRA_EXPORT_COLUMN_QUOTE_OFFER_SIZE,
+    OPRA_EXPORT_COLUMN_QUOTE_BEST_BID_PARTICIPANT,
+    OPRA_EXPORT_COLUMN_QUOTE_BEST_BID_PRICE,
+    OPRA_EXPORT_COLUMN_QUOTE_BEST_BID_SIZE,
+    OPRA_EXPORT_COLUMN_QUOTE_BEST_OFFER_PARTICIPANT,
+    OPRA_EXPORT_COLUMN_QUOTE_BEST_OFFER_PRICE,
+    OPRA_EXPORT_COLUMN_QUOTE_BEST_OFFER_SIZE
+};
+
+#define OPRA_EXPORT_COMMON_FIELDS \
+    { "frame", OPRA_EXPORT_UINT32, false }, \
+    { "block_timestamp", OPRA_EXPORT_TIMESTAMP_NS, false }, \
+    { "port", OPRA_EXPORT_UINT16, false }, \
+    { "session_indicator", OPRA_EXPORT_UINT8, false }, \
+    { "block_sequence_number", OPRA_EXPORT_UINT32, false }, \
+    { "message_index", OPRA_EXPORT_UINT8, false }, \
+    { "participant_id", OPRA_EXPORT_UINT8, false }, \
+    { "message_type", OPRA_EXPORT_UINT8, false }, \
+    { "transaction_id", OPRA_EXPORT_UINT32, false }, \
+    { "security_symbol", OPRA_EXPORT_SYMBOL, false }
+
+#define OPRA_EXPORT_INSTRUMENT_FIELDS \
+    OPRA_EXPORT_COMMON_FIELDS, \
+    { "instrument_id", OPRA_EXPORT_UINT32, false }, \
+    { "expiration_month_code", OPRA_EXPORT_UINT8, false }, \
+    { "expiration_day", OPRA_EXPORT_UINT8, false }, \
+    { "expiration_year", OPRA_EXPORT_UINT8, false }, \
+    { "strike_price_e8", OPRA_EXPORT_INT64, true }
+
+static const opra_export_column opra_export_Y_columns[] = {
+    OPRA_EXPORT_COMMON_FIELDS,
+    { "index_value_e8", OPRA_EXPORT_INT64, true }
+};
+
+static const opra_export_column opra_export_a_columns[] = {
+    OPRA_EXPORT_INSTRUMENT_FIELDS,
+    { "premium_price_e8", OPRA_EXPORT_INT64, true },
+    { "volume", OPRA_EXPORT_UINT32, false }
+};
+
+static const opra_export_column opra_export_d_columns[] = {
+    OPRA_EXPORT_INSTRUMENT_FIELDS,
+    { "open_interest", OPRA_EXPORT_UINT32, false }
+};
+
+static const opra_export_column opra_export_f_columns[] = {
+    OPRA_EXPORT_INSTRUMENT_FIELDS,
+    { "last_price_e8", OPRA_EXPORT_INT64, true },
+    { "bid_price_e8", OPRA_EXPORT_INT64, true },
+    { "offer_price_e8", OPRA_EXPORT_INT64, true },
+    { "volume", OPRA_EXPORT_UINT32, false }
+};
+
+static const opra_export_column opra_export_quote_columns[] = {
+    OPRA_EXPORT_INSTRUMENT_FIELDS,
+    { "bid_price_e8", OPRA_EXPORT_INT64, true },
+    { "bid_size", OPRA_EXPORT_UINT32, false },
+    { "offer_price_e8", OPRA_EXPORT_INT64, true },
+    { "offer_size", OPRA_EXPORT_UINT32, false },
+    { "best_bid_participant_id", OPRA_EXPORT_UINT8, true },
+    { "best_bid_price_e8", OPRA_EXPORT_INT64, true },
+    { "best_bid_size", OPRA_EXPORT_UINT32, true },
+    { "best_offer_participant_id", OPRA_EXPORT_UINT8, true },
+    { "best_offer_price_e8", OPRA_EXPORT_INT64, true },
+    { "best_offer_size", OPRA_EXPORT_UINT32, true }
+};
+
+typedef struct _opra_export_category {
+    uint8_t category;
+    const opra_export_column *columns;
+    unsigned num_columns;
+} opra_export_category;
+
+static const opra_export_category opra_export_categories[] = {
+    { 'Y', opra_export_Y_columns, array_length(opra_export_Y_columns) },
+    { 'a', opra_export_a_columns, array_length(opra_export_a_columns) },
+    { 'd', opra_export_d_columns, array_length(opra_export_d_columns) },
+    { 'f', opra_export_f_columns, array_length(opra_export_f_columns) },
+    { 'k', opra_export_quote_columns, array_length(opra_export_quote_columns) },
+    { 'q', opra_export_quote_columns, array_length(opra_export_quote_columns) }
+};
+
+#define OPRA_EXPORT_CATEGORIES array_length(opra_export_categories)
+
+typedef struct _opra_export_tap {
+    char *prefix;
+    opra_export_stream *streams[OPRA_EXPORT_CATEGORIES];   /*opened with the category's first message*/
+    bool failed;                    /*reported once, nothing more is written*/
+} opra_export_tap;
+
+static int opra_export_category_slot(uint8_t category)
+{
+    for (unsigned i = 0; i < OPRA_EXPORT_CATEGORIES; i++)
+        if (opra_export_categories[i].category == category)
+            return (int) i;
+    return -1;
+}
+
+static opra_export_stream *opra_export_get_stream(opra_export_tap *tap, unsigned slot)
+{
+    if (NULL != tap->streams[slot])
+        return tap->streams[slot];
+
+    const opra_export_category *category = &opra_export_categories[slot];
+    char *path = g_strdup_printf("%s-%c.arrows", tap->prefix, category->category);
+    tap->streams[slot] = opra_export_stream_open(path, category->columns, category->num_columns);
+    if (NULL == tap->streams[slot]){
+        report_failure("Can't create the OPRA export file \"%s\"", path);
+        tap->failed = true;
+    }
+    g_free(path);
+    return tap->streams[slot];
+}
+
+static void opra_export_set_price(opra_export_stream *stream, unsigned column, const opra_tap_info *info, uint8_t flag, int64_t price)
+{
+    if (info->flags & flag)
+        opra_export_set_int(stream, column, price);
+    else
+        opra_export_set_null(stream, column);
+}
+
+static void opra_export_set_appendage(opra_export_stream *stream, unsigned column, const opra_tap_info *info, uint8_t flag,
+    uint8_t participant_id, int64_t price, uint32_t size)
+{
+    if (info->flags & flag){
+        opra_export_set_uint(stream, column, participant_id);
+        opra_export_set_int(stream, column + 1, price);
+        opra_export_set_uint(stream, column + 2, size);
+    } else {
+        opra_export_set_null(stream, column);
+        opra_export_set_null(stream, column + 1);
+        opra_export_set_null(stream, column + 2);
+    }
+}
+
+static void opra_export_fill_instrument(opra_export_stream *stream, const opra_tap_info *info)
+{
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_INSTRUMENT_ID, info->instrument_id);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_EXPIRATION_MONTH, info->expiration_block[0]);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_EXPIRATION_DAY, info->expiration_block[1]);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_EXPIRATION_YEAR, info->expiration_block[2]);
+    opra_export_set_price(stream, OPRA_EXPORT_COLUMN_STRIKE, info, OPRA_TAP_HAS_STRIKE, info->strike_price);
+}
+
+static void opra_export_fill_row(opra_export_stream *stream, const packet_info *pinfo, const opra_tap_info *info)
+{
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_FRAME, pinfo->num);
+    opra_export_set_int(stream, OPRA_EXPORT_COLUMN_TIMESTAMP, (int64_t) info->timestamp_secs * 1000000000 + info->timestamp_nsecs);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_PORT, info->port);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_SESSION, info->session_indicator);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_BLOCK_SEQUENCE, info->block_sequence_number);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_MESSAGE_INDEX, info->message_index);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_PARTICIPANT, info->participant_id);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_MESSAGE_TYPE, info->message_type);
+    opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_TRANSACTION_ID, info->transaction_id);
+    opra_export_set_symbol(stream, OPRA_EXPORT_COLUMN_SYMBOL, info->security_symbol);
+
+    switch(info->message_category)
+    {
+        case 'Y':
+            opra_export_set_price(stream, OPRA_EXPORT_COLUMN_Y_INDEX_VALUE, info, OPRA_TAP_HAS_PRICE, info->price);
+            break;
+        case 'a':
+            opra_export_fill_instrument(stream, info);
+            opra_export_set_price(stream, OPRA_EXPORT_COLUMN_a_PREMIUM, info, OPRA_TAP_HAS_PRICE, info->price);
+            opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_a_VOLUME, info->volume);
+            break;
+        case 'd':
+            opra_export_fill_instrument(stream, info);
+            opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_d_OPEN_INTEREST, info->volume);
+            break;
+        case 'f':
+            opra_export_fill_instrument(stream, info);
+            opra_export_set_price(stream, OPRA_EXPORT_COLUMN_f_LAST, info, OPRA_TAP_HAS_PRICE, info->price);
+            opra_export_set_price(stream, OPRA_EXPORT_COLUMN_f_BID, info, OPRA_TAP_HAS_BID, info->bid_price);
+            opra_export_set_price(stream, OPRA_EXPORT_COLUMN_f_OFFER, info, OPRA_TAP_HAS_OFFER, info->offer_price);
+            opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_f_VOLUME, info->volume);
+            break;
+        case 'k':
+        case 'q':
+            opra_export_fill_instrument(stream, info);
+            opra_export_set_price(stream, OPRA_EXPORT_COLUMN_QUOTE_BID_PRICE, info, OPRA_TAP_HAS_BID, info->bid_price);
+            opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_QUOTE_BID_SIZE, info->bid_size);
+            opra_export_set_price(stream, OPRA_EXPORT_COLUMN_QUOTE_OFFER_PRICE, info, OPRA_TAP_HAS_OFFER, info->offer_price);
+            opra_export_set_uint(stream, OPRA_EXPORT_COLUMN_QUOTE_OFFER_SIZE, info->offer_size);
+            opra_export_set_appendage(stream, OPRA_EXPORT_COLUMN_QUOTE_BEST_BID_PARTICIPANT, info, OPRA_TAP_HAS_BEST_BID,
+                info->best_bid_participant_id, info->best_bid_price, info->best_bid_size);
+            opra_export_set_appendage(stream, OPRA_EXPORT_COLUMN_QUOTE_BEST_OFFER_PARTICIPANT, info, OPRA_TAP_HAS_BEST_OFFER,
+                info->best_offer_participant_id, info->best_offer_price, info->best_offer_size);
+            break;
+        default:
+            break;
+    }
+}
+
+static tap_packet_status opra_export_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data, tap_flags_t flags _U_)
+{
+    opra_export_tap *tap = (opra_export_tap *) tapdata;
+    const opra_tap_info *info = (const opra_tap_info *) data;
+
+    if (tap->failed || info->duplicate)
+        return TAP_PACKET_DONT_REDRAW;
+
+    const int slot = opra_export_category_slot(info->message_category);
+    if (slot < 0)
+        return TAP_PACKET_DONT_REDRAW;
+
+    opra_export_stream *stream = opra_export_get_stream(tap, (unsigned) slot);
+    if (NULL == stream)
+        return TAP_PACKET_DONT_REDRAW;
+
+    opra_export_fill_row(stream, pinfo, info);
+    if (!opra_export_end_row(stream)){
+        report_failure("Can't write the OPRA export files \"%s-*.arrows\"", tap->prefix);
+        tap->failed = true;
+    }
+    return TAP_PACKET_DONT_REDRAW;
+}
+
+static void opra_export_close_streams(opra_export_tap *tap)
+{
+    for (unsigned i = 0; i < OPRA_EXPORT_CATEGORIES; i++){
+        if (NULL == tap->streams[i])
+            continue;
+        if (!opra_export_stream_close(tap->streams[i]) && !tap->failed){
+            report_failure("Can't write the OPRA export files \"%s-*.arrows\"", tap->prefix);
+            tap->failed = true;
+        }
+        tap->streams[i] = NULL;
+    }
+}
+
+/*a retap starts the files afresh*/
+static void opra_export_reset(void *tapdata)
+{
+    opra_export_tap *tap = (opra_export_tap *) tapdata;
+    opra_export_close_streams(tap);
+    tap->failed = false;
+}
+
+/*Write out the partial batches, so the files are complete whenever the tap is drawn*/
+static void opra_export_draw(void *tapdata)
+{
+    opra_export_tap *tap = (opra_export_tap *) tapdata;
+    for (unsigned i = 0; i < OPRA_EXPORT_CATEGORIES; i++){
+        if ((NULL != tap->streams[i]) && !opra_export_stream_flush(tap->streams[i]) && !tap->failed){
+            report_failure("Can't write the OPRA export files \"%s-*.arrows\"", tap->prefix);
+            tap->failed = true;
+        }
+    }
+}
+
+static void opra_export_finish(void *tapdata)
+{
+    opra_export_tap *tap = (opra_export_tap *) tapdata;
+    opra_export_close_streams(tap);
+    g_free(tap->prefix);
+    g_free(tap);
+}
+
+static void opra_export_init(const char *opt_arg, void *userdata _U_)
+{
+    static const char prefix_arg[] = "opra,export,";
+
+    if ((0 != strncmp(opt_arg, prefix_arg, strlen(prefix_arg))) || ('\0' == opt_arg[strlen(prefix_arg)])){
+        report_failure("Usage: -z opra,export,<file prefix>");
+        return;
+    }
+
+    opra_export_tap *tap = g_new0(opra_export_tap, 1);
+    tap->prefix = g_strdup(opt_arg + strlen(prefix_arg));
+
+    GString *error = register_tap_listener("opra", tap, NULL, TL_REQUIRES_NOTHING, opra_export_reset,
+        opra_export_packet, opra_export_draw, opra_export_finish);
+    if (NULL != error){
+        report_failure("Couldn't register the OPRA export tap: %s", error->str);
+        g_string_free(error, true);
+        g_free(tap->prefix);
+        g_free(tap);
+    }
+}
+
+static stat_tap_ui opra_export_ui = {
+    REGISTER_STAT_GROUP_GENERIC,
+    NULL,
+    "opra,export",
+    opra_export_init,
+    0,
+    NULL
+};
+
+/*-z opra,records,<file>: every tap record as a line of text, see opra_tap_format().  The regression tests compare
+  the records of runs with and without a tree, skip categories and a watchlist, all of which must tap the same.*/
+typedef struct _opra_records_tap {
+    char *path;
+    GString *lines;
+} opra_records_tap;
+
+static tap_packet_status opra_records_packet(void *tapdata, packet_info *pinfo, epan_dissect_t *edt _U_, const void *data, tap_flags_t flags _U_)
+{
+    opra_records_tap *tap = (opra_records_tap *) tapdata;
+    char line[OPRA_TAP_FORMAT_SIZE];
+
+    g_string_append_printf(tap->lines, "frame=%u %s\n", pinfo->num, opra_tap_format(line, sizeof(line), (const opra_tap_info *) data));
+    return TAP_PACKET_DONT_REDRAW;
+}
+
+/*a retap starts the file afresh*/
+static void opra_records_reset(void *tapdata)
+{
+    opra_records_tap *tap = (opra_records_tap *) tapdata;
+    g_string_truncate(tap->lines, 0);
+}
+
+static void opra_records_draw(void *tapdata)
+{
+    opra_records_tap *tap = (opra_records_tap *) tapdata;
+    GError *err = NULL;
+
+    if (!g_file_set_contents(tap->path, tap->lines->str, (gssize) tap->lines->len, &err)){
+        report_failure("Can't write the OPRA records file \"%s\": %s", tap->path, err->message);
+        g_error_free(err);
+    }
+}
+
+static void opra_records_finish(void *tapdata)
+{
+    opra_records_tap *tap = (opra_records_tap *) tapdata;
+    g_string_free(tap->lines, true);
+    g_free(tap->path);
+    g_free(tap);
+}
+
+static void opra_records_init(const char *opt_arg, void *userdata _U_)
+{
+    static const char prefix_arg[] = "opra,records,";
+
+    if ((0 != strncmp(opt_arg, prefix_arg, strlen(prefix_arg))) || ('\0' == opt_arg[strlen(prefix_arg)])){
+        report_failure("Usage: -z opra,records,<file>");
+        return;
+    }
+
+    opra_records_tap *tap = g_new0(opra_records_tap, 1);
+    tap->path = g_strdup(opt_arg + strlen(prefix_arg));
+    tap->lines = g_string_new(NULL);
+
+    GString *error = register_tap_listener("opra", tap, NULL, TL_REQUIRES_NOTHING, opra_records_reset,
+        opra_records_packet, opra_records_draw, opra_records_finish);
+    if (NULL != error){
+        report_failure("Couldn't register the OPRA records tap: %s", error->str);
+        g_string_free(error, true);
+        g_string_free(tap->lines, true);
+        g_free(tap->path);
+        g_free(tap);
+    }
+}
+
+static stat_tap_ui opra_records_ui = {
+    REGISTER_STAT_GROUP_GENERIC,
+    NULL,
+    "opra,records",
+    opra_records_init,
+    0,
+    NULL
+};
+
+/*Statistics > OPRA > Latency, -z opra_latency,tree.  Exchange to capture latency in microseconds, in power of
+  two buckets.  Lines are counted a block at a time and include both feeds' copies, since each copy took its own
+  path.  Participants are counted per message and without the losing A/B copy.*/
+static int st_node_opra_latency = -1;
+static int st_node_opra_latency_lines = -1;
+static int st_node_opra_latency_participants = -1;
+
+static const char *st_str_opra_latency = "OPRA Latency (us)";
+static const char *st_str_opra_latency_negative = "Negative, check the clock offset";
+static const char *st_str_opra_latency_lines = "By Line";
+static const char *st_str_opra_latency_participants = "By Participant";
+
+static const char *opra_latency_buckets[] = {
+    "0-1", "2-3", "4-7", "8-15", "16-31", "32-63", "64-127", "128-255", "256-511", "512-1023",
+    "1024-2047", "2048-4095", "4096-8191", "8192-16383", "16384-32767", "32768-65535",
+    "65536-131071", "131072-262143", "262144-524287", "524288-1048575", "1048576-"
+};
+
+static void opra_latency_stats_tree_init(stats_tree *st)
+{
+    st_node_opra_latency = stats_tree_create_node(st, st_str_opra_latency, 0, STAT_DT_INT, true);
+    stats_tree_create_node(st, st_str_opra_latency_negative, 0, STAT_DT_INT, false);
+    st_node_opra_latency_lines = stats_tree_create_node(st, st_str_opra_latency_lines, st_node_opra_latency, STAT_DT_INT, true);
+    st_node_opra_latency_participants = stats_tree_create_node(st, st_str_opra_latency_participants, st_node_opra_latency, STAT_DT_INT, true);
+}
+
+/*add value to the histogram named name under parent_id, creating it the first time the name is seen.
+  stats_tree_parent_id_by_name() returns the root, 0, for names it hasn't got.*/
+static void opra_latency_stats_tree_tick(stats_tree *st, const char *name, int parent_id, int value)
+{
+    if (0 == stats_tree_parent_id_by_name(st, name))
+        stats_tree_create_range_node_string(st, name, parent_id, array_length(opra_latency_buckets), opra_latency_buckets);
+    avg_stat_node_add_value_int(st, name, parent_id, false, value);
+    stats_tree_tick_range(st, name, parent_id, value);
+}
+
+static tap_packet_status opra_latency_stats_tree_packet(stats_tree *st, packet_info *pinfo _U_, epan_dissect_t *edt _U_, const void *p, tap_flags_t flags _U_)
+{
+    const opra_tap_info *info = (const opra_tap_info *) p;
+    char name[ITEM_LABEL_LENGTH];
+
+    const bool first_in_block = (0 == info->message_index);
+    if (!first_in_block && info->duplicate)
+        return TAP_PACKET_DONT_REDRAW;
+
+    if (info->latency_ns < 0){
+        if (first_in_block)
+            tick_stat_node(st, st_str_opra_latency_negative, 0, false);
+        return TAP_PACKET_REDRAW;
+    }
+
+    const int latency_us = (info->latency_ns / 1000 > INT_MAX) ? INT_MAX : (int) (info->latency_ns / 1000);
+
+    if (first_in_block){
+        avg_stat_node_add_value_int(st, st_str_opra_latency, 0, false, latency_us);
+        avg_stat_node_add_value_int(st, st_str_opra_latency_lines, st_node_opra_latency, false, latency_us);
+        snprintf(name, sizeof(name), "Port %u", info->port);
+        opra_latency_stats_tree_tick(st, name, st_node_opra_latency_lines, latency_us);
+    }
+
+    if (!info->duplicate){
+        avg_stat_node_add_value_int(st, st_str_opra_latency_participants, st_node_opra_latency, false, latency_us);
+        snprintf(name, sizeof(name), "Participant %s", val_to_str(info->participant_id, hf_opra_participant_ids, "Unknown (0x%02x)"));
+        opra_latency_stats_tree_tick(st, name, st_node_opra_latency_participants, latency_us);
+    }
+
+    return TAP_PACKET_REDRAW;
+}
+
+static void opra_update_category_filter(void)
+{
+    const bool decode_all = (NULL == opra_decode_categories_pref) || ('\0' == opra_decode_categories_pref[0]);
+    for (unsigned i = 0; i < array_length(opra_category_skipped); i++)
+        opra_category_skipped[i] = !decode_all;
+
+    if (!decode_all)
+        for (const char *c = opra_decode_categories_pref; '\0' != *c; c++)
+            opra_category_skipped[(uint8_t) *c] = false;
+
+    if (NULL != opra_skip_categories_pref)
+        for (const char *c = opra_skip_categories_pref; '\0' != *c; c++)
+            opra_category_skipped[(uint8_t) *c] = true;
+
+    /*messages of unknown categories can't be stepped over, they still stop the walk*/
+    for (unsigned i = 0; i < array_length(opra_category_skipped); i++)
+        if (!(opra_category_lookup((uint8_t) i)->flags & OPRA_CATEGORY_KNOWN))
+            opra_category_skipped[i] = false;
+}
+
+static inline unsigned opra_watchlist_slot(uint64_t key)
+{
+    return (unsigned) ((key * UINT64_C(0x9E3779B97F4A7C15)) >> 40) & opra_watchlist_mask;
+}
+
+static bool opra_watchlist_contains(uint64_t key)
+{
+    for (unsigned slot = opra_watchlist_slot(key); 0 != opra_watchlist[slot]; slot = (slot + 1) & opra_watchlist_mask)
+        if (key == opra_watchlist[slot])
+            return true;
+    return false;
+}
+
+static void opra_watchlist_insert(uint64_t key)
+{
+    unsigned slot = opra_watchlist_slot(key);
+    while ((0 != opra_watchlist[slot]) && (key != opra_watchlist[slot]))
+        slot = (slot + 1) & opra_watchlist_mask;
+    opra_watchlist[slot] = key;
+}
+
+/*pack a space padded root, short quote roots are 4 bytes*/
+static inline uint64_t opra_watchlist_root_key(const uint8_t *symbol, unsigned length)
+{
+    uint64_t key = 0;
+    for (unsigned i = 0; i < OPRA_SECURITY_SYMBOL_SIZE; i++)
+        key = (key << 8) | ((i < length) ? symbol[i] : ' ');
+    return key;
+}
+
+static void opra_update_watchlist(void)
+{
+    wmem_free(wmem_epan_scope(), opra_watchlist);
+    opra_watchlist = NULL;
+    opra_watchlist_mask = 0;
+    opra_watchlist_ids = 0;
+
+    if ((NULL == opra_watchlist_pref) || ('\0' == opra_watchlist_pref[0]))
+        return;
+
+    char **entries = g_strsplit_set(opra_watchlist_pref, ", \t", -1);
+    unsigned count = 0;
+    for (char **entry = entries; NULL != *entry; entry++)
+        if ('\0' != **entry)
+            count++;
+
+    /*at most half full keeps the probes short*/
+    unsigned slots = 4;
+    while (slots < 2 * count)
+        slots *= 2;
+    opra_watchlist = wmem_alloc0_array(wmem_epan_scope(), uint64_t, slots);
+    opra_watchlist_mask = slots - 1;
+
+    for (char **entry = entries; NULL != *entry; entry++){
+        const char *text = *entry;
+        const size_t length = strlen(text);
+        if (0 == length)
+            continue;
+
+        if (g_ascii_isdigit(text[0])){
+            opra_watchlist_insert(OPRA_WATCH_INSTRUMENT_ID | g_ascii_strtoull(text, NULL, 10));
+            opra_watchlist_ids++;
+        } else if (length <= OPRA_SECURITY_SYMBOL_SIZE){
+            uint8_t root[OPRA_SECURITY_SYMBOL_SIZE];
+            for (size_t i = 0; i < length; i++)
+                root[i] = (uint8_t) g_ascii_toupper(text[i]);
+            opra_watchlist_insert(opra_watchlist_root_key(root, (unsigned) length));
+        }
+    }
+    g_strfreev(entries);
+}
+
+void proto_reg_handoff_opra(void)
+{
+    static bool initialized = false;
+
+    if (!initialized){
+        heur_dissector_add("udp", dissect_opra_heur, "OPRA over UDP", "opra_udp", proto_opra, HEURISTIC_DISABLE);
+        heur_dissector_add("tcp", dissect_opra_heur_tcp, "OPRA over TCP", "opra_tcp", proto_opra, HEURISTIC_DISABLE);
+        stats_tree_register("opra", "opra", "OPRA/Messages", 0, opra_stats_tree_packet, opra_stats_tree_init, NULL);
+        stats_tree_register("opra", "opra_latency", "OPRA/Latency", 0, opra_latency_stats_tree_packet, opra_latency_stats_tree_init, NULL);
+        register_stat_tap_table_ui(&opra_burst_stat_table);
+        register_stat_tap_table_ui(&opra_index_stat_table);
+        register_stat_tap_table_ui(&opra_index_line_stat_table);
+        register_stat_tap_table_ui(&opra_memory_stat_table);
+#ifdef OPRA_PERF
+        register_stat_tap_table_ui(&opra_perf_stat_table);
+#endif
+        register_stat_tap_ui(&opra_export_ui, NULL);
+        register_stat_tap_ui(&opra_records_ui, NULL);
+        initialized = true;
+    } else {
+        dissector_delete_uint_range("udp.port", opra_udp_range, opra_handle);
+        wmem_free(wmem_epan_scope(), opra_udp_range);
+        dissector_delete_uint_range("tcp.port", opra_tcp_range, opra_tcp_handle);
+        wmem_free(wmem_epan_scope(), opra_tcp_range);
+    }
+
+    opra_udp_range = range_copy(wmem_epan_scope(), global_opra_udp_range);
+    dissector_add_uint_range("udp.port", opra_udp_range, opra_handle);
+    opra_tcp_range = range_copy(wmem_epan_scope(), global_opra_tcp_range);
+    dissector_add_uint_range("tcp.port", opra_tcp_range, opra_tcp_handle);
+
+    opra_clock_offset_ns = (NULL != opra_clock_offset_pref) ? g_ascii_strtoll(opra_clock_offset_pref, NULL, 10) : 0;
+    opra_update_category_filter();
+    opra_update_watchlist();
+}
+
+/*true if tvb starts with a plausible block of no more than its length, all a TCP segment can be asked for.
+  Only the fixed block header is checked, so non OPRA payloads are turned away after a handful of byte compares.*/
+static bool opra_heur_first_block(tvbuff_t *tvb)
+{
+    if (tvb_captured_length(tvb) < OPRA_BLOCK_HEADER_SIZE)
+        return false;
+
+    const unsigned block_size = tvb_get_ntohs(tvb, OPRA_BLOCK_SIZE_OFFSET);
+    if (block_size > tvb_reported_length(tvb))
+        return false;
+
+    return opra_block_is_plausible(tvb_get_ptr(tvb, 0, OPRA_BLOCK_HEADER_SIZE), block_size, (uint8_t) opra_heur_version);
+}
+
+/*true if tvb starts with a plausible block and its block sizes add up to exactly its reported length, as a
+  datagram holds whole blocks.  Only the block size of each block after the first is read.*/
+static bool opra_heur_datagram(tvbuff_t *tvb)
+{
+    if (!opra_heur_first_block(tvb))
+        return false;
+
+    const unsigned length = tvb_reported_length(tvb);
+    unsigned offset = 0;
+    while (offset < length){
+        if (!tvb_bytes_exist(tvb, offset + OPRA_BLOCK_SIZE_OFFSET, 2))
+            return false;
+        const unsigned block_size = tvb_get_ntohs(tvb, offset + OPRA_BLOCK_SIZE_OFFSET);
+        if (block_size < OPRA_BLOCK_HEADER_SIZE)
+            return false;
+        offset += block_size;
+    }
+    return offset == length;
+}
+
+/*Heuristic UDP dissector, the datagram must be made of whole blocks*/
+static bool dissect_opra_heur(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
+{
+    if (!opra_heur_datagram(tvb))
+        return false;
+
+    dissect_opra(tvb, pinfo, tree, data);
+    return true;
+}
+
+/*Heuristic TCP dissector.  Once a segment starts with a block the rest of the connection is taken as OPRA,
+  so later segments starting mid block still find their boundaries.*/
+static bool dissect_opra_heur_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
+{
+    if (!opra_heur_first_block(tvb))
+        return false;
+
+    conversation_set_dissector(find_or_create_conversation(pinfo), opra_tcp_handle);
+    dissect_opra_tcp(tvb, pinfo, tree, data);
+    return true;
+}
+
+/*Checksum of the whole block, false if the block wasn't captured in full*/
+static bool opra_compute_checksum(const opra_block *block, uint16_t *checksum)
+{
+    const int block_size = block->hdr.block_size;
+    if ((block_size < OPRA_BLOCK_HEADER_SIZE) || (block_size > block->length))
+        return false;
+
+    OPRA_PERF_ENTER(perf_left, OPRA_PERF_STAGE_CHECKSUM);
+    *checksum = opra_block_checksum(block->data, (size_t) block_size);
+    OPRA_PERF_LEAVE(perf_left);
+    return true;
+}
+
+#ifdef OPRA_PERF
+/*the message iterator, timed and counted*/
+static opra_decode_status opra_walk_next(opra_message_iter *iter, opra_message *msg)
+{
+    OPRA_PERF_ENTER(perf_left, OPRA_PERF_STAGE_WALK);
+    const int offset = iter->offset;
+    const opra_decode_status status = opra_message_iter_next(iter, msg);
+    opra_perf_message(iter, offset, status);
+    OPRA_PERF_LEAVE(perf_left);
+    return status;
+}
+
+static opra_decode_status opra_walk_skip(opra_message_iter *iter)
+{
+    OPRA_PERF_ENTER(perf_left, OPRA_PERF_STAGE_WALK);
+    const int offset = iter->offset;
+    const opra_decode_status status = opra_message_iter_skip(iter);
+    opra_perf_message(iter, offset, status);
+    OPRA_PERF_LEAVE(perf_left);
+    return status;
+}
+
+static opra_decode_status opra_walk_resync(opra_message_iter *iter, int *length)
+{
+    OPRA_PERF_ENTER(perf_left, OPRA_PERF_STAGE_WALK);
+    const opra_decode_status status = opra_message_iter_resync(iter, length);
+    OPRA_PERF_LEAVE(perf_left);
+    return status;
+}
+#else
+#define opra_walk_next opra_message_iter_next
+#define opra_walk_skip opra_message_iter_skip
+#define opra_walk_resync opra_message_iter_resync
+#endif
+
+/*everything the message is applied to whether or not it gets a tree, in message order*/
+static opra_instrument *opra_apply_message(packet_info *pinfo, const opra_block *block, const opra_message *msg, unsigned block_number,
+    unsigned index, bool duplicate, bool updates_book, bool tapping)
+{
+    OPRA_PERF_ENTER(perf_left, OPRA_PERF_STAGE_INSTRUMENT);
+    opra_instrument *instrument = opra_intern_instrument(pinfo, msg);
+    if (updates_book){
+        OPRA_PERF_SWITCH(OPRA_PERF_STAGE_BOOK);
+        opra_summary_note_message(msg);
+        opra_book_update(pinfo, msg, block_number, index, instrument);
+    }
+    if (tapping){
+        OPRA_PERF_SWITCH(OPRA_PERF_STAGE_TAP);
+        opra_tap_message(pinfo, block, msg, index, duplicate, instrument);
+    }
+    OPRA_PERF_LEAVE(perf_left);
+    return instrument;
+}
+
+#ifdef OPRA_CROSSCHECK
+/*Differential check of the fast paths against the full decode, built with the OPRA_CROSSCHECK CMake option.
+  Every block is walked twice more, by length alone as the tree-less and skip paths do and by a full decode, which
+  must find the same messages at the same offsets.  The control message scan, appendage counts and the vector
+  checksum kernel are checked the same way.  A disagreement is a dissector bug, DISSECTOR_ASSERT shows it in the tree
+  and under fuzzshark aborts so the fuzzer keeps the input, e.g. for a directory of single block datagrams:
+      FUZZSHARK_TARGET=opra WIRESHARK_ABORT_ON_DISSECTOR_BUG=1 fuzzshark test/corpus/
+  opra_fuzz runs the same walks over the decode core alone, and the opra_tshark_records test compares what the
+  fast paths tap with the tree path's.  Slow, for fuzzing and regression runs only.*/
+static void opra_crosscheck_block(const opra_block *block)
+{
+    opra_message_iter skip_iter, decode_iter;
+    opra_message msg;
+    bool reset = false;
+    opra_message_iter_init(&skip_iter, block);
+    opra_message_iter_init(&decode_iter, block);
+
+    for (;;){
+        const int offset = decode_iter.offset;
+        opra_decode_status skip_status = opra_message_iter_skip(&skip_iter);
+        opra_decode_status decode_status = opra_message_iter_next(&decode_iter, &msg);
+        DISSECTOR_ASSERT(skip_status == decode_status);
+
+        if (OPRA_DECODE_UNKNOWN_CATEGORY == decode_status){
+            int skip_len, decode_len;
+            skip_status = opra_message_iter_resync(&skip_iter, &skip_len);
+            decode_status = opra_message_iter_resync(&decode_iter, &decode_len);
+            DISSECTOR_ASSERT(skip_status == decode_status);
+            DISSECTOR_ASSERT((OPRA_DECODE_OK != decode_status) || (skip_len == decode_len));
+        } else if (OPRA_DECODE_OK == decode_status){
+            int length;
+            DISSECTOR_ASSERT(msg.offset == offset);
+            DISSECTOR_ASSERT(OPRA_DECODE_OK == opra_message_length(block->data + offset, block->length - offset, &length));
+            DISSECTOR_ASSERT((length == msg.length) && (offset + msg.length == decode_iter.offset));
+            if (opra_category_lookup(msg.hdr.message_category)->flags & OPRA_CATEGORY_QUOTE)
+                DISSECTOR_ASSERT(msg.appendage_count == opra_quote_appendage_count(msg.hdr.message_indicator));
+            if (('H' == msg.hdr.message_category) && (OPRA_MSG_CAT_H_RESET_BLOCK_SEQUENCE_NUMBER == msg.hdr.message_type))
+                reset = true;
+        }
+        DISSECTOR_ASSERT((skip_iter.offset == decode_iter.offset) && (skip_iter.index == decode_iter.index));
+        if (OPRA_DECODE_OK != decode_status)
+            break;
+    }
+    DISSECTOR_ASSERT(reset == opra_block_has_message(block, 'H', OPRA_MSG_CAT_H_RESET_BLOCK_SEQUENCE_NUMBER));
+
+    const int block_size = block->hdr.block_size;
+    if ((block_size >= OPRA_BLOCK_HEADER_SIZE) && (block_size <= block->length))
+        DISSECTOR_ASSERT(opra_block_checksum(block->data, (size_t) block_size) == opra_block_checksum_scalar(block->data, (size_t) block_size));
+}
+#endif
+
+/*Info column summary of each block, e.g. "Seq=1201 Msgs=30 q=26 k=3 a=1 SPY [Gap 4]".  The message walk notes
+  every message's category and the first symbol as it decodes or skips it, so the packet list needs no tree.
+  Only filled when there are columns to write.*/
+struct _opra_block_summary {
+    bool decoded;                   /*the block header could be read*/
+    opra_block_header hdr;
+    const opra_sequence_info *sequence;
+    bool duplicate;                 /*the other feed's copy arrived first*/
+    uint8_t category_counts[256];   /*blocks hold at most 255 messages*/
+    const uint8_t *symbol;          /*space padded, of the first message that has one*/
+    unsigned symbol_length;
+};
+
+/*categories in the order the summary lists them, the busiest first*/
+static const uint8_t opra_block_summary_categories[] = { 'q', 'k', 'a', 'd', 'f', 'Y', 'H', 'C' };
+
+static void opra_block_summary_init(opra_block_summary *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+}
+
+/*count the message the iterator is at, before it decodes or skips it*/
+static inline void opra_block_summary_note(opra_block_summary *summary, const opra_message_iter *iter)
+{
+    uint8_t message_category;
+    if ((NULL == summary) || !opra_message_iter_peek_category(iter, &message_category))
+        return;
+
+    summary->category_counts[message_category]++;
+    if (NULL != summary->symbol)
+        return;
+
+    unsigned length;
+    switch (message_category){
+        case 'Y': case 'a': case 'd': case 'f': case 'k':
+            length = OPRA_SECURITY_SYMBOL_SIZE;
+            break;
+        case 'q':
+            length = OPRA_SHORT_SECURITY_SYMBOL_SIZE;
+            break;
+        default:
+            return;
+    }
+    const int symbol_offset = iter->offset + OPRA_MESSAGE_HEADER_SIZE;
+    if (symbol_offset + (int) length > iter->block->length)
+        return;
+    summary->symbol = iter->block->data + symbol_offset;
+    summary->symbol_length = length;
+}
+
+/*append the block's summary to the frame's, blocks after the first separated by " | "*/
+static void opra_block_summary_append(wmem_strbuf_t *info, const opra_block_summary *summary)
+{
+    if (0 != wmem_strbuf_get_len(info))
+        wmem_strbuf_append(info, " | ");
+    if (!summary->decoded){
+        wmem_strbuf_append(info, "[Truncated Block]");
+        return;
+    }
+
+    wmem_strbuf_append_printf(info, "Seq=%u Msgs=%u", summary->hdr.block_sequence_number, summary->hdr.messages_in_block);
+
+    unsigned listed = 0;
+    unsigned counted = 0;
+    for (unsigned i = 0; i < 256; i++)
+        counted += summary->category_counts[i];
+    for (unsigned i = 0; i < array_length(opra_block_summary_categories); i++){
+        const unsigned count = summary->category_counts[opra_block_summary_categories[i]];
+        if (0 != count)
+            wmem_strbuf_append_printf(info, " %c=%u", opra_block_summary_categories[i], count);
+        listed += count;
+    }
+    if (counted != listed)
+        wmem_strbuf_append_printf(info, " ?=%u", counted - listed);
+
+    if (NULL != summary->symbol){
+        unsigned length = summary->symbol_length;
+        while ((length > 0) && (' ' == summary->symbol[length - 1]))
+            length--;
+        wmem_strbuf_append_c(info, ' ');
+        for (unsigned i = 0; i < length; i++)
+            wmem_strbuf_append_c(info, g_ascii_isprint(summary->symbol[i]) ? (char) summary->symbol[i] : '.');
+    }
+
+    if ('V' == summary->hdr.retransmission_indicator)
+        wmem_strbuf_append(info, " [Retransmission]");
+    if (NULL != summary->sequence){
+        switch (summary->sequence->status){
+            case OPRA_SEQUENCE_GAP:
+                wmem_strbuf_append_printf(info, " [Gap %u]", summary->sequence->gap_size);
+                break;
+            case OPRA_SEQUENCE_DUPLICATE:
+                wmem_strbuf_append(info, " [Sequence Duplicate]");
+                break;
+            case OPRA_SEQUENCE_RESET:
+                wmem_strbuf_append(info, " [Sequence Reset]");
+                break;
+            default:
+                break;
+        }
+    }
+    if (summary->duplicate)
+        wmem_strbuf_append(info, " [Feed Duplicate]");
+}
+
+/*A datagram, or a record of a recorded file handed over by name, holds back to back blocks, each delimited by
+  its block size.  Dissemination sends one block per datagram.*/
+static int dissect_opra(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
+{
+    OPRA_PERF_BEGIN();
+
+    /*set protocol column*/
+    col_set_str(pinfo->cinfo, COL_PROTOCOL, "OPRA");
+
+    /*the info column is built up block by block and set once*/
+    col_clear(pinfo->cinfo, COL_INFO);
+    wmem_strbuf_t *info = (NULL != pinfo->cinfo) ? wmem_strbuf_new_sized(pinfo->pool, 128) : NULL;
+    opra_block_summary summary;
+
+    const int length = tvb_reported_length(tvb);
+    int offset = 0;
+    int consumed = 0;
+    unsigned block_in_tvb = 0;
+    while (offset < length){
+        const int remaining = length - offset;
+        if (remaining < OPRA_BLOCK_HEADER_SIZE){
+            proto_tree_add_expert(tree, pinfo, &hf_opra_exp_block_truncated, tvb, offset, remaining);
+            consumed += remaining;
+            break;
+        }
+
+        /*a block size that can't be right leaves the rest to the block, for its errors to be shown*/
+        int block_size = tvb_get_ntohs(tvb, offset + OPRA_BLOCK_SIZE_OFFSET);
+        if ((block_size < OPRA_BLOCK_HEADER_SIZE) || (block_size > remaining))
+            block_size = remaining;
+
+        tvbuff_t *block_tvb = tvb_new_subset_length(tvb, offset, block_size);
+        consumed += dissect_opra_block(block_tvb, pinfo, tree, OPRA_BLOCK_NUMBER(pinfo, block_in_tvb), (NULL != info) ? &summary : NULL);
+        if (NULL != info){
+            OPRA_PERF_ENTER(perf_left, OPRA_PERF_STAGE_INFO);
+            opra_block_summary_append(info, &summary);
+            OPRA_PERF_LEAVE(perf_left);
+        }
+        offset += block_size;
+        block_in_tvb++;
+    }
+
+    if (NULL != info)
+        col_add_str(pinfo->cinfo, COL_INFO, wmem_strbuf_get_str(info));
+    OPRA_PERF_END();
+    return consumed;
+}
+
+static unsigned get_opra_block_len(packet_info *pinfo _U_, tvbuff_t *tvb, int offset, void *data _U_)
+{
+    return tvb_get_ntohs(tvb, offset + OPRA_BLOCK_SIZE_OFFSET);
+}
+
+/*each PDU appends its block's summary, as TCP hands them over one at a time*/
+static int dissect_opra_tcp_pdu(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data _U_)
+{
+    OPRA_PERF_BEGIN();
+    opra_block_summary summary;
+    dissect_opra_block(tvb, pinfo, tree, OPRA_BLOCK_NUMBER(pinfo, 0), (NULL != pinfo->cinfo) ? &summary : NULL);
+    if (NULL != pinfo->cinfo){
+        OPRA_PERF_SWITCH(OPRA_PERF_STAGE_INFO);
+        wmem_strbuf_t *info = wmem_strbuf_new_sized(pinfo->pool, 128);
+        opra_block_summary_append(info, &summary);
+        col_append_sep_str(pinfo->cinfo, COL_INFO, " | ", wmem_strbuf_get_str(info));
+    }
+    OPRA_PERF_END();
+    return tvb_reported_length(tvb);
+}
+
+/*A TCP stream of back to back blocks, one PDU each.  Blocks split across segments are reassembled.*/
+static int dissect_opra_tcp(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, void* data)
+{
+    col_set_str(pinfo->cinfo, COL_PROTOCOL, "OPRA");
+    col_clear(pinfo->cinfo, COL_INFO);
+
+    tcp_dissect_pdus(tvb, pinfo, tree, opra_desegment, OPRA_BLOCK_SIZE_OFFSET + 2, get_opra_block_len, dissect_opra_tcp_pdu, data);
+    return tvb_reported_length(tvb);
+}
+
+/*Dissect one block, tvb holding exactly the block.  summary, if not NULL, is filled in for the info column.*/
+static int dissect_opra_block(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, unsigned block_number, opra_block_summary *summary)
+{
+    /*the block's own stage until its tree is started, the caller's stage is whatever the last block left*/
+    OPRA_PERF_SWITCH(OPRA_PERF_STAGE_BLOCK);
+    if (NULL != summary)
+        opra_block_summary_init(summary);
+
+    /*the decode core checks the bounds of every message against the captured block, fetched here in one go*/
+    const int block_len = tvb_captured_length(tvb);
+    opra_block block;
+    if (OPRA_DECODE_OK != opra_decode_block(tvb_get_ptr(tvb, 0, block_len), block_len, &block)){
+        proto_tree_add_expert(tree, pinfo, &hf_opra_exp_block_truncated, tvb, 0, block_len);
+        return block_len;
+    }
+    const opra_block_header *block_header = &block.hdr;
+#ifdef OPRA_CROSSCHECK
+    opra_crosscheck_block(&block);
+#endif
+
+    OPRA_PERF_ENTER(perf_left, OPRA_PERF_STAGE_SEQUENCE);
+    const opra_sequence_info *sequence_info = opra_track_sequence(pinfo, &block, block_number);
+    const opra_arbitration_info *arbitration_info = opra_arbitrate(pinfo, &block, block_number);
+    OPRA_PERF_LEAVE(perf_left);
+    const bool skip_messages = opra_skip_duplicate_messages && (NULL != arbitration_info) && arbitration_info->duplicate;
+    if (NULL != summary){
+        summary->decoded = true;
+        summary->hdr = *block_header;
+        summary->sequence = sequence_info;
+        summary->duplicate = (NULL != arbitration_info) && arbitration_info->duplicate;
+    }
+
+    /*nobody will look at the labels, so only walk the message boundaries*/
+    if (!tree){
+        uint16_t checksum;
+        if (opra_check_checksum && opra_compute_checksum(&block, &checksum) && (checksum != block_header->checksum))
+            expert_add_info(pinfo, NULL, &hf_opra_exp_checksum_bad);
+        dissect_opra_sequence(tvb, pinfo, NULL, NULL, sequence_info);
+        dissect_opra_arbitration(tvb, pinfo, NULL, arbitration_info);
+        if (skip_messages)
+            return block_len;
+        return dissect_opra_no_tree(tvb, pinfo, &block, block_number, (NULL != arbitration_info) && arbitration_info->duplicate, summary);
+    }
+
+    /*everything from here on that isn't a stage of its own is building the tree*/
+    OPRA_PERF_SWITCH(OPRA_PERF_STAGE_TREE);
+
+    /*0, -1 means we consume all the remaining tvb*/
+    proto_item *ti = proto_tree_add_item(tree, proto_opra, tvb, 0, -1, ENC_NA);
+
+    /*add the opra protocol tree*/
+    proto_tree *opra_tree = proto_item_add_subtree(ti, ett_opra);
+
+    /*first item in the tree is the version number*/
+    int offset = 0;
+    int len = 1;
+    proto_tree_add_uint(opra_tree, hf_opra_version, tvb, offset, len, block_header->version);
+    offset += len;
+
+    /*block size*/
+    len = 2;
+    proto_tree_add_uint(opra_tree, hf_opra_block_size, tvb, offset, len, block_header->block_size);
+    offset += len;
 
     /*data feed indicator*/
     len = 1;
-    proto_tree_add_item(opra_tree, hf_opra_data_feed_indicator, tvb, offset, len, ENC_BIG_ENDIAN);
+    proto_tree_add_uint(opra_tree, hf_opra_data_feed_indicator, tvb, offset, len, block_header->data_feed_indicator);
     offset += len;
 
     /*retransmission indicator*/
     len = 1;
-    proto_tree_add_item(opra_tree, hf_opra_retransmission_indicator, tvb, offset, len, ENC_BIG_ENDIAN);
+    proto_tree_add_uint(opra_tree, hf_opra_retransmission_indicator, tvb, offset, len, block_header->retransmission_indicator);
     offset += len;
 
     /*session indicator*/
     /*either contains an ASCII character or 0x00, treat as hex number*/
     len = 1;
-    proto_tree_add_item(opra_tree, hf_opra_session_indicator, tvb, offset, len, ENC_BIG_ENDIAN);
+    proto_tree_add_uint(opra_tree, hf_opra_session_indicator, tvb, offset, len, block_header->session_indicator);
     offset += len;
 
     /*block sequence number*/
     len = 4;
-    proto_tree_add_item(opra_tree, hf_opra_block_sequence_number, tvb, offset, len, ENC_BIG_ENDIAN);
+    ti = proto_tree_add_uint(opra_tree, hf_opra_block_sequence_number, tvb, offset, len, block_header->block_sequence_number);
+    dissect_opra_sequence(tvb, pinfo, opra_tree, ti, sequence_info);
     offset += len;
 
     /*messages in block*/
     len = 1;
-
-    /*function returns a uint32_t, though our field is actually 1 byte*/
-    uint32_t message_count;
-    proto_tree_add_item_ret_uint(opra_tree, hf_opra_messages_in_block, tvb, offset, len, ENC_BIG_ENDIAN, &message_count);
+    proto_tree_add_uint(opra_tree, hf_opra_messages_in_block, tvb, offset, len, block_header->messages_in_block);
     offset += len;
 
     /*block timestamp*/
     len = 8;
     nstime_t timestamp;
-    int endoff, err;
-    proto_tree_add_time_item(opra_tree, hf_opra_block_timestamp, tvb, offset, len, ENC_TIME_SECS_NSECS, &timestamp, &endoff, &err);
+    timestamp.secs = block_header->timestamp_secs;
+    timestamp.nsecs = block_header->timestamp_nsecs;
+    proto_tree_add_time(opra_tree, hf_opra_block_timestamp, tvb, offset, len, &timestamp);
+    ti = proto_tree_add_int64(opra_tree, hf_opra_latency, tvb, offset, len, opra_latency_ns(pinfo, block_header));
+    proto_item_set_generated(ti);
     offset += len;
 
     /*block checksum*/
     len = 2;
-    ti = proto_tree_add_item(opra_tree, hf_opra_block_checksum, tvb, offset, len, ENC_BIG_ENDIAN);
+    uint16_t checksum;
+    if (opra_check_checksum && opra_compute_checksum(&block, &checksum))
+        ti = proto_tree_add_checksum(opra_tree, tvb, offset, hf_opra_block_checksum, hf_opra_block_checksum_status, &hf_opra_exp_checksum_bad,
+            pinfo, checksum, ENC_BIG_ENDIAN, PROTO_CHECKSUM_VERIFY);
+    else
+        ti = proto_tree_add_checksum(opra_tree, tvb, offset, hf_opra_block_checksum, hf_opra_block_checksum_status, &hf_opra_exp_checksum_bad,
+            pinfo, 0, ENC_BIG_ENDIAN, PROTO_CHECKSUM_NO_FLAGS);
     offset += len;
 
+    dissect_opra_arbitration(tvb, pinfo, opra_tree, arbitration_info);
+    if (skip_messages)
+        return block_len;
+
     /*now process the messages, one by one*/
-    for (uint32_t i = 0; i < message_count; i++)
+    const bool tapping = have_tap_listener(opra_tap);
+    const bool duplicate = (NULL != arbitration_info) && arbitration_info->duplicate;
+    const bool updates_book = opra_block_updates_book(pinfo, &block, duplicate);
+    /*unwatched messages only need decoding if something other than the tree wants their values*/
+    const bool needs_values = tapping || !PINFO_FD_VISITED(pinfo) || (0 != opra_watchlist_ids);
+    unsigned skipped = 0;
+    unsigned unwatched = 0;
+    opra_message_iter iter;
+    opra_message_iter_init(&iter, &block);
+    for (;;)
     {
-        proto_tree *message_tree = proto_tree_add_subtree(opra_tree, tvb, offset, OPRA_MESSAGE_HEADER_SIZE, ett_opra_message_header, NULL, "Message Header");
+        opra_message msg;
+        opra_decode_status status;
+        opra_block_summary_note(summary, &iter);
+        const bool watched = (NULL == opra_watchlist) || opra_watchlist_root_matches(&iter);
+        if (opra_message_skipped(&iter) || (!watched && !needs_values)){
+            opra_summary_note_skipped(&iter, updates_book);
+            status = opra_walk_skip(&iter);
+            if (OPRA_DECODE_OK == status){
+                offset = iter.offset;
+                if (watched)
+                    skipped++;
+                else
+                    unwatched++;
+                continue;
+            }
+        } else {
+            status = opra_walk_next(&iter, &msg);
+        }
+        if (OPRA_DECODE_END == status)
+            break;
 
-        len = 1;
-        uint32_t participant_id;
-        proto_tree_add_item_ret_uint(message_tree, hf_opra_msg_hdr_participant_id, tvb, offset, len, ENC_BIG_ENDIAN, &participant_id);
-        offset += len;
+        if (OPRA_DECODE_TRUNCATED == status){
+            proto_tree_add_expert(opra_tree, pinfo, &hf_opra_exp_block_truncated, tvb, offset, block_len - offset);
+            return block_len;
+        }
 
-        len = 1;
-        /*message category is a uint8_t containing a single char, per the spec*/
-        uint32_t message_category;
-        proto_tree_add_item_ret_uint(message_tree, hf_opra_msg_hdr_message_category, tvb, offset, len, ENC_BIG_ENDIAN, &message_category);
-        offset += len;
+        if (OPRA_DECODE_UNKNOWN_CATEGORY == status){
+            /*show the header whether or not the message was to be skipped, the skip didn't decode it*/
+            (void) opra_decode_message(&block, offset, &msg);
+            const int message_offset = offset;
+            proto_item *message_item;
+            proto_tree *message_tree = proto_tree_add_subtree(opra_tree, tvb, offset, OPRA_MESSAGE_HEADER_SIZE, ett_opra_message_header, &message_item, "Message Header");
+            offset = dissect_opra_message_header(tvb, offset, message_tree, &msg);
+            proto_tree_add_expert(message_tree, pinfo, &hf_opra_exp_unknown_category, tvb, message_offset + OPRA_MESSAGE_CATEGORY_OFFSET, 1);
+
+            int message_len;
+            if (OPRA_DECODE_OK != opra_walk_resync(&iter, &message_len)){
+                /*no length fits, the rest of the block can't be found*/
+                proto_tree_add_expert(opra_tree, pinfo, &hf_opra_exp_block_length_error, tvb, offset, block_len - offset);
+                return offset;
+            }
+            proto_item_set_len(message_item, message_len);
+            proto_item *length_item = proto_tree_add_uint(message_tree, hf_opra_msg_unknown_length, tvb, message_offset, message_len, message_len);
+            proto_item_set_generated(length_item);
+            expert_add_info(pinfo, length_item, &hf_opra_exp_unknown_length_guessed);
+            if (message_len > OPRA_MESSAGE_HEADER_SIZE)
+                proto_tree_add_item(message_tree, hf_opra_msg_unknown_data, tvb, offset, message_len - OPRA_MESSAGE_HEADER_SIZE, ENC_NA);
+            offset = iter.offset;
+            continue;
+        }
 
-        len = 1;
-        //proto_tree_add_item(message_tree, hf_opra_msg_hdr_message_type, tvb, offset, len, ENC_BIG_ENDIAN);
-        uint8_t message_type = tvb_get_uint8(tvb, offset);
-        const char *description = GetMessageTypeDescription(message_category, message_type);
-        proto_tree_add_string_format_value(message_tree, hf_opra_msg_hdr_message_type, tvb, offset, 1, description,
-            "(%c), (%c), %s", message_category, message_type, description);
-        offset += len;
+        if (!watched && (OPRA_DECODE_OK == status)){
+            opra_instrument *instrument = opra_apply_message(pinfo, &block, &msg, block_number, iter.index - 1, duplicate, updates_book, tapping);
 
-        len = 1;
-        uint32_t message_indicator = tvb_get_uint8(tvb, offset);
-        if ((message_category == 'q') || (message_category == 'k')){
-            const char *str = val_to_str(message_indicator, hf_opra_message_indicators, "unknown indicator");
-            proto_tree_add_string(message_tree, hf_opra_msg_hdr_message_indicator, tvb, offset, len, str);
-        } else {
-            if (message_indicator == ' ') {
-                proto_tree_add_string(message_tree, hf_opra_msg_hdr_message_indicator, tvb, offset, len, "N/A");
-            } else {
-                proto_tree_add_string(message_tree, hf_opra_msg_hdr_message_indicator, tvb, offset, len, "invalid");
+            if ((NULL == instrument) || !opra_watchlist_contains(OPRA_WATCH_INSTRUMENT_ID | instrument->id)){
+                offset = iter.offset;
+                unwatched++;
+                continue;
             }
+
+            /*watched by instrument ID, already tapped and applied*/
+            proto_tree *message_tree = proto_tree_add_subtree(opra_tree, tvb, offset, OPRA_MESSAGE_HEADER_SIZE, ett_opra_message_header, NULL, "Message Header");
+            offset = dissect_opra_message_header(tvb, offset, message_tree, &msg);
+            offset = dissect_opra_message_body(tvb, offset, message_tree, block.data + offset, opra_message_layouts[msg.hdr.message_category], &block, instrument);
+            offset = dissect_opra_quote_appendages(tvb, offset, message_tree, &msg);
+            dissect_opra_instrument(tvb, pinfo, message_tree, &msg, instrument);
+            dissect_opra_book(tvb, pinfo, message_tree, &msg, block_number, iter.index - 1, instrument);
+            continue;
         }
-        offset += len;
 
-        len = 4;
-        proto_tree_add_item(message_tree, hf_opra_msg_hdr_transaction_id, tvb, offset, len, ENC_BIG_ENDIAN);
-        offset += len;
+        proto_tree *message_tree = proto_tree_add_subtree(opra_tree, tvb, offset, OPRA_MESSAGE_HEADER_SIZE, ett_opra_message_header, NULL, "Message Header");
+        offset = dissect_opra_message_header(tvb, offset, message_tree, &msg);
 
-        len = 4;
-        proto_tree_add_item(message_tree, hf_opra_msg_hdr_participant_reference_number, tvb, offset, len, ENC_BIG_ENDIAN);
-        offset += len;
+        opra_instrument *instrument = opra_apply_message(pinfo, &block, &msg, block_number, iter.index - 1, duplicate, updates_book, tapping);
 
-        switch(message_category)
-        {
-            case 'C':{
-                offset = dissect_opra_message_category_C(tvb, offset, pinfo, message_tree, data);
-                break;
-            }
-            case 'H':{
-                /*nothing further to do*/
-                break;
-            }
-            case 'Y':{
-                offset = dissect_opra_message_category_Y(tvb, offset, pinfo, message_tree, data);
-                break;
-            }
-            case 'a':{
-                offset = dissect_opra_message_category_a(tvb, offset, pinfo, message_tree, data);
-                break;
-            }
-            case 'd':{
-                offset = dissect_opra_message_category_d(tvb, offset, pinfo, message_tree, data);
-                break;
-            }
-            case 'k':{
-                offset = dissect_opra_message_category_k(tvb, offset, pinfo, message_tree, data);
-                offset = dissect_opra_quote_appendage(tvb, offset, pinfo, message_tree, data, message_indicator);
-                break;
-            }
-            case 'q':{
-                offset = dissect_opra_message_category_q(tvb, offset, pinfo, message_tree, data);
-                offset = dissect_opra_quote_appendage(tvb, offset, pinfo, message_tree, data, message_indicator);
-                break;
-            }
-            default:{
-                /*unrecognized message category, have to skip the remainder of the block as we don't can't determine message length*/
-                //return tvb_captured_length(tvb);
-                return offset;
-                break;
-            }
+        const opra_message_layout *layout = opra_message_layouts[msg.hdr.message_category];
+        if (NULL != layout){
+            offset = dissect_opra_message_body(tvb, offset, message_tree, block.data + offset, layout, &block, instrument);
+            offset = dissect_opra_quote_appendages(tvb, offset, message_tree, &msg);
+            dissect_opra_instrument(tvb, pinfo, message_tree, &msg, instrument);
+            dissect_opra_book(tvb, pinfo, message_tree, &msg, block_number, iter.index - 1, instrument);
+        } else {
+            offset = dissect_opra_message_category_C(tvb, offset, message_tree, &msg);
         }
     }
+
+    if (0 != skipped){
+        proto_item *skipped_item = proto_tree_add_uint(opra_tree, hf_opra_skipped_messages, tvb, 0, 0, skipped);
+        proto_item_set_generated(skipped_item);
+    }
+    if (0 != unwatched){
+        proto_item *unwatched_item = proto_tree_add_uint(opra_tree, hf_opra_unwatched_messages, tvb, 0, 0, unwatched);
+        proto_item_set_generated(unwatched_item);
+    }
+
     //if block was an odd number of bytes, there will be a block pad byte here
     if (0 != offset % 2){
         len = 1;
@@ -1154,261 +4817,763 @@ static int dissect_opra(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, voi
     return offset;
 }
 
-static int dissect_opra_message_category_C(tvbuff_t *tvb, int offset, packet_info *pinfo _U_, proto_tree *tree, void* data _U_)
+/*Walk the block without building a tree (tshark without -V, first pass of -2, tap only runs).
+  Only the header bytes needed to find each message boundary are read, no labels or prices are formatted.*/
+static int dissect_opra_no_tree(tvbuff_t *tvb, packet_info *pinfo, const opra_block *block, unsigned block_number, bool duplicate,
+    opra_block_summary *summary)
 {
-    int len = 2;
-    uint32_t data_length;
-    proto_tree_add_item_ret_uint(tree, hf_opra_msg_cat_C_data_length, tvb, offset, len, ENC_BIG_ENDIAN, &data_length);
-    offset += len;
+    opra_message_iter iter;
+    opra_message_iter_init(&iter, block);
+
+    /*the tap needs the message values and the first pass has to meet every instrument,
+      otherwise the boundaries are enough*/
+    opra_decode_status status;
+    const bool tapping = have_tap_listener(opra_tap);
+    const bool decode = tapping || !PINFO_FD_VISITED(pinfo);
+    const bool updates_book = decode && opra_block_updates_book(pinfo, block, duplicate);
+    opra_message msg;
+    for (;;){
+        opra_block_summary_note(summary, &iter);
+        if (!decode || opra_message_skipped(&iter)){
+            opra_summary_note_skipped(&iter, updates_book);
+            status = opra_walk_skip(&iter);
+        } else if (OPRA_DECODE_OK == (status = opra_walk_next(&iter, &msg))){
+            (void) opra_apply_message(pinfo, block, &msg, block_number, iter.index - 1, duplicate, updates_book, tapping);
+        }
 
-    if (0 < data_length){
-        len = (int) data_length;
-        proto_tree_add_item(tree, hf_opra_msg_cat_C_data_length, tvb, offset, len, ENC_BIG_ENDIAN);
-        offset += len;
+        if (OPRA_DECODE_UNKNOWN_CATEGORY == status){
+            int message_len;
+            expert_add_info(pinfo, NULL, &hf_opra_exp_unknown_category);
+            status = opra_walk_resync(&iter, &message_len);
+            if (OPRA_DECODE_OK == status)
+                expert_add_info(pinfo, NULL, &hf_opra_exp_unknown_length_guessed);
+        }
+        if (OPRA_DECODE_OK != status)
+            break;
+    }
+
+    if (OPRA_DECODE_TRUNCATED == status){
+        expert_add_info(pinfo, NULL, &hf_opra_exp_block_truncated);
+        return block->length;
+    }
+    if (OPRA_DECODE_UNKNOWN_CATEGORY == status){
+        /*no length fits the unknown message, same as the full decode the rest of the block can't be found*/
+        expert_add_info(pinfo, NULL, &hf_opra_exp_block_length_error);
+        return iter.offset + OPRA_MESSAGE_HEADER_SIZE;
+    }
+
+    int offset = iter.offset;
+
+    //if block was an odd number of bytes, there will be a block pad byte here
+    if (0 != offset % 2)
+        offset += 1;
+
+    int sz = tvb_reported_length(tvb);
+    if (0 != (sz - offset)){
+        expert_add_info(pinfo, NULL, &hf_opra_exp_block_length_error);
     }
 
-    /*return the new offset*/
     return offset;
 }
 
-static int dissect_opra_message_category_Y(tvbuff_t *tvb, int offset, packet_info *pinfo _U_, proto_tree *tree, void* data _U_)
+/*Add a first pass block to the summary, keyed by the line as opra_track_sequence() keys it*/
+static void opra_summary_note_block(const packet_info *pinfo, const opra_block *block, bool reset)
 {
-    int len = 5;
-    proto_tree_add_item(tree, hf_opra_msg_cat_Y_security_symbol, tvb, offset, len, ENC_NA | ENC_ASCII);
-    offset += len;
+    opra_summary_line_key key;
+    memset(&key, 0, sizeof(key));
+    if ((AT_NONE != pinfo->src.type) && (pinfo->src.len > 0) && (pinfo->src.len <= OPRA_SUMMARY_MAX_ADDRESS_SIZE)){
+        memcpy(key.src, pinfo->src.data, pinfo->src.len);
+        key.address_length = (uint8_t) pinfo->src.len;
+    }
+    key.session_indicator = block->hdr.session_indicator;
+    key.dst_port = (uint16_t) pinfo->destport;
 
-    len = 1;
-    proto_tree_add_item(tree, hf_opra_msg_cat_Y_reserved1, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    if (!opra_summary_add_block(opra_capture.summary, &key, block, reset)){
+        report_failure("Out of memory building the OPRA summary, no summary file will be written");
+        opra_state_free_summary();
+    }
+}
 
-    len = 1;
-    uint32_t denominator;
-    proto_tree_add_item_ret_uint(tree, hf_opra_msg_cat_Y_index_value_denominator_code, tvb, offset, len, ENC_BIG_ENDIAN, &denominator);
-    offset += len;
+/*Add a first pass message that moves the book to the summary.  opra_apply_message() calls it for every message
+  decoded, whether or not it is watched or tapped.*/
+static void opra_summary_note_message(const opra_message *msg)
+{
+    if ((NULL != opra_capture.summary) && !opra_summary_add_message(opra_capture.summary, msg)){
+        report_failure("Out of memory building the OPRA summary, no summary file will be written");
+        opra_state_free_summary();
+    }
+}
 
-    len = 4;
-    uint32_t price = tvb_get_uint32(tvb, offset, ENC_BIG_ENDIAN);
+/*The category preferences leave the next message undecoded.  Quotes and last sales are still decoded for the
+  summary, so what it holds doesn't depend on the preferences.*/
+static void opra_summary_note_skipped(const opra_message_iter *iter, bool updates_book)
+{
+    uint8_t message_category;
+    if ((NULL == opra_capture.summary) || !updates_book || !opra_message_iter_peek_category(iter, &message_category))
+        return;
+    if (('a' != message_category) && ('k' != message_category) && ('q' != message_category))
+        return;
 
-    static char tmp_buffer[ITEM_LABEL_LENGTH];
-    DisplayPrice(tmp_buffer, price, denominator);
-    proto_tree_add_string(tree, hf_opra_msg_cat_Y_index_value, tvb, offset, len, tmp_buffer);
-    offset += len;
+    opra_message msg;
+    if (OPRA_DECODE_OK == opra_decode_message(iter->block, iter->offset, &msg))
+        opra_summary_note_message(&msg);
+}
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_Y_reserved2, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+/*Work out where this block sits on its line.  Only runs the comparison on the first pass, later passes
+  return what the first pass stored with the frame.*/
+static const opra_sequence_info *opra_track_sequence(packet_info *pinfo, const opra_block *block, unsigned block_number)
+{
+    if (PINFO_FD_VISITED(pinfo))
+        return (const opra_sequence_info *) p_get_proto_data(wmem_file_scope(), pinfo, proto_opra, OPRA_PROTO_DATA_KEY(OPRA_PROTO_DATA_SEQUENCE, block_number));
+
+    if (opra_index_enabled())
+        opra_index_note_frame(pinfo);
+
+    const opra_block_header *hdr = &block->hdr;
+    opra_line_key key;
+    key.src = pinfo->src;
+    key.dst_port = pinfo->destport;
+    key.session_indicator = hdr->session_indicator;
+
+    opra_line_state *line = (opra_line_state *) wmem_map_lookup(opra_capture.lines, &key);
+    opra_sequence_info *info = wmem_new0(wmem_file_scope(), opra_sequence_info);
+    const uint32_t sequence_number = hdr->block_sequence_number;
+    const uint32_t next_sequence_number = sequence_number + hdr->messages_in_block;
+
+    if (NULL == line){
+        opra_line_key *new_key = wmem_new(wmem_file_scope(), opra_line_key);
+        *new_key = key;
+        copy_address_wmem(wmem_file_scope(), &new_key->src, &pinfo->src);
+        line = wmem_new0(wmem_file_scope(), opra_line_state);
+        wmem_map_insert(opra_capture.lines, new_key, line);
+    }
+    info->expected_sequence_number = line->next_sequence_number;
+    info->prev_block_frame = line->last_frame;
+
+    if (opra_block_has_message(block, 'H', OPRA_MSG_CAT_H_RESET_BLOCK_SEQUENCE_NUMBER)){
+        info->status = OPRA_SEQUENCE_RESET;
+        line->synchronized = false;
+    } else if (!line->synchronized){
+        info->status = OPRA_SEQUENCE_FIRST;
+        line->next_sequence_number = next_sequence_number;
+        line->synchronized = true;
+    } else if ('V' == hdr->retransmission_indicator){
+        info->status = OPRA_SEQUENCE_RETRANSMISSION;
+    } else if (sequence_number == line->next_sequence_number){
+        info->status = OPRA_SEQUENCE_IN_ORDER;
+        line->next_sequence_number = next_sequence_number;
+    } else if (sequence_number > line->next_sequence_number){
+        info->status = OPRA_SEQUENCE_GAP;
+        info->gap_size = sequence_number - line->next_sequence_number;
+        line->next_sequence_number = next_sequence_number;
+    } else {
+        info->status = OPRA_SEQUENCE_DUPLICATE;
+    }
+    line->last_frame = pinfo->num;
+    if (NULL != opra_capture.summary)
+        opra_summary_note_block(pinfo, block, OPRA_SEQUENCE_RESET == info->status);
+    if (opra_index_building)
+        opra_index_note_block(line, &key, info->status, hdr, pinfo->num);
+
+    p_add_proto_data(wmem_file_scope(), pinfo, proto_opra, OPRA_PROTO_DATA_KEY(OPRA_PROTO_DATA_SEQUENCE, block_number), info);
+    return info;
+}
 
-    return offset;
+/*Add the sequence tracking results.  tree and item may be NULL, the expert infos are still raised.*/
+static void dissect_opra_sequence(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, proto_item *item, const opra_sequence_info *info)
+{
+    proto_item *ti;
+
+    if (NULL == info)
+        return;
+
+    if ((OPRA_SEQUENCE_FIRST != info->status) && (OPRA_SEQUENCE_RESET != info->status)){
+        ti = proto_tree_add_uint(tree, hf_opra_expected_sequence_number, tvb, 0, 0, info->expected_sequence_number);
+        proto_item_set_generated(ti);
+    }
+    if (0 != info->prev_block_frame){
+        ti = proto_tree_add_uint(tree, hf_opra_prev_block_frame, tvb, 0, 0, info->prev_block_frame);
+        proto_item_set_generated(ti);
+    }
+
+    switch(info->status)
+    {
+        case OPRA_SEQUENCE_GAP:{
+            ti = proto_tree_add_uint(tree, hf_opra_gap_size, tvb, 0, 0, info->gap_size);
+            proto_item_set_generated(ti);
+            expert_add_info_format(pinfo, item, &hf_opra_exp_sequence_gap,
+                "Block sequence gap, %u messages missing (expected %u)", info->gap_size, info->expected_sequence_number);
+            break;
+        }
+        case OPRA_SEQUENCE_DUPLICATE:{
+            expert_add_info_format(pinfo, item, &hf_opra_exp_sequence_duplicate,
+                "Block sequence number already seen on this line (expected %u)", info->expected_sequence_number);
+            break;
+        }
+        case OPRA_SEQUENCE_RESET:{
+            expert_add_info(pinfo, item, &hf_opra_exp_sequence_reset);
+            break;
+        }
+        default:
+            break;
+    }
 }
 
-static int dissect_opra_message_category_a(tvbuff_t *tvb, int offset, packet_info *pinfo _U_, proto_tree *tree, void* data _U_)
+/*Queue one tap record for a decoded message.  Only the decode core's values are used, no tree is needed.*/
+static void opra_tap_message(packet_info *pinfo, const opra_block *block, const opra_message *msg, unsigned index, bool duplicate, const opra_instrument *instrument)
 {
-    int len = 5;
-    proto_tree_add_item(tree, hf_opra_msg_cat_a_security_symbol, tvb, offset, len, ENC_NA | ENC_ASCII);
-    offset += len;
+    opra_tap_info *info = wmem_new(pinfo->pool, opra_tap_info);
 
-    len = 1;
-    proto_tree_add_item(tree, hf_opra_msg_cat_a_reserved1, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    opra_tap_fill(info, block, msg, index);
+    info->port = (uint16_t) pinfo->destport;
+    info->duplicate = duplicate;
+    info->latency_ns = opra_latency_ns(pinfo, &block->hdr);
+    info->instrument_id = (NULL != instrument) ? instrument->id : 0;
 
-    len = 3;
-    proto_tree_add_item(tree, hf_opra_msg_cat_a_expiration_block, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    tap_queue_packet(opra_tap, pinfo, info);
+}
 
-    len = 1;
-    uint32_t denominator;
-    proto_tree_add_item_ret_uint(tree, hf_opra_msg_cat_a_strike_price_denominator_code, tvb, offset, len, ENC_BIG_ENDIAN, &denominator);
-    offset += len;
+/*Find the instrument of an a, d, k or q message.  Only the first pass adds instruments, so the IDs follow capture
+  order however the frames are revisited.  Returns NULL for messages without an instrument.*/
+static opra_instrument *opra_intern_instrument(packet_info *pinfo, const opra_message *msg)
+{
+    opra_instrument_key key;
+    if (!opra_message_instrument(msg, &key))
+        return NULL;
+
+    const uint32_t hash = opra_table_hash(&key, sizeof(key));
+    opra_instrument *instrument = (opra_instrument *) opra_table_find(&opra_capture.instruments, &key, hash);
+    if (PINFO_FD_VISITED(pinfo))
+        return instrument;
+
+    if (NULL == instrument){
+        instrument = (opra_instrument *) opra_arena_alloc(&opra_capture.arena, sizeof(opra_instrument));
+        if (NULL == instrument)
+            return NULL;
+        instrument->key = key;
+        instrument->id = opra_capture.instruments.count + 1;
+        (void) opra_expiration_decode(key.expiration_block, &instrument->expiration);
+        opra_book_history_init(&instrument->book);
+        if (!opra_table_insert(&opra_capture.instruments, instrument, hash))
+            return NULL;
+    }
+    if (opra_index_building)
+        opra_index_note_message(instrument, pinfo->num);
+    return instrument;
+}
 
-    len = 4;
-    uint32_t price = tvb_get_uint32(tvb, offset, ENC_BIG_ENDIAN);
+/*e.g. "AAPL 21 Mar 26 150 C".  The strike drops trailing zeros, so the same series reads the same from long and
+  short quotes.  Built once per instrument.*/
+static char *opra_format_instrument_name(wmem_allocator_t *scope, const opra_instrument_key *key)
+{
+    int symbol_length = OPRA_SECURITY_SYMBOL_SIZE;
+    while ((symbol_length > 0) && (' ' == key->security_symbol[symbol_length - 1]))
+        symbol_length--;
+
+    char strike[32];
+    const int64_t scale = opra_price_powers_of_ten[OPRA_PRICE_MAX_DECIMAL_PLACES];
+    int strike_length = snprintf(strike, sizeof(strike), "%" PRId64 ".%08" PRId64, key->strike_price / scale, key->strike_price % scale);
+    while ('0' == strike[strike_length - 1])
+        strike_length--;
+    if ('.' == strike[strike_length - 1])
+        strike_length--;
+    strike[strike_length] = '\0';
+
+    const opra_expiration_month *expiration_month = &opra_expiration_month_table[key->expiration_block[0]];
+    const char *month = "???";
+    char put_call = '?';
+    if (0 != expiration_month->month){
+        month = opra_expiration_months[expiration_month->month - 1];
+        put_call = (char) expiration_month->put_call;
+    }
 
-    static char tmp_buffer[ITEM_LABEL_LENGTH];
-    DisplayPrice(tmp_buffer, price, denominator);
-    proto_tree_add_string(tree, hf_opra_msg_cat_a_strike_price, tvb, offset, len, tmp_buffer);
-    offset += len;
+    return wmem_strdup_printf(scope, "%.*s %02u %s %02u %s %c",
+        symbol_length, key->security_symbol, key->expiration_block[1], month, key->expiration_block[2], strike, put_call);
+}
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_a_volume, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+static const char *opra_instrument_name(opra_instrument *instrument)
+{
+    if (NULL == instrument->name){
+        char *name = opra_format_instrument_name(NULL, &instrument->key);
+        const size_t size = strlen(name) + 1;
+        char *kept = (char *) opra_arena_alloc(&opra_capture.arena, size);
+        if (NULL == kept)
+            return name;
+        memcpy(kept, name, size);
+        wmem_free(NULL, name);
+        instrument->name = kept;
+        opra_capture.instrument_name_count++;
+        opra_capture.instrument_name_bytes += size;
+    }
+    return instrument->name;
+}
 
-    len = 1;
-    proto_tree_add_item_ret_uint(tree, hf_opra_msg_cat_a_premium_price_denominator_code, tvb, offset, len, ENC_BIG_ENDIAN, &denominator);
-    offset += len;
+static void dissect_opra_instrument(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, const opra_message *msg, opra_instrument *instrument)
+{
+    if (NULL == instrument)
+        return;
 
-    len = 4;
-    price = tvb_get_uint32(tvb, offset, ENC_BIG_ENDIAN);
-    DisplayPrice(tmp_buffer, price, denominator);
-    proto_tree_add_string(tree, hf_opra_msg_cat_a_premium_price, tvb, offset, len, tmp_buffer);
-    offset += len;
+    proto_item *ti = proto_tree_add_uint(tree, hf_opra_instrument_id, tvb, msg->offset, msg->length, instrument->id);
+    proto_item_set_generated(ti);
+    ti = proto_tree_add_string(tree, hf_opra_instrument, tvb, msg->offset, msg->length, opra_instrument_name(instrument));
+    proto_item_set_generated(ti);
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_a_trade_identifier, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    const opra_index_instrument *indexed = opra_index_lookup_instrument(instrument);
+    if (NULL == indexed)
+        return;
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_a_reserved2, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    uint32_t prev_frame, next_frame;
+    opra_index_adjacent_frames(&opra_index_mapped, indexed, pinfo->num, &prev_frame, &next_frame);
+    if (0 != prev_frame){
+        ti = proto_tree_add_uint(tree, hf_opra_instrument_prev_frame, tvb, 0, 0, prev_frame);
+        proto_item_set_generated(ti);
+    }
+    if (0 != next_frame){
+        ti = proto_tree_add_uint(tree, hf_opra_instrument_next_frame, tvb, 0, 0, next_frame);
+        proto_item_set_generated(ti);
+    }
+    ti = proto_tree_add_uint(tree, hf_opra_instrument_messages, tvb, 0, 0, indexed->message_count);
+    proto_item_set_generated(ti);
+}
 
-    /*return the new offset*/
-    return offset;
+/*true if the preferences leave the next message undecoded*/
+static inline bool opra_message_skipped(const opra_message_iter *iter)
+{
+    uint8_t message_category;
+    return opra_message_iter_peek_category(iter, &message_category) && opra_category_skipped[message_category];
 }
 
-static int dissect_opra_message_category_d(tvbuff_t *tvb, int offset, packet_info *pinfo _U_, proto_tree *tree, void* data _U_)
+/*Check the root of the next message against the watchlist straight from the block, before it's decoded.
+  Messages without a root never match.*/
+static bool opra_watchlist_root_matches(const opra_message_iter *iter)
 {
-    int len = 5;
-    proto_tree_add_item(tree, hf_opra_msg_cat_d_security_symbol, tvb, offset, len, ENC_NA | ENC_ASCII);
-    offset += len;
+    uint8_t message_category;
+    if (!opra_message_iter_peek_category(iter, &message_category))
+        return false;
 
-    len = 1;
-    proto_tree_add_item(tree, hf_opra_msg_cat_d_reserved, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    unsigned length;
+    switch(message_category)
+    {
+        case 'Y':
+        case 'a':
+        case 'd':
+        case 'f':
+        case 'k':
+            length = OPRA_SECURITY_SYMBOL_SIZE;
+            break;
+        case 'q':
+            length = OPRA_SHORT_SECURITY_SYMBOL_SIZE;
+            break;
+        default:
+            return false;
+    }
 
-    len = 3;
-    proto_tree_add_item(tree, hf_opra_msg_cat_d_expiration_block, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    const int symbol_offset = iter->offset + OPRA_MESSAGE_HEADER_SIZE;
+    if (symbol_offset + (int) length > iter->block->length)
+        return false;
+    return opra_watchlist_contains(opra_watchlist_root_key(iter->block->data + symbol_offset, length));
+}
 
-    len = 1;
-    proto_tree_add_item(tree, hf_opra_msg_cat_d_strike_price_denominator_code, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+/*The first pass applies quotes to the book in capture order.  The losing A/B copy repeats the winner's quotes
+  and retransmissions repeat old ones, so neither moves it.*/
+static bool opra_block_updates_book(const packet_info *pinfo, const opra_block *block, bool duplicate)
+{
+    return !PINFO_FD_VISITED(pinfo) && !duplicate && ('V' != block->hdr.retransmission_indicator);
+}
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_d_strike_price, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+/*apply a quote and record a row if the top of book moved*/
+static void opra_book_update(packet_info *pinfo, const opra_message *msg, unsigned block_number, unsigned index, opra_instrument *instrument)
+{
+    if ((NULL == instrument) || (('k' != msg->hdr.message_category) && ('q' != msg->hdr.message_category)))
+        return;
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_d_volume, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    if (!instrument->has_book){
+        opra_book_top_init(&instrument->top);
+        instrument->has_book = true;
+    }
+    if (!opra_book_apply(&instrument->top, msg, NULL))
+        return;
 
-    /*return the new offset*/
-    return offset;
+    opra_book_history *book = &instrument->book;
+    const size_t before = opra_book_history_bytes(book);
+    if (!opra_book_history_append(book, &opra_capture.book_chunk_pool, OPRA_BOOK_POSITION(pinfo->num, block_number, index), &instrument->top))
+        return;
+    opra_capture.book_bytes += opra_book_history_bytes(book) - before;
+    opra_lru_touch(&opra_capture.book_lru, &instrument->book_lru);
+    opra_book_enforce_limit(instrument);
 }
 
-static int dissect_opra_message_category_k(tvbuff_t *tvb, int offset, packet_info *pinfo _U_, proto_tree *tree, void* data _U_)
+/*Add the instrument's best bid and offer as they stood after this message.  Trades and open interest show
+  the book in force when they were sent.*/
+static void dissect_opra_book(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, const opra_message *msg, unsigned block_number, unsigned index,
+    opra_instrument *instrument)
 {
-    int len = 5;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_security_symbol, tvb, offset, len, ENC_NA | ENC_ASCII);
-    offset += len;
+    uint64_t position;
+    opra_book_top top;
 
-    len = 1;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_reserved, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    if ((NULL == instrument) || !instrument->has_book)
+        return;
 
-    len = 3;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_expiration_block, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    const opra_book_lookup lookup = opra_book_history_find(&instrument->book, OPRA_BOOK_POSITION(pinfo->num, block_number, index), &position, &top);
+    if (OPRA_BOOK_NOT_SET == lookup)
+        return;
 
-    len = 1;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_strike_price_denominator_code, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    proto_item *book_item;
+    proto_tree *book_tree = proto_tree_add_subtree(tree, tvb, msg->offset, msg->length, ett_opra_book, &book_item, "Top of Book");
+    proto_item_set_generated(book_item);
+    if (OPRA_BOOK_RELEASED == lookup){
+        proto_tree_add_expert(book_tree, pinfo, &hf_opra_exp_book_evicted, tvb, 0, 0);
+        return;
+    }
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_strike_price, tvb, offset, len, ENC_BIG_ENDIAN);
+    proto_item *ti = proto_tree_add_uint(book_tree, hf_opra_book_frame, tvb, 0, 0, OPRA_BOOK_POSITION_FRAME(position));
+    proto_item_set_generated(ti);
+
+    const double scale = opra_price_powers_of_ten[OPRA_PRICE_MAX_DECIMAL_PLACES];
+    if (0 != top.bid.participant_id){
+        ti = proto_tree_add_uint(book_tree, hf_opra_book_bid_participant_id, tvb, 0, 0, top.bid.participant_id);
+        proto_item_set_generated(ti);
+        ti = proto_tree_add_double(book_tree, hf_opra_book_bid_price, tvb, 0, 0, top.bid.price / scale);
+        proto_item_set_generated(ti);
+        ti = proto_tree_add_uint(book_tree, hf_opra_book_bid_size, tvb, 0, 0, top.bid.size);
+        proto_item_set_generated(ti);
+    }
+
+    if (0 != top.offer.participant_id){
+        ti = proto_tree_add_uint(book_tree, hf_opra_book_offer_participant_id, tvb, 0, 0, top.offer.participant_id);
+        proto_item_set_generated(ti);
+        ti = proto_tree_add_double(book_tree, hf_opra_book_offer_price, tvb, 0, 0, top.offer.price / scale);
+        proto_item_set_generated(ti);
+        ti = proto_tree_add_uint(book_tree, hf_opra_book_offer_size, tvb, 0, 0, top.offer.size);
+        proto_item_set_generated(ti);
+    }
+
+    /*a shown history is as good as new, keep it over ones nobody looks at*/
+    if (opra_lru_linked(&instrument->book_lru))
+        opra_lru_touch(&opra_capture.book_lru, &instrument->book_lru);
+}
+
+/*Frame capture time less the block timestamp, corrected by the clock offset preference*/
+static int64_t opra_latency_ns(const packet_info *pinfo, const opra_block_header *hdr)
+{
+    const int64_t captured_ns = (int64_t) pinfo->abs_ts.secs * INT64_C(1000000000) + pinfo->abs_ts.nsecs;
+    const int64_t sent_ns = (int64_t) hdr->timestamp_secs * INT64_C(1000000000) + hdr->timestamp_nsecs;
+    return captured_ns - sent_ns - opra_clock_offset_ns;
+}
+
+/*Decide which feed's copy of the block arrived first.  Like the sequence tracking, only the first pass compares,
+  later passes use the result stored with the frame.  Returns NULL for ports that aren't in an A/B pair.*/
+static const opra_arbitration_info *opra_arbitrate(packet_info *pinfo, const opra_block *block, unsigned block_number)
+{
+    if (PINFO_FD_VISITED(pinfo))
+        return (const opra_arbitration_info *) p_get_proto_data(wmem_file_scope(), pinfo, proto_opra, OPRA_PROTO_DATA_KEY(OPRA_PROTO_DATA_ARBITRATION, block_number));
+
+    const unsigned lookup = opra_feed_port_lookup[pinfo->destport & 0xFFFF];
+    if (0 == lookup)
+        return NULL;
+
+    opra_arbitration_info *info = wmem_new0(wmem_file_scope(), opra_arbitration_info);
+    info->pair = (uint16_t) ((lookup - 1) >> 1);
+    info->feed = ((lookup - 1) & 1) ? 'B' : 'A';
+    info->frame = pinfo->num;
+    info->arrival = pinfo->abs_ts;
+    p_add_proto_data(wmem_file_scope(), pinfo, proto_opra, OPRA_PROTO_DATA_KEY(OPRA_PROTO_DATA_ARBITRATION, block_number), info);
+
+    /*retransmissions reuse sequence numbers, they aren't a feed copy*/
+    if ('V' == block->hdr.retransmission_indicator)
+        return info;
+
+    opra_arbitration_key key;
+    key.block_sequence_number = block->hdr.block_sequence_number;
+    key.pair = info->pair;
+    key.session_indicator = block->hdr.session_indicator;
+    key.reserved = 0;
+
+    const uint32_t hash = opra_table_hash(&key, sizeof(key));
+    const opra_arbitration_entry *found = (const opra_arbitration_entry *) opra_table_find(&opra_capture.arbitration, &key, hash);
+    if (NULL == found){
+        if (NULL == opra_capture.arbitration_window)
+            opra_capture.arbitration_window = g_new0(opra_arbitration_entry, OPRA_ARBITRATION_WINDOW);
+
+        opra_arbitration_entry *entry = &opra_capture.arbitration_window[opra_capture.arbitration_next];
+        opra_capture.arbitration_next = (opra_capture.arbitration_next + 1) % OPRA_ARBITRATION_WINDOW;
+        if (NULL != entry->info){
+            opra_table_remove(&opra_capture.arbitration, &entry->key, opra_table_hash(&entry->key, sizeof(entry->key)));
+            opra_capture.arbitration_evicted++;
+        }
+        entry->key = key;
+        entry->info = info;
+        if (!opra_table_insert(&opra_capture.arbitration, entry, hash))
+            entry->info = NULL;
+        return info;
+    }
+    opra_arbitration_info *first = found->info;
+
+    /*a second copy from the same feed is for the sequence tracking to report*/
+    if ((first->feed == info->feed) || (0 != first->other_frame))
+        return info;
+
+    /*the winner's result is only read back on later passes, so it can still be filled in*/
+    nstime_t delta;
+    if ('A' == first->feed)
+        nstime_delta(&delta, &pinfo->abs_ts, &first->arrival);
+    else
+        nstime_delta(&delta, &first->arrival, &pinfo->abs_ts);
+
+    info->duplicate = true;
+    info->other_frame = first->frame;
+    info->delta_ns = delta.secs * INT64_C(1000000000) + delta.nsecs;
+    first->other_frame = pinfo->num;
+    first->delta_ns = info->delta_ns;
+    return info;
+}
+
+static void dissect_opra_arbitration(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree, const opra_arbitration_info *info)
+{
+    proto_item *ti;
+
+    if (NULL == info)
+        return;
+
+    ti = proto_tree_add_uint(tree, hf_opra_feed, tvb, 0, 0, info->feed);
+    proto_item_set_generated(ti);
+    if ((info->pair < num_opra_feed_pairs) && (NULL != opra_feed_pairs[info->pair].line_name)){
+        ti = proto_tree_add_string(tree, hf_opra_feed_line, tvb, 0, 0, opra_feed_pairs[info->pair].line_name);
+        proto_item_set_generated(ti);
+    }
+
+    if (0 == info->other_frame)
+        return;
+
+    ti = proto_tree_add_boolean(tree, hf_opra_feed_duplicate, tvb, 0, 0, info->duplicate);
+    proto_item_set_generated(ti);
+    ti = proto_tree_add_uint(tree, hf_opra_feed_other_frame, tvb, 0, 0, info->other_frame);
+    proto_item_set_generated(ti);
+    ti = proto_tree_add_int64(tree, hf_opra_feed_delta, tvb, 0, 0, info->delta_ns);
+    proto_item_set_generated(ti);
+
+    if (info->duplicate)
+        expert_add_info_format(pinfo, ti, &hf_opra_exp_feed_duplicate, "Block already received on the other feed in frame %u", info->other_frame);
+}
+
+static int dissect_opra_message_header(tvbuff_t *tvb, int offset, proto_tree *tree, const opra_message *msg)
+{
+    int len = 1;
+    proto_tree_add_uint(tree, hf_opra_msg_hdr_participant_id, tvb, offset, len, msg->hdr.participant_id);
     offset += len;
 
     len = 1;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_premium_price_denominator_code, tvb, offset, len, ENC_BIG_ENDIAN);
+    /*message category is a uint8_t containing a single char, per the spec*/
+    const uint8_t message_category = msg->hdr.message_category;
+    proto_tree_add_uint(tree, hf_opra_msg_hdr_message_category, tvb, offset, len, message_category);
     offset += len;
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_bid_price, tvb, offset, len, ENC_BIG_ENDIAN);
+    len = 1;
+    const uint8_t message_type = msg->hdr.message_type;
+    const char *description = GetMessageTypeDescription(message_category, message_type);
+    proto_tree_add_string_format_value(tree, hf_opra_msg_hdr_message_type, tvb, offset, 1, description,
+        "(%c), (%c), %s", message_category, message_type, description);
     offset += len;
 
-    len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_bid_size, tvb, offset, len, ENC_BIG_ENDIAN);
+    len = 1;
+    const uint8_t message_indicator = msg->hdr.message_indicator;
+    if ((message_category == 'q') || (message_category == 'k')){
+        const char *str = hf_opra_message_indicators[message_indicator];
+        if (NULL == str)
+            str = "unknown indicator";
+        proto_tree_add_string(tree, hf_opra_msg_hdr_message_indicator, tvb, offset, len, str);
+    } else {
+        if (message_indicator == ' ') {
+            proto_tree_add_string(tree, hf_opra_msg_hdr_message_indicator, tvb, offset, len, "N/A");
+        } else {
+            proto_tree_add_string(tree, hf_opra_msg_hdr_message_indicator, tvb, offset, len, "invalid");
+        }
+    }
     offset += len;
 
     len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_offer_price, tvb, offset, len, ENC_BIG_ENDIAN);
+    proto_tree_add_uint(tree, hf_opra_msg_hdr_transaction_id, tvb, offset, len, msg->hdr.transaction_id);
     offset += len;
 
     len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_k_offer_size, tvb, offset, len, ENC_BIG_ENDIAN);
+    proto_tree_add_uint(tree, hf_opra_msg_hdr_participant_reference_number, tvb, offset, len, msg->hdr.participant_reference_number);
     offset += len;
 
-    /*return the new offset*/
     return offset;
 }
 
-static int dissect_opra_message_category_q(tvbuff_t *tvb, int offset, packet_info *pinfo _U_, proto_tree *tree, void* data _U_)
+/*administrative messages are the only variable length category, so they don't have a field layout*/
+static int dissect_opra_message_category_C(tvbuff_t *tvb, int offset, proto_tree *tree, const opra_message *msg)
 {
-    int len = 4;
-    proto_tree_add_item(tree, hf_opra_msg_cat_q_security_symbol, tvb, offset, len, ENC_NA | ENC_ASCII);
+    int len = 2;
+    const uint32_t data_length = msg->body.C.data_length;
+    proto_tree_add_uint(tree, hf_opra_msg_cat_C_data_length, tvb, offset, len, data_length);
     offset += len;
 
-    len = 3;
-    proto_tree_add_item(tree, hf_opra_msg_cat_q_expiration_block, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    if (0 < data_length){
+        len = (int) data_length;
+        proto_tree_add_item(tree, hf_opra_msg_cat_C_data, tvb, offset, len, ENC_ASCII);
+        offset += len;
+    }
 
-    len = 2;
-    proto_tree_add_item(tree, hf_opra_msg_cat_q_strike_price, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    /*return the new offset*/
+    return offset;
+}
 
-    len = 2;
-    proto_tree_add_item(tree, hf_opra_msg_cat_q_bid_price, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+/*Add the numeric forms of a price, so display filters can compare prices without string matching.
+  Nothing is added for a bad denominator code, the price field's label already reports it.*/
+static void dissect_opra_normalized_price(tvbuff_t *tvb, int offset, int len, proto_tree *tree, const opra_field_layout *field, uint32_t value, uint32_t denominator, bool negative)
+{
+    double price;
+    int64_t scaled;
+    proto_item *ti;
 
-    len = 2;
-    proto_tree_add_item(tree, hf_opra_msg_cat_q_bid_size, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    if (!opra_price_to_double(value, (uint8_t) denominator, &price) || !opra_price_scaled(value, (uint8_t) denominator, &scaled))
+        return;
+    if (negative){
+        price = -price;
+        scaled = -scaled;
+    }
 
-    len = 2;
-    proto_tree_add_item(tree, hf_opra_msg_cat_q_offer_price, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+    ti = proto_tree_add_double(tree, *field->hf_price_value, tvb, offset, len, price);
+    proto_item_set_generated(ti);
+    ti = proto_tree_add_int64(tree, *field->hf_price_e8, tvb, offset, len, scaled);
+    proto_item_set_generated(ti);
+}
 
-    len = 2;
-    proto_tree_add_item(tree, hf_opra_msg_cat_q_offer_size, tvb, offset, len, ENC_BIG_ENDIAN);
-    offset += len;
+/*Month with put or call, day and year of the expiration block, the date, and days from the block's UTC date to it,
+  0 on the day of expiry.  Instruments hold their expiration decoded, messages of no instrument are decoded here.*/
+static void dissect_opra_expiration(tvbuff_t *tvb, int offset, proto_item *block_item, const uint8_t *p, const opra_block *block,
+    const opra_instrument *instrument)
+{
+    opra_expiration decoded;
+    const opra_expiration *expiration = &decoded;
+    if (NULL != instrument)
+        expiration = &instrument->expiration;
+    else
+        (void) opra_expiration_decode(p, &decoded);
+
+    proto_tree *tree = proto_item_add_subtree(block_item, ett_opra_expiration);
+    if (0 != expiration->month){
+        proto_tree_add_uint(tree, hf_opra_expiration_month, tvb, offset, 1, expiration->month);
+        proto_tree_add_uint(tree, hf_opra_expiration_put_call, tvb, offset, 1, expiration->put_call);
+    }
+    proto_tree_add_uint(tree, hf_opra_expiration_day, tvb, offset + 1, 1, expiration->day);
+    proto_tree_add_uint(tree, hf_opra_expiration_year, tvb, offset + 2, 1, expiration->year);
+    if (!expiration->valid)
+        return;
 
-    /*return the new offset*/
-    return offset;
+    nstime_t date;
+    date.secs = (time_t) expiration->epoch_day * 86400;
+    date.nsecs = 0;
+    proto_tree_add_time(tree, hf_opra_expiration_date, tvb, offset, OPRA_EXPIRATION_BLOCK_SIZE, &date);
+    if (NULL != block){
+        const int32_t block_day = (int32_t) (block->hdr.timestamp_secs / 86400);
+        proto_item *ti = proto_tree_add_int(tree, hf_opra_expiration_days, tvb, offset, OPRA_EXPIRATION_BLOCK_SIZE, expiration->epoch_day - block_day);
+        proto_item_set_generated(ti);
+    }
 }
 
-static int dissect_opra_quote_appendage(tvbuff_t *tvb _U_, int offset _U_, packet_info *pinfo _U_, proto_tree *tree _U_, void* data _U_, uint32_t message_indicator)
+/*Walk a field layout, reading the values straight from the raw message bytes.
+  The bounds were already checked by the decode core.*/
+static int dissect_opra_message_body(tvbuff_t *tvb, int offset, proto_tree *tree, const uint8_t *p, const opra_message_layout *layout,
+    const opra_block *block, const opra_instrument *instrument)
 {
-    /*check for bid and offer appendages*/
-    bool bid_appendage = false;
-    if (NULL != strchr(hf_opra_msg_indicator_best_bid_appendages, message_indicator))
-        bid_appendage = true;
+    uint32_t denominator = 0;
+    uint32_t next_denominator = 0;  /*0 until an OPRA_FIELD_NEXT_DENOMINATOR, code 0 is never valid*/
 
-    bool offer_appendage = false;
-    if (NULL != strchr(hf_opra_msg_indicator_best_offer_appendages, message_indicator))
-        offer_appendage = true;
-
-    if (bid_appendage){
-        int len  = 1;
-        proto_tree_add_item(tree, hf_opra_msg_bid_appendage_participant_id, tvb, offset, len, ENC_NA | ENC_ASCII);
-        offset += len;
+    for (unsigned i = 0; i < layout->field_count; i++)
+    {
+        const opra_field_layout *field = &layout->fields[i];
+        const int len = field->length;
 
-        len  = 1;
-        proto_tree_add_item(tree, hf_opra_msg_bid_appendage_denominator_code, tvb, offset, len, ENC_NA | ENC_ASCII);
-        offset += len;
+        uint32_t value = 0;
+        for (int j = 0; j < len; j++)
+            value = (value << 8) | p[j];
 
-        len  = 4;
-        proto_tree_add_item(tree, hf_opra_msg_bid_appendage_price, tvb, offset, len, ENC_BIG_ENDIAN);
-        offset += len;
+        uint32_t price_denominator = field->implied_denominator ? field->implied_denominator : denominator;
+        if ((0 != next_denominator) && (NULL != field->hf_price_value)){
+            price_denominator = next_denominator;
+            next_denominator = 0;
+        }
+        bool negative = false;
 
-        len  = 4;
-        proto_tree_add_item(tree, hf_opra_msg_bid_appendage_size, tvb, offset, len, ENC_BIG_ENDIAN);
-        offset += len;
-    }
+        switch(field->kind)
+        {
+            case OPRA_FIELD_UINT:{
+                proto_tree_add_uint(tree, *field->hf, tvb, offset, len, value);
+                break;
+            }
+            case OPRA_FIELD_TEXT:{
+                proto_tree_add_item(tree, *field->hf, tvb, offset, len, ENC_NA | ENC_ASCII);
+                break;
+            }
+            case OPRA_FIELD_BYTES:{
+                proto_tree_add_item(tree, *field->hf, tvb, offset, len, ENC_BIG_ENDIAN);
+                break;
+            }
+            case OPRA_FIELD_EXPIRATION:{
+                proto_item *ti = proto_tree_add_item(tree, *field->hf, tvb, offset, len, ENC_NA);
+                dissect_opra_expiration(tvb, offset, ti, p, block, instrument);
+                break;
+            }
+            case OPRA_FIELD_DENOMINATOR:{
+                denominator = value;
+                proto_tree_add_uint(tree, *field->hf, tvb, offset, len, value);
+                break;
+            }
+            case OPRA_FIELD_NEXT_DENOMINATOR:{
+                next_denominator = value;
+                proto_tree_add_uint(tree, *field->hf, tvb, offset, len, value);
+                break;
+            }
+            case OPRA_FIELD_PRICE:{
+                char label[ITEM_LABEL_LENGTH];
+                DisplayPrice(label, value, price_denominator);
+                proto_tree_add_uint_format_value(tree, *field->hf, tvb, offset, len, value, "%s", label);
+                break;
+            }
+            case OPRA_FIELD_SIGNED_PRICE:{
+                char label[ITEM_LABEL_LENGTH];
+                const int32_t signed_value = (int32_t) value;
+                DisplaySignedPrice(label, signed_value, price_denominator);
+                proto_tree_add_int_format_value(tree, *field->hf, tvb, offset, len, signed_value, "%s", label);
+                negative = (signed_value < 0);
+                if (negative)
+                    value = (uint32_t) 0 - value;
+                break;
+            }
+            case OPRA_FIELD_PRICE_TEXT:{
+                char label[ITEM_LABEL_LENGTH];
+                DisplayPrice(label, value, price_denominator);
+                proto_tree_add_string(tree, *field->hf, tvb, offset, len, label);
+                break;
+            }
+        }
 
-    if (offer_appendage){
-        int len  = 1;
-        proto_tree_add_item(tree, hf_opra_msg_offer_appendage_participant_id, tvb, offset, len, ENC_NA | ENC_ASCII);
-        offset += len;
+        if (field->hf_price_value)
+            dissect_opra_normalized_price(tvb, offset, len, tree, field, value, price_denominator, negative);
 
-        len  = 1;
-        proto_tree_add_item(tree, hf_opra_msg_offer_appendage_denominator_code, tvb, offset, len, ENC_NA | ENC_ASCII);
         offset += len;
+        p += len;
+    }
 
-        len  = 4;
-        proto_tree_add_item(tree, hf_opra_msg_offer_appendage_price, tvb, offset, len, ENC_BIG_ENDIAN);
-        offset += len;
+    /*return the new offset*/
+    return offset;
+}
 
-        len  = 4;
-        proto_tree_add_item(tree, hf_opra_msg_offer_appendage_size, tvb, offset, len, ENC_BIG_ENDIAN);
-        offset += len;
+static int dissect_opra_quote_appendages(tvbuff_t *tvb, int offset, proto_tree *tree, const opra_message *msg)
+{
+    /*bid and offer appendages were identified from the message indicator by the decode core*/
+    const uint8_t *p = msg->appendages;
+    opra_appendage_iter iter;
+    opra_appendage_iter_init(&iter, msg);
+
+    opra_quote_appendage appendage;
+    while (opra_appendage_iter_next(&iter, &appendage)){
+        const opra_message_layout *layout = (OPRA_APPENDAGE_BID == appendage.side) ? &opra_bid_appendage_layout : &opra_offer_appendage_layout;
+        offset = dissect_opra_message_body(tvb, offset, tree, p, layout, NULL, NULL);
+        p += OPRA_QUOTE_APPENDAGE_SIZE;
     }
 
     /*return the new offset*/
@@ -1,6 +1,7 @@
 /* packet-opra.h
  *
-*
+ * Definitions shared with consumers of the "opra" tap
+ *
  * Wireshark - Network traffic analyzer
  * By Gerald Combs <gerald@wireshark.org>
  * Copyright 1998 Gerald Combs
@@ -8,6 +9,73 @@
  * SPDX-License-Identifier: GPL-2.0-or-later
  */
 
+#ifndef __PACKET_OPRA_H__
+#define __PACKET_OPRA_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*longest security symbol, 5 characters, plus the terminator.  Short quotes carry 4.*/
+#define OPRA_TAP_SYMBOL_SIZE 6
+#define OPRA_TAP_EXPIRATION_BLOCK_SIZE 3
+
+/*which of the optional values in an opra_tap_info are set*/
+#define OPRA_TAP_HAS_STRIKE         0x01
+#define OPRA_TAP_HAS_PRICE          0x02    /*last sale premium, end of day last price or underlying index value*/
+#define OPRA_TAP_HAS_VOLUME         0x04    /*last sale or end of day volume, or open interest*/
+#define OPRA_TAP_HAS_BID            0x08
+#define OPRA_TAP_HAS_OFFER          0x10
+#define OPRA_TAP_HAS_BEST_BID       0x20    /*best bid appendage*/
+#define OPRA_TAP_HAS_BEST_OFFER     0x40    /*best offer appendage*/
+
+/*One record is queued to the "opra" tap for every decoded message.  Records are filled from the decode core's
+  values by opra_tap_fill() in opra-tap.h, whether or not a tree is being built, and live in packet scope.
+  Prices are signed integers scaled to 8 decimal places, see opra_price_scaled() in opra-price.h.*/
+typedef struct _opra_tap_info {
+    /*block*/
+    uint32_t block_sequence_number;
+    uint32_t timestamp_secs;
+    uint32_t timestamp_nsecs;
+    uint16_t port;                          /*destination port, identifies the line*/
+    uint8_t session_indicator;
+    uint8_t retransmission_indicator;
+    uint8_t messages_in_block;
+    uint8_t message_index;                  /*position within the block, from 0*/
+    uint16_t message_offset;                /*of the message header within the block*/
+    uint16_t message_length;                /*header, body and any appendages*/
+    bool duplicate;                         /*losing copy of an A/B feed pair*/
+    int64_t latency_ns;                     /*capture time less block timestamp, as opra.latency*/
+
+    /*message header*/
+    uint8_t participant_id;
+    uint8_t message_category;
+    uint8_t message_type;
+    uint8_t message_indicator;
+    uint32_t transaction_id;
+    uint32_t instrument_id;                 /*opra.instrument_id, 0 for messages without an instrument*/
+
+    /*instrument, empty for messages without one*/
+    char security_symbol[OPRA_TAP_SYMBOL_SIZE];
+    uint8_t expiration_block[OPRA_TAP_EXPIRATION_BLOCK_SIZE];
+
+    uint8_t flags;                          /*OPRA_TAP_HAS_...*/
+    int64_t strike_price;
+    int64_t price;
+    uint32_t volume;
+    int64_t bid_price;
+    uint32_t bid_size;
+    int64_t offer_price;
+    uint32_t offer_size;
+
+    uint8_t best_bid_participant_id;
+    int64_t best_bid_price;
+    uint32_t best_bid_size;
+    uint8_t best_offer_participant_id;
+    int64_t best_offer_price;
+    uint32_t best_offer_size;
+} opra_tap_info;
+
+#endif /* __PACKET_OPRA_H__ */
 
 /*
  * Editor modelines  -  https://www.wireshark.org/tools/modelines.html
@@ -20,6 +88,4 @@
  *
  * vi: set shiftwidth=4 tabstop=8 expandtab:
  * :indentSize=4:tabSize=8:noTabs=true:
-#define MSG_HDR_SZ          8
-#define CMD_HDR_SZ          4
-*/
+ */
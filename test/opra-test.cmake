@@ -0,0 +1,225 @@
+# opra-test.cmake
+#
+# Regression tests of the OPRA plugin against the golden records of the
+# checked-in capture, run by CTest as "cmake -P".  The records are the
+# "opra" tap's, one line per message, see opra_tap_format().
+#
+#   -DMODE=dump   opra_dump over the capture must print the golden records.
+#   -DMODE=tshark tshark -z opra,records must tap the golden records with
+#                 and without a tree, over two passes, with skip and decode
+#                 categories and with a watchlist.  Skipped categories are
+#                 left out of the expected records, nothing else may change.
+#                 With -DOPRA_DUMP= the opra.summary_file tshark writes under
+#                 the same preferences must also be opra_dump's, byte for byte.
+#   -DMODE=summary The summaries of a capture split in two by time, and of one
+#                 split by line, made by opra_dump and merged, must be the
+#                 summary of the whole capture byte for byte.  The capture of
+#                 two lines comes from -DOPRA_BENCH=.
+#
+# Wireshark - Network traffic analyzer
+# By Gerald Combs <gerald@wireshark.org>
+# Copyright 1998 Gerald Combs
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+foreach(var MODE CAPTURE GOLDEN WORK_DIR)
+	if(NOT DEFINED ${var})
+		message(FATAL_ERROR "opra-test.cmake needs -D${var}=")
+	endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(STRINGS "${GOLDEN}" golden_lines REGEX "^frame=")
+list(LENGTH golden_lines golden_count)
+if(golden_count EQUAL 0)
+	message(FATAL_ERROR "${GOLDEN} has no records")
+endif()
+
+# Fail unless the records file holds exactly the expected lines, in order
+function(opra_compare name records_file expected_lines)
+	set(records_lines)
+	if(EXISTS "${records_file}")
+		file(STRINGS "${records_file}" records_lines REGEX "^frame=")
+	endif()
+	list(LENGTH expected_lines expected_count)
+	if(NOT records_lines STREQUAL expected_lines)
+		list(LENGTH records_lines records_count)
+		string(REPLACE ";" "\n" expected_text "${expected_lines}")
+		file(WRITE "${WORK_DIR}/${name}.expected" "${expected_text}\n")
+		message(FATAL_ERROR "${name}: ${records_count} records, ${expected_count} expected, "
+			"compare ${records_file} with ${WORK_DIR}/${name}.expected")
+	endif()
+	message(STATUS "${name}: ${expected_count} records match")
+endfunction()
+
+# Fail unless the summary files are the same bytes
+function(opra_compare_summary name summary_file expected_file)
+	execute_process(
+		COMMAND "${CMAKE_COMMAND}" -E compare_files "${summary_file}" "${expected_file}"
+		RESULT_VARIABLE result
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${name}: ${summary_file} differs from ${expected_file}")
+	endif()
+	message(STATUS "${name}: summaries match")
+endfunction()
+
+# Run opra_dump, failing if it does.  Its output goes to WORK_DIR/name.out
+function(opra_dump name)
+	execute_process(
+		COMMAND "${OPRA_DUMP}" ${ARGN}
+		OUTPUT_FILE "${WORK_DIR}/${name}.out"
+		ERROR_VARIABLE errors
+		RESULT_VARIABLE result
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${name}: opra_dump failed: ${result}\n${errors}")
+	endif()
+endfunction()
+
+if(MODE STREQUAL "dump")
+	if(NOT DEFINED OPRA_DUMP)
+		message(FATAL_ERROR "opra-test.cmake needs -DOPRA_DUMP=")
+	endif()
+	execute_process(
+		COMMAND "${OPRA_DUMP}" "${CAPTURE}"
+		OUTPUT_FILE "${WORK_DIR}/dump.records"
+		RESULT_VARIABLE result
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "opra_dump failed: ${result}")
+	endif()
+	opra_compare(dump "${WORK_DIR}/dump.records" "${golden_lines}")
+
+elseif(MODE STREQUAL "tshark")
+	if(NOT DEFINED TSHARK)
+		message(FATAL_ERROR "opra-test.cmake needs -DTSHARK=")
+	endif()
+
+	# No personal preferences, only the options given below
+	file(MAKE_DIRECTORY "${WORK_DIR}/config")
+	set(ENV{WIRESHARK_CONFIG_DIR} "${WORK_DIR}/config")
+
+	# the same records less the skipped categories
+	set(no_k_Y_lines ${golden_lines})
+	list(FILTER no_k_Y_lines EXCLUDE REGEX " cat=[kY] ")
+	set(q_lines ${golden_lines})
+	list(FILTER q_lines INCLUDE REGEX " cat=q ")
+
+	# a root that is in the capture, so the watchlist splits it
+	string(REGEX MATCH " sym=([A-Z]+) " watched "${golden_lines}")
+	set(watched "${CMAKE_MATCH_1}")
+
+	function(opra_tshark name expected_lines)
+		execute_process(
+			COMMAND "${TSHARK}" -n -r "${CAPTURE}" -d udp.port==54321,opra
+				-z "opra,records,${WORK_DIR}/${name}.records" ${ARGN}
+			OUTPUT_FILE "${WORK_DIR}/${name}.out"
+			ERROR_VARIABLE errors
+			RESULT_VARIABLE result
+		)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "${name}: tshark failed: ${result}\n${errors}")
+		endif()
+		opra_compare(${name} "${WORK_DIR}/${name}.records" "${expected_lines}")
+	endfunction()
+
+	# the first pass's summary, which no preference below may change
+	function(opra_tshark_summary name)
+		execute_process(
+			COMMAND "${TSHARK}" -n -r "${CAPTURE}" -d udp.port==54321,opra
+				-o "opra.summary_file:${WORK_DIR}/${name}.summary" ${ARGN}
+			OUTPUT_FILE "${WORK_DIR}/${name}.out"
+			ERROR_VARIABLE errors
+			RESULT_VARIABLE result
+		)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "${name}: tshark failed: ${result}\n${errors}")
+		endif()
+		opra_compare_summary(${name} "${WORK_DIR}/${name}.summary" "${WORK_DIR}/dump.summary")
+	endfunction()
+
+	# dissect_opra_no_tree() against the tree path, with a filter's tree and over two passes
+	opra_tshark(no_tree "${golden_lines}" -q)
+	opra_tshark(tree "${golden_lines}" -V)
+	opra_tshark(filter "${golden_lines}" -q -Y opra)
+	opra_tshark(two_pass "${golden_lines}" -2 -V)
+	opra_tshark(two_pass_no_tree "${golden_lines}" -2 -q)
+
+	# skipping by length must not move the other messages
+	opra_tshark(skip_no_tree "${no_k_Y_lines}" -q -o opra.skip_categories:kY)
+	opra_tshark(skip_tree "${no_k_Y_lines}" -V -o opra.skip_categories:kY)
+	opra_tshark(decode_no_tree "${q_lines}" -q -o opra.decode_categories:q)
+	opra_tshark(decode_tree "${q_lines}" -V -o opra.decode_categories:q)
+
+	# unwatched messages get no subtree but are still tapped
+	opra_tshark(watchlist_tree "${golden_lines}" -V -o "opra.watchlist:${watched}")
+	opra_tshark(watchlist_no_tree "${golden_lines}" -q -o "opra.watchlist:${watched}")
+
+	if(DEFINED OPRA_DUMP)
+		opra_dump(dump --summary "${WORK_DIR}/dump.summary" "${CAPTURE}")
+		opra_tshark_summary(summary_no_tree -q)
+		opra_tshark_summary(summary_tree -V)
+		opra_tshark_summary(summary_skip -q -o opra.skip_categories:kY)
+		opra_tshark_summary(summary_decode -V -o opra.decode_categories:q)
+		opra_tshark_summary(summary_watchlist -V -o "opra.watchlist:${watched}")
+	endif()
+
+elseif(MODE STREQUAL "summary")
+	foreach(var OPRA_DUMP OPRA_BENCH)
+		if(NOT DEFINED ${var})
+			message(FATAL_ERROR "opra-test.cmake needs -D${var}=")
+		endif()
+	endforeach()
+
+	# The checked-in capture, one line, split by time
+	opra_dump(whole --summary "${WORK_DIR}/whole.summary" "${CAPTURE}")
+	opra_compare(whole "${WORK_DIR}/whole.out" "${golden_lines}")
+	opra_dump(early --frames 1-20 --summary "${WORK_DIR}/early.summary" "${CAPTURE}")
+	opra_dump(late --frames 21-40 --summary "${WORK_DIR}/late.summary" "${CAPTURE}")
+	opra_dump(by_time --summary "${WORK_DIR}/by_time.summary" --merge "${WORK_DIR}/early.summary" "${WORK_DIR}/late.summary")
+	opra_compare_summary(by_time "${WORK_DIR}/by_time.summary" "${WORK_DIR}/whole.summary")
+
+	# The same traffic dealt to two lines on ports 54321 and 54322, split by time across both and by line
+	execute_process(
+		COMMAND "${OPRA_BENCH}" --blocks 40 --fill 30 --appendages 50 --instruments 20
+			--mix q=60,k=15,a=8,Y=4,d=3,f=3,C=4,H=3 --repeat 1 --lines 2 --pcap "${WORK_DIR}/lines.pcap"
+		OUTPUT_QUIET
+		RESULT_VARIABLE result
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "opra_bench failed: ${result}")
+	endif()
+	set(lines_capture "${WORK_DIR}/lines.pcap")
+	opra_dump(lines --port 54321-54322 --summary "${WORK_DIR}/lines.summary" "${lines_capture}")
+	opra_dump(lines_early --port 54321-54322 --frames 1-13 --summary "${WORK_DIR}/lines_early.summary" "${lines_capture}")
+	opra_dump(lines_late --port 54321-54322 --frames 14-40 --summary "${WORK_DIR}/lines_late.summary" "${lines_capture}")
+	opra_dump(lines_by_time --summary "${WORK_DIR}/lines_by_time.summary"
+		--merge "${WORK_DIR}/lines_early.summary" "${WORK_DIR}/lines_late.summary")
+	opra_compare_summary(lines_by_time "${WORK_DIR}/lines_by_time.summary" "${WORK_DIR}/lines.summary")
+	opra_dump(line_a --port 54321 --summary "${WORK_DIR}/line_a.summary" "${lines_capture}")
+	opra_dump(line_b --port 54322 --summary "${WORK_DIR}/line_b.summary" "${lines_capture}")
+	opra_dump(by_line --summary "${WORK_DIR}/by_line.summary" --merge "${WORK_DIR}/line_a.summary" "${WORK_DIR}/line_b.summary")
+	opra_compare_summary(by_line "${WORK_DIR}/by_line.summary" "${WORK_DIR}/lines.summary")
+	opra_dump(by_line_reversed --summary "${WORK_DIR}/by_line_reversed.summary"
+		--merge "${WORK_DIR}/line_b.summary" "${WORK_DIR}/line_a.summary")
+	opra_compare_summary(by_line_reversed "${WORK_DIR}/by_line_reversed.summary" "${WORK_DIR}/lines.summary")
+
+else()
+	message(FATAL_ERROR "opra-test.cmake: unknown MODE ${MODE}")
+endif()
+
+#
+# Editor modelines  -  https://www.wireshark.org/tools/modelines.html
+#
+# Local variables:
+# c-basic-offset: 8
+# tab-width: 8
+# indent-tabs-mode: t
+# End:
+#
+# vi: set shiftwidth=8 tabstop=8 noexpandtab:
+# :indentSize=8:tabSize=8:noTabs=false:
+#